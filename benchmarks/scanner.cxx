@@ -0,0 +1,92 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include <silk/language/classify.h>
+#include <silk/language/scanner.h>
+
+// Scanning throughput on a large generated source, the
+// size in megabytes can be passed as the first argument
+
+// Lengths of names, indentation & comments vary like
+// they do in real sources so branches are not predictable
+auto generate(std::size_t size) -> std::string {
+  auto rng    = std::mt19937{42};
+  auto length = [&](int from, int to) {
+    return std::uniform_int_distribution<int>{from, to}(rng);
+  };
+
+  auto name = [&] {
+    auto result = std::string{};
+    for (auto i = length(1, 24); i > 0; i--) result += 'a' + length(0, 25);
+    return result;
+  };
+
+  auto source = std::string{};
+  source.reserve(size + 1024);
+
+  while (source.size() < size) {
+    source += "# " + std::string(length(8, 72), 'c') + "\n";
+    source += "fun " + name() + "(" + name() + " :: int) {\n";
+
+    for (auto i = length(1, 8); i > 0; i--) {
+      source += std::string(length(2, 12), ' ') + "let " + name() + " := ";
+      source += name() + " * " + std::to_string(length(0, 99999)) + ";\n";
+    }
+
+    source += std::string(length(2, 12), ' ') + "return '";
+    source += std::string(length(0, 48), 's') + "';\n}\n\n";
+  }
+
+  return source;
+}
+
+template <class Fn>
+auto measure(std::string_view name, std::size_t bytes, Fn &&fn) -> void {
+  const auto start = std::chrono::steady_clock::now();
+  const auto count = fn();
+  const auto end   = std::chrono::steady_clock::now();
+
+  const auto secs = std::chrono::duration<double>(end - start).count();
+  std::cout << name << ": " << (bytes / secs) / (1024 * 1024) << " MB/s ("
+            << count << ")" << std::endl;
+}
+
+int main(int argc, char **argv) {
+  const auto megabytes = argc > 1 ? std::atoi(argv[1]) : 64;
+  const auto source    = generate((std::size_t)megabytes * 1024 * 1024);
+
+  // Whitespace & names are skipped like the scanner does,
+  // other characters are stepped over one at a time
+  for (auto &classify : silk::classifiers()) {
+    measure(classify.name, source.size(), [&] {
+      auto it    = source.data();
+      auto end   = source.data() + source.size();
+      auto words = std::size_t{0};
+
+      while (it < end) {
+        it = classify.whitespace(it, end);
+        if (it == end) break;
+
+        auto word = classify.alphanumeric(it, end);
+        words += word != it;
+        it = word != it ? word : it + 1;
+      }
+
+      return words;
+    });
+  }
+
+  measure("scanner", source.size(), [&] {
+    auto scanner = silk::Scanner{source};
+    auto tokens  = std::size_t{0};
+
+    while (scanner.scan().kind != silk::TokenKind::TOK_END) tokens++;
+
+    return tokens;
+  });
+
+  return 0;
+}
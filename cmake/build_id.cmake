@@ -0,0 +1,38 @@
+# Writes OUTPUT, a header defining SILK_BUILD_ID as a hash of every
+# source under ROOT and of the TOOLCHAIN building them. The header is
+# only rewritten when the hash changes, it is touched otherwise so the
+# sources are not hashed again until one of them changes.
+#
+#   cmake -DROOT=. -DTOOLCHAIN=GNU-13 -DOUTPUT=build_id.h -P build_id.cmake
+#
+
+file(GLOB_RECURSE SOURCES
+  LIST_DIRECTORIES false
+  RELATIVE "${ROOT}"
+  "${ROOT}/source/*"
+  "${ROOT}/include/*"
+  "${ROOT}/cmake/*"
+)
+
+list(APPEND SOURCES "CMakeLists.txt")
+list(SORT SOURCES)
+
+set(HASHES "${TOOLCHAIN}")
+
+foreach(SOURCE ${SOURCES})
+  file(SHA256 "${ROOT}/${SOURCE}" HASH)
+  string(APPEND HASHES "\n${SOURCE} ${HASH}")
+endforeach()
+
+string(SHA256 BUILD_ID "${HASHES}")
+set(CONTENT "#define SILK_BUILD_ID \"${BUILD_ID}\"\n")
+
+if(EXISTS "${OUTPUT}")
+  file(READ "${OUTPUT}" PREVIOUS)
+endif()
+
+if(NOT CONTENT STREQUAL PREVIOUS)
+  file(WRITE "${OUTPUT}" "${CONTENT}")
+else()
+  file(TOUCH_NOCREATE "${OUTPUT}")
+endif()
@@ -0,0 +1,32 @@
+#ifndef MOTHVM_BUILTINS_H
+#define MOTHVM_BUILTINS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include <moth/ffi.h>
+
+// Libraries with this name are linked into the VM, their
+// functions are resolved without going through dlopen/dlsym
+#define MOTH_BUILTIN_LIBRARY "stdsilk"
+
+// Tag of the ffi pointer standing in for a builtin library
+#define MOTH_BUILTIN_TAG 0x1001
+
+typedef struct {
+  const char* name;
+  FFIFunction fun;
+} Builtin;
+
+bool        builtin_library(const char* name);
+FFIFunction builtin_lookup(const char* name);
+const char* builtin_name(FFIFunction fun);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
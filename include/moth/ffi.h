@@ -17,6 +17,16 @@
 
 #define MOTH_FFI_FUN_BODY MOTH_FFI_FUN_DEF
 
+// Libraries written against this header export this marker,
+// their functions are always bound with the FFIFunction
+// convention. Functions from other libraries are plain C
+// functions, called through a typed trampoline.
+#define MOTH_FFI_LIBRARY        MOTH_FFI_API const int moth_ffi_library = 1
+#define MOTH_FFI_LIBRARY_MARKER "moth_ffi_library"
+
+// Tag of the ffi pointer holding an open library
+#define MOTH_FFI_DLL_TAG 0x1000
+
 #define MOTH_FFI_DELETER_FUN(FN_NAME) void FN_NAME(uint32_t tag, void *ptr)
 
 #define MOTH_FFI_FUN_ARITY(ARITY)                                              \
@@ -66,16 +76,58 @@ typedef struct {
   FFIDeleter del;
 } ObjectFFIPointer;
 
+// Typed extern functions are described by a signature string,
+// the first character is the return type, the rest are the
+// parameter types:
+//
+//   'v' void (return only)
+//   'i' int    -> int64_t
+//   'r' real   -> double
+//   's' str    -> const char *
+//   'p' ffiptr -> void *
+//
+#define MOTH_FFI_MAX_TYPED_ARGS 3
+
+typedef union {
+  int64_t i;
+  double  r;
+  void *  p;
+} FFIArg;
+
+typedef void (*FFINative)(void);
+typedef FFIArg (*FFITrampoline)(FFINative, FFIArg *);
+
+typedef struct {
+  Object        obj;
+  FFINative     fun;
+  FFITrampoline tramp;
+  uint8_t       argc;
+  char          sig[MOTH_FFI_MAX_TYPED_ARGS + 2];
+  const char *  src; // constant signature it was loaded with, if any
+} ObjectFFINative;
+
 #define IS_OBJ_FFI_FCT(val)                                                    \
   (IS_OBJ(val) && val.as.object->type == O_FFI_FUNCTION)
 #define IS_OBJ_FFI_PTR(val)                                                    \
   (IS_OBJ(val) && val.as.object->type == O_FFI_POINTER)
+#define IS_OBJ_FFI_NTV(val)                                                    \
+  (IS_OBJ(val) && val.as.object->type == O_FFI_NATIVE)
 
 #define OBJ_FFI_FUN(obj) ((ObjectFFIFunction *)obj)
 #define OBJ_FFI_PTR(obj) ((ObjectFFIPointer *)obj)
+#define OBJ_FFI_NTV(obj) ((ObjectFFINative *)obj)
 
 ObjectFFIFunction *obj_ffi_fun_new(FFIFunction fun);
 ObjectFFIPointer * obj_ffi_ptr_new(uint32_t tag, void *ptr, FFIDeleter del);
 void               obj_ffi_ptr_del(ObjectFFIPointer *ffi_ptr);
+ObjectFFINative *  obj_ffi_ntv_new(FFINative fun, const char *sig);
+
+FFIResult ffi_ntv_call(ObjectFFINative *ntv, Value *argv, uint8_t argc,
+                       Value *ret);
+Value     ffi_ntv_call_typed(ObjectFFINative *ntv, Value *argv);
+
+void *ffi_dll_open(const char *name);
+void *ffi_dll_symbol(void *dll, const char *name);
+bool  ffi_dll_is_library(void *dll);
 
 #endif
@@ -8,11 +8,29 @@ extern "C" {
 
 #include <moth/program.h>
 
+// When the checksum of an executable is checked
+typedef enum {
+  VERIFY_ALWAYS, // on every read
+  VERIFY_CACHED, // unless the file is unchanged since any process verified it
+  VERIFY_NEVER,  // trusted executables are never checked
+} Verify;
+
 uint32_t checksum(Program*);
+uint32_t crc32c(uint32_t, const uint8_t*, size_t);
+
+uint8_t* map_image(const char*, size_t*);
+void     unmap_image(uint8_t*, size_t);
 
 void read_file(const char*, Program*, const char**);
+void read_file_verify(const char*, Program*, Verify, const char**);
 
 void write_file(const char*, Program*, const char**);
+void write_file_version(const char*, Program*, uint16_t, const char**);
+
+// The executable is serialized in memory and written at once,
+// images from write_memory are freed with release(img, len)
+void     write_fd(int, Program*, const char**);
+uint8_t* write_memory(Program*, size_t*, const char**);
 
 #ifdef __cplusplus
 }
@@ -5,19 +5,22 @@
 extern "C" {
 #endif
 
+#include <moth/env.h>
 #include <moth/object.h>
 #include <moth/stack.h>
 
 typedef struct {
-  size_t   len;
-  size_t   cap;
-  Stack*   stk;
-  Object** objs;
+  size_t       len;
+  size_t       cap;
+  Stack*       stk;
+  Environment* env;
+  Object**     objs;
 } GarbageCollector;
 
-void init_gc(GarbageCollector* gc, Stack* stk);
+void init_gc(GarbageCollector* gc, Stack* stk, Environment* env);
 void gc_collect(GarbageCollector* gc);
 void gc_register(GarbageCollector* gc, Object* obj);
+void gc_reserve(GarbageCollector* gc, size_t n);
 void free_gc(GarbageCollector* gc);
 
 #ifdef __cplusplus
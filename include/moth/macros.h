@@ -11,14 +11,38 @@ extern "C" {
 
 #define NEXT *(vm->ip++)
 
+// Operands are big endian, the instruction pointer is moved past
+// them first so every byte is read in a well defined order
 #define ARG1 (NEXT)
-#define ARG2 ((ARG1 << 8) | NEXT)
-#define ARG3 ((ARG2 << 8) | NEXT)
-#define ARG4 ((ARG3 << 8) | NEXT)
+#define ARG2 (vm->ip += 2, OPERAND_BYTE(2, 1) | OPERAND_BYTE(1, 0))
+#define ARG3                                                                   \
+  (vm->ip += 3, OPERAND_BYTE(3, 2) | OPERAND_BYTE(2, 1) | OPERAND_BYTE(1, 0))
+#define ARG4                                                                   \
+  (vm->ip += 4, OPERAND_BYTE(4, 3) | OPERAND_BYTE(3, 2) | OPERAND_BYTE(2, 1) | \
+                  OPERAND_BYTE(1, 0))
+
+// The byte N bytes behind the instruction pointer, as the Ith
+// least significant byte of an operand
+#define OPERAND_BYTE(N, I) ((uint32_t)vm->ip[-(N)] << (8 * (I)))
 
 #define RODATA(INDEX) (vm->prg->rod.arr[INDEX])
 
-#define JUMP(OFFSET) (vm->ip += OFFSET)
+// The offset is read before the instruction pointer is moved,
+// jumps land relative to the end of the instruction
+#define JUMP(OFFSET)                                                           \
+  do {                                                                         \
+    int64_t offset_ = (OFFSET);                                                \
+    vm->ip += offset_;                                                         \
+  } while (false)
+
+// Wordcode is decoded a whole instruction at a time, the
+// instruction pointer always sits on a word boundary
+#define WORD() (vm->ip += 4, LOAD_WORD(vm->ip - 4))
+
+#define WORD_OP(W)  ((W)&0xff)
+#define WORD_ARG(W) ((W) >> 8)
+
+#define WORD_OPERAND_MAX 0xffffff
 
 #define SETERR(ERROR_CODE) vm->st = ERROR_CODE;
 
@@ -84,14 +108,23 @@ extern "C" {
 #ifdef __WIN32
   #define IS_BIG_ENDIAN  0
   #define SWAP_BYTES     _byteswap_uint64
+  #define SWAP_WORD      _byteswap_ulong
   #define PATH_SEPARATOR '\\'
 #else
   #include <byteswap.h>
+  #include <endian.h>
   #define IS_BIG_ENDIAN  __BYTE_ORDER == __BIG_ENDIAN
   #define SWAP_BYTES     bswap_64
+  #define SWAP_WORD      bswap_32
   #define PATH_SEPARATOR '/'
 #endif
 
+// Words of wordcode are little endian, on little endian
+// machines they are loaded with a single aligned read
+#define LOAD_WORD(AT)                                                          \
+  ((IS_BIG_ENDIAN) ? SWAP_WORD(*(const uint32_t *)(AT))                        \
+                   : *(const uint32_t *)(AT))
+
 #define MIN(a, b) (((a) < (b)) ? (a) : (b))
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
 
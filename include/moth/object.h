@@ -20,6 +20,7 @@ typedef enum {
   O_HEAPVAL      = 17,
   O_FFI_FUNCTION = 19,
   O_FFI_POINTER  = 23,
+  O_FFI_NATIVE   = 29,
 } ObjType;
 
 typedef struct Object {
@@ -59,9 +60,11 @@ typedef struct {
 } ObjectDictionary;
 
 typedef struct {
-  Object  obj;
-  size_t  len;
-  uint8_t bytes[];
+  Object   obj;
+  size_t   len;
+  uint8_t *bytes; // follows the object, or is inside a mapped image
+  uint32_t arity; // arguments the body reads, set by the verifier
+  uint32_t depth; // most values the body pushes, set by the verifier
 } ObjectFunction;
 
 typedef struct {
@@ -121,13 +124,21 @@ ObjectDictionary *obj_dct_new();
 ObjectDictionary *obj_dct_from_raw(Value *keys, Value *vals, size_t len);
 ObjectDictionary *obj_dct_with_cap(size_t n);
 void              obj_dct_insert(ObjectDictionary *obj, Value key, Value value);
+size_t            obj_dct_insert_hashed(ObjectDictionary *obj, Value key,
+                                        uint32_t hash, Value value);
 bool              obj_dct_has_key(ObjectDictionary *obj, Value key);
 Value             obj_dct_get(ObjectDictionary *obj, Value key);
+size_t            obj_dct_find(ObjectDictionary *obj, Value key);
+size_t            obj_dct_find_hashed(ObjectDictionary *obj, Value key,
+                                      uint32_t hash);
 Value             obj_dct_delete(ObjectDictionary *obj, Value key);
 ObjectArray *     obj_dct_keys(ObjectDictionary *obj);
 ObjectArray *     obj_dct_values(ObjectDictionary *obj);
 void              obj_dct_merge(ObjectDictionary *obj, ObjectDictionary *with);
 
+ObjectFunction *obj_fct_with_len(size_t len);
+ObjectFunction *obj_fct_from_image(uint8_t *bytes, size_t len);
+
 ObjectClosure *obj_clj_from_fct(ObjectFunction *fct);
 
 ObjectHeapval *obj_hpv_promote(Value val);
@@ -16,11 +16,15 @@ typedef enum {
   // tldr:
   // VM_DLL [SYM] : load dll, stack is [dll]
   // VM_FFN [SYM] : load fun from dll, stack is [dll, ffifun]
-  // VM_ASN [SYM] : assign to symbol, stack is [dll], repeat until no more funs
+  // VM_DEF [SYM] : define symbol, stack is [dll], repeat until no more funs
   // VM_POP       : remove dll from stack
+  //
+  // typed functions push their signature string first:
+  // VM_VAL [SIG] : stack is [dll, sig]
+  // VM_FFT [SYM] : load typed fun from dll, stack is [dll, ffifun]
 
-  VM_DLL, // open a dynamic lib
-  VM_FFN, // load a function from the dyn lib
+  VM_DLL, // open a dynamic lib (4 bytes)
+  VM_FFN, // load a function from the dyn lib (4 bytes)
 
   VM_POP, // pop
   VM_PSH, // push value from stack to top (2 bytes)
@@ -94,6 +98,45 @@ typedef enum {
   VM_LT,  // less than
   VM_GTE, // greater than equal
   VM_LTE, // less than equal
+
+  VM_SQT, // square root
+  VM_FLR, // floor
+  VM_ABS, // absolute value
+  VM_SIN, // sine
+  VM_COS, // cosine
+  VM_EXP, // natural exponential
+  VM_LOG, // natural logarithm
+  VM_MIN, // minimum of two
+  VM_MAX, // maximum of two
+
+  // VM_INV [ARGC] [KEY] [CACHE] : call the function found at
+  // the constant key (4 bytes) of the dictionary at the top of
+  // the stack, the cache (2 bytes) remembers where it was found
+  VM_INV, // invoke a method
+
+  // VM_IDK [KEY] [CACHE] : index with a constant key (4 bytes),
+  // the cache (2 bytes) remembers where the key was found
+  VM_IDK, // indexing with a constant key
+  VM_IAK, // index assign with a constant key
+
+  // Programs can also be encoded as wordcode, every instruction
+  // is a little endian 32 bit word holding the opcode in its low
+  // byte & the first operand in the other three. Operands that
+  // don't fit are extended by a VM_EXT word in front holding
+  // their high byte. Instructions with more operands are
+  // followed by a word for each of the others. Only the first
+  // of the 1 to 4 byte variants is used, jumps still count bytes.
+  VM_EXT, // extend the operand of the next word
+
+  VM_FFT, // load a typed function from the dyn lib (4 bytes)
+
+  // VM_NTV [ARGC] [SIG] : call the function at the top of the
+  // stack, compiled against the typed function loaded by VM_FFT
+  // with the constant signature SIG (4 bytes). The compiler only
+  // emits it for arguments known to have the signature's types,
+  // so they are passed on unchecked. Other functions, and typed
+  // ones loaded with a different signature, are called like VM_CAL.
+  VM_NTV, // call a typed function
 } OpCode;
 
 #ifdef __cplusplus
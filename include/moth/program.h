@@ -5,23 +5,44 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include <moth/ffi.h>
 #include <moth/rodata.h>
 #include <moth/symtable.h>
 
 typedef struct {
-  uint32_t cap;
-  uint32_t len;
-  Rodata   rod;
-  Symtable stb;
-  uint8_t* bytes;
+  uint32_t slot; // dictionary slot the key was last found in
+} InlineCache;
+
+typedef struct {
+  uint32_t     cap;
+  uint32_t     len;
+  Rodata       rod;
+  Symtable     stb;
+  uint8_t*     bytes;
+  bool         wcd; // instructions are wordcode, see opcode.h
+  uint8_t*     img; // mapped executable, if loaded from a file
+  size_t       iml; // size of the mapping
+  FFIFunction* ntv; // builtin bound to each symbol, if any
+  uint32_t*    rdh; // hash of each read only value
+  uint32_t     ntl; // symbols bound in ntv when it was last linked
+  uint32_t     rdl; // values hashed in rdh when it was last linked
+  uint32_t     icl; // inline cache count
+  InlineCache* ics; // inline caches, indexed by call site
+  bool         vfd; // instructions were verified since the last change
+  uint32_t     msd; // max stack depth of any code, set by the verifier
 } Program;
 
 void     init_program(Program*, uint32_t, uint32_t, uint32_t);
 void     write_byte(Program*, uint8_t);
+void     write_word(Program*, uint32_t);
 uint32_t write_rodata(Program*, Value);
 uint32_t write_symtable(Program*, Symbol);
+void     link_program(Program*);
+void     reserve_caches(Program*, uint32_t);
 void     free_program(Program*);
 
 #ifdef __cplusplus
@@ -5,6 +5,7 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stddef.h>
 
 #include <moth/value.h>
@@ -13,6 +14,7 @@ typedef struct {
   uint32_t len;
   uint32_t cap;
   Value*   arr;
+  bool     brw; // strings are borrowed, not owned
 } Rodata;
 
 void init_rodata(Rodata*, uint32_t);
@@ -0,0 +1,22 @@
+#ifndef MOTHVM_SNAPSHOT_H
+#define MOTHVM_SNAPSHOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <moth/program.h>
+#include <moth/vm.h>
+
+// A snapshot holds the globals of a VM stopped at the top level,
+// the values on its stack and every object reachable from them.
+// It is only valid for the program the VM was running, restored
+// VMs continue from where the snapshot was taken with vm_resume.
+void write_snapshot(const char*, VM*, const char**);
+void read_snapshot(const char*, VM*, Program*, const char**);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
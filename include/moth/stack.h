@@ -5,6 +5,7 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stddef.h>
 
 #include <moth/value.h>
@@ -35,6 +36,7 @@ void  stk_push(Stack *stk, Value);
 Value stk_get(Stack *stk, size_t i);
 void  stk_set(Stack *stk, size_t i, Value);
 
+bool     stk_room(Stack *stk, size_t values);
 Frame *  stk_frame(Stack *stk);
 void     stk_invoke(Stack *stk, uint8_t *ra, uint8_t argc);
 uint8_t *stk_return(Stack *stk);
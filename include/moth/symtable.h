@@ -5,6 +5,7 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -14,6 +15,7 @@ typedef struct {
   uint32_t len;
   uint32_t cap;
   Symbol*  arr;
+  bool     brw; // strings are borrowed, not owned
 } Symtable;
 
 void init_symtable(Symtable*, uint32_t);
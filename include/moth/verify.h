@@ -0,0 +1,22 @@
+#ifndef MOTHVM_VERIFY_H
+#define MOTHVM_VERIFY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include <moth/program.h>
+
+// Checks the instructions of the program & of every function in
+// its read only data: operands, jump targets, indices & the stack
+// depth along every path. Verified code runs without any checks,
+// only calls check the arity & stack room computed here.
+bool verify_program(Program*, const char**);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -18,6 +18,9 @@ typedef enum {
   STATUS_UNDEFN,
   STATUS_NOTFUN,
   STATUS_BRKPNT,
+  STATUS_FFIERR,
+  STATUS_STKOVF, // calls nested too deep
+  STATUS_INVBYT, // instructions failed verification
 } VMStatus;
 
 typedef struct {
@@ -31,6 +34,7 @@ typedef struct {
 
 void init_vm(VM *);
 void vm_run(VM *, Program *);
+void vm_resume(VM *);
 void free_vm(VM *);
 
 #ifdef __cplusplus
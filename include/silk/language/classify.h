@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+namespace silk {
+
+/// Character classes the scanner skips over in bulk, every
+/// function returns the first character in [begin, end) that
+/// is not part of the class (or end). Classes follow the C
+/// locale, like `std::isspace` and `std::isalnum`.
+struct Classifier {
+  using SkipFN = const char *(*)(const char *begin, const char *end);
+
+  std::string_view name;
+  SkipFN           whitespace;
+  SkipFN           alphanumeric;
+};
+
+/// The classifier that scans sources fastest on this CPU, chosen once
+auto classifier() noexcept -> const Classifier &;
+
+/// Every classifier this CPU supports, scalar first
+auto classifiers() -> std::vector<Classifier>;
+
+} // namespace silk
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <silk/language/syntax_tree.h>
+
+namespace silk {
+
+/// Functions of the `std/math` module which targets can lower to
+/// a single instruction and the optimizer can evaluate when all
+/// of their arguments are literals.
+enum class Intrinsic {
+  SQRT,
+  FLOOR,
+  ABS,
+  SIN,
+  COS,
+  EXP,
+  LOG,
+  MIN,
+  MAX,
+};
+
+/// Number of arguments an intrinsic takes
+auto intrinsic_arity(Intrinsic) -> std::size_t;
+
+/// Keeps track of the intrinsics visible in a module, those
+/// brought in by `use 'std/math'` and not shadowed by one of the
+/// module's own top level declarations, nor by a parameter or local
+/// of the scopes around the call.
+class Intrinsics {
+private:
+  std::unordered_map<std::string_view, Intrinsic> _visible = {};
+
+  // Names bound in the open scopes, and where each scope starts
+  std::vector<std::string_view> _locals = {};
+  std::vector<std::size_t>      _scopes = {};
+
+  // Inside `std/math` itself every intrinsic is visible
+  bool _math_module = false;
+
+  auto declare(const st::ModuleDeclaration &) -> void;
+  auto import(const st::ModuleImport &) -> void;
+  auto shadow(std::string_view) -> void;
+
+public:
+  static constexpr auto MODULE = std::string_view{"std/math"};
+
+  /// Find the intrinsics visible anywhere in a module before any of
+  /// it is visited, its declarations may come after their uses
+  auto scan(const std::vector<st::NodePtr> &tree) -> void;
+
+  /// Names bound in an open scope shadow intrinsics until it closes,
+  /// names bound outside of every scope were already found by `scan`
+  auto enter() -> void;
+  auto leave() -> void;
+  auto bind(std::string_view) -> void;
+  auto bind(const st::TypedFields &) -> void;
+
+  /// The intrinsic called by the expression, if any
+  auto lookup(const st::ExpressionCall &) const -> std::optional<Intrinsic>;
+};
+
+} // namespace silk
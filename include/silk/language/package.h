@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <istream>
+#include <memory>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -17,20 +19,53 @@ using std_str_map = std::unordered_map<std::string, T>;
 
 /// A single unparsed source file in a package tree.
 struct Source {
-  std::string   path;
-  std::ifstream source;
+  std::string                        path;
+  std::ifstream                      source;
+  std::shared_ptr<const std::string> content = {}; //< See `read_source`
+};
+
+struct Module;
+
+/// Which modules of a package import which, by path. Imports may be
+/// cyclic, the order of modules breaks cycles where it finds them.
+class ModuleGraph {
+private:
+  std_str_map<std::vector<std::string>> _imports;
+
+public:
+  auto add(const std::string &module, const std::string &import) -> void;
+  auto imports(const std::string &module) const
+    -> const std::vector<std::string> &;
+
+  /// Stable sort of `modules`, each after the modules it imports
+  auto sort(std::vector<Module *> &modules) const -> void;
 };
 
 /// Multiple source files make up one package source as a unit.
 struct PackageSource {
   Source              main;
   std_str_map<Source> sources;
+  ModuleGraph         graph = {};
+};
+
+/// Hashes identifying a module across builds, the interface covers
+/// the top level declarations other modules can see
+struct Fingerprint {
+  std::uint64_t source    = 0;
+  std::uint64_t interface = 0;
+  std::uint64_t key       = 0; //< Source and imported interfaces together
 };
 
 /// A single parsed source file in a package tree.
 struct Module {
-  std::string                            path;
-  std::vector<std::unique_ptr<st::Node>> tree;
+  std::string                path;
+  std::unique_ptr<st::Arena> arena; //< Outlives the tree, nodes live in it
+  std::vector<st::NodePtr>   tree;
+
+  Fingerprint fingerprint = {};
+
+  /// Output of an earlier build reused as is, the tree is left empty
+  std::shared_ptr<const std::string> artifact = {};
 
   Module(const Module &) = delete;
   Module(Module &&)      = default;
@@ -40,8 +75,19 @@ struct Module {
 struct Package {
   Module              main;
   std_str_map<Module> modules;
+  ModuleGraph         graph = {};
 };
 
+/// Read the whole stream of the source into memory the first time,
+/// later calls return the same buffer instead of reading it again
+auto read_source(Source &) -> std::shared_ptr<const std::string>;
+
+/// The main source first, then the imported sources by path
+auto ordered_sources(PackageSource &) -> std::vector<Source *>;
+
+/// The main module first, then the imported modules by path
+auto ordered_modules(Package &) -> std::vector<Module *>;
+
 /// User friendly token kind string
 auto token_kind_string(TokenKind) -> std::string_view;
 
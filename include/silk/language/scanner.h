@@ -1,36 +1,74 @@
 #pragma once
 
-#include <unordered_map>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
 
+#include <silk/language/classify.h>
 #include <silk/language/token.h>
 
 namespace silk {
 
+/// Scans a contiguous source buffer, the lexemes of tokens are
+/// views into the buffer and stay valid as long as the scanner
+/// (or a copy of it) is alive.
 class Scanner {
 private:
-  Location      _location;
-  std::istream &_input;
+  std::shared_ptr<const void> _storage;
+  std::string_view            _source;
 
-  static const std::unordered_map<std::string_view, TokenKind> keywords;
+  std::size_t _start;      //< start of the token being scanned
+  std::size_t _current;    //< next character to be scanned
+  std::size_t _mark;       //< how far lines have been counted
+  std::size_t _line_start; //< offset of the current line
+  Location    _location;
+
+  Scanner(std::shared_ptr<const void> storage, std::string_view source) :
+      _storage(std::move(storage)),
+      _source(source),
+      _start(0),
+      _current(0),
+      _mark(0),
+      _line_start(0),
+      _location({1, 0}) {
+  }
 
   auto peek() const noexcept -> int;
   auto advance() noexcept -> int;
+  auto skip(Classifier::SkipFN) noexcept -> void;
+  auto lexeme() const noexcept -> std::string_view;
+  auto locate() noexcept -> Location;
   auto compound(char, TokenKind, TokenKind) noexcept -> Token;
 
   auto scan_comment() noexcept -> Token;
   auto scan_char() noexcept -> Token;
   auto scan_string() noexcept -> Token;
-  auto scan_number(int) noexcept -> Token;
-  auto scan_identifier(int) -> std::string;
+  auto scan_number() noexcept -> Token;
+  auto scan_identifier() noexcept -> std::string_view;
 
-  auto make_token(TokenKind) const noexcept -> Token;
-  auto make_token(TokenKind, std::string) const noexcept -> Token;
+  auto make_token(TokenKind) noexcept -> Token;
+  auto make_token(TokenKind, std::string_view) noexcept -> Token;
 
 public:
-  Scanner(std::istream &input) : _location({1, 0}), _input(input) {
+  /// Scan a buffer owned by the caller, it must outlive the tokens
+  Scanner(std::string_view source) : Scanner(nullptr, source) {
+  }
+
+  /// Scan a shared buffer, the scanner keeps it alive
+  Scanner(std::shared_ptr<const std::string> buffer) :
+      Scanner(buffer, *buffer) {
   }
 
+  /// Scan the rest of a stream, it is read into memory first
+  Scanner(std::istream &input);
+
+  /// Scan a memory mapped file, empty or unmappable files
+  /// are left to the stream constructor
+  static auto map(const std::string &path) -> std::optional<Scanner>;
+
   auto scan() noexcept -> Token;
 };
 
-} // namespace silk
\ No newline at end of file
+} // namespace silk
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
+#include <new>
 #include <numeric>
 #include <string>
 #include <variant>
@@ -14,8 +16,30 @@ namespace st {
 
 struct Node;
 
-/// Typing information
-using Typing = std::nullptr_t;
+/// Nodes are owned by the arena of their module, deleting a
+/// node only destroys it, its memory goes away with the arena
+struct NodeDeleter {
+  auto operator()(Node *) const noexcept -> void;
+};
+
+using NodePtr = std::unique_ptr<Node, NodeDeleter>;
+
+/// Typing information, for now only the name of the type
+/// as written in the source (e.g. `int`, `ffiptr`), the
+/// name is empty if no typing was given.
+struct Typing {
+  std::string name = {};
+
+  Typing(std::nullptr_t = nullptr) {
+  }
+
+  Typing(std::string name) : name(std::move(name)) {
+  }
+
+  explicit operator bool() const {
+    return !name.empty();
+  }
+};
 
 /// Vector of identifier, typing pairs used by objects for
 /// their fields or functions for their parameters.
@@ -27,8 +51,8 @@ using TypedFields = std::vector<std::pair<std::string, Typing>>;
 ///
 struct Comment {
   enum Placement { BEFORE, AFTER } placement;
-  std::string           text;
-  std::unique_ptr<Node> child;
+  std::string text;
+  NodePtr     child;
 };
 
 /// Declare the module as being the entrypoint
@@ -60,8 +84,8 @@ struct ModuleImport {
 ///   fun $name $child.parameters $child.child
 ///
 struct DeclarationFunction {
-  std::string           name;
-  std::unique_ptr<Node> child;
+  std::string name;
+  NodePtr     child;
 };
 
 // TODO: incomplete
@@ -134,7 +158,7 @@ struct StatementEmpty {};
 ///   $child;
 ///
 struct StatementExpression {
-  std::unique_ptr<Node> child;
+  NodePtr child;
 };
 
 /// A block contains multiple statements, delimited by a scope
@@ -152,7 +176,7 @@ struct StatementBlock {
 ///   ${ $children }
 ///
 struct StatementCircuit {
-  std::unique_ptr<Node>                     default_switch;
+  NodePtr                                   default_switch;
   std::vector<std::pair<std::string, Node>> children;
 };
 
@@ -162,9 +186,9 @@ struct StatementCircuit {
 ///   $kind $name :: $typing = $child;
 ///
 struct StatementVariable {
-  std::string           name;
-  Typing                typing;
-  std::unique_ptr<Node> child;
+  std::string name;
+  Typing      typing;
+  NodePtr     child;
   enum Kind {
     LET = (int)TokenKind::KW_LET,
     DEF = (int)TokenKind::KW_DEF,
@@ -176,9 +200,9 @@ struct StatementVariable {
 /// const $name :: $typing = $child;
 ///
 struct StatementConstant {
-  std::string           name;
-  Typing                typing;
-  std::unique_ptr<Node> child;
+  std::string name;
+  Typing      typing;
+  NodePtr     child;
 };
 
 /// A return in a function, returns have optional continuation
@@ -188,8 +212,8 @@ struct StatementConstant {
 ///   return[$continuation] $child;
 ///
 struct StatementReturn {
-  std::unique_ptr<Node> continuation;
-  std::unique_ptr<Node> child;
+  NodePtr continuation;
+  NodePtr child;
 };
 
 /// Switch to a different label in a circuit block
@@ -216,9 +240,9 @@ struct StatementIterationControl {
 ///   if ($condition) $consequence (else $alternative)?
 ///
 struct StatementIf {
-  std::unique_ptr<Node> condition;
-  std::unique_ptr<Node> consequence;
-  std::unique_ptr<Node> alternative;
+  NodePtr condition;
+  NodePtr consequence;
+  NodePtr alternative;
 };
 
 /// A while loop.
@@ -226,8 +250,8 @@ struct StatementIf {
 ///   while ($condition) $child
 ///
 struct StatementWhile {
-  std::unique_ptr<Node> condition;
-  std::unique_ptr<Node> child;
+  NodePtr condition;
+  NodePtr child;
 };
 
 /// An infinite loop.
@@ -235,7 +259,7 @@ struct StatementWhile {
 ///   loop $child
 ///
 struct StatementLoop {
-  std::unique_ptr<Node> child;
+  NodePtr child;
 };
 
 /// A C style for loop.
@@ -243,10 +267,10 @@ struct StatementLoop {
 ///   for ($initial; $condition; $increment) $child
 ///
 struct StatementFor {
-  std::unique_ptr<Node> initial;
-  std::unique_ptr<Node> condition;
-  std::unique_ptr<Node> increment;
-  std::unique_ptr<Node> child;
+  NodePtr initial;
+  NodePtr condition;
+  NodePtr increment;
+  NodePtr child;
 };
 
 /// A foreach loop.
@@ -258,9 +282,9 @@ struct StatementForeach {
     LET = (int)TokenKind::KW_LET,
     DEF = (int)TokenKind::KW_DEF,
   } iterator_kind;
-  std::string           iterator;
-  std::unique_ptr<Node> collection;
-  std::unique_ptr<Node> child;
+  std::string iterator;
+  NodePtr     collection;
+  NodePtr     child;
 };
 
 // TODO: incomplete
@@ -326,7 +350,7 @@ struct ExpressionTuple {
 
 ///
 struct ExpressionUnaryOp {
-  std::unique_ptr<Node> child;
+  NodePtr child;
   enum Kind {
     NOT = (int)TokenKind::KW_NOT,
     NEG = (int)TokenKind::SYM_MINUS,
@@ -335,8 +359,8 @@ struct ExpressionUnaryOp {
 
 ///
 struct ExpressionBinaryOp {
-  std::unique_ptr<Node> left;
-  std::unique_ptr<Node> right;
+  NodePtr left;
+  NodePtr right;
   enum Kind {
     // Booleans
     OR  = (int)TokenKind::KW_OR,
@@ -368,8 +392,8 @@ struct ExpressionBinaryOp {
 
 ///
 struct ExpressionRange {
-  std::unique_ptr<Node> left;
-  std::unique_ptr<Node> right;
+  NodePtr left;
+  NodePtr right;
 };
 
 ///
@@ -389,8 +413,8 @@ struct ExpressionDictionary {
 
 ///
 struct ExpressionAssignment {
-  std::unique_ptr<Node> assignee;
-  std::unique_ptr<Node> child;
+  NodePtr assignee;
+  NodePtr child;
   enum Kind {
     ASSIGN = (int)TokenKind::SYM_EQUAL,
     ADD    = (int)TokenKind::SYM_PLUS_EQUAL,
@@ -404,14 +428,14 @@ struct ExpressionAssignment {
 
 ///
 struct ExpressionCall {
-  std::unique_ptr<Node> callee;
-  std::vector<Node>     children;
+  NodePtr           callee;
+  std::vector<Node> children;
 };
 
 ///
 struct ExpressionLambda {
-  TypedFields           parameters;
-  std::unique_ptr<Node> child;
+  TypedFields parameters;
+  NodePtr     child;
 };
 
 /// Node in the syntax tree. Contains positional information
@@ -467,13 +491,62 @@ struct Node {
     data;
 };
 
+inline auto NodeDeleter::operator()(Node *node) const noexcept -> void {
+  node->~Node();
+}
+
+/// Every node of a module is allocated from the module's arena,
+/// nodes are bump allocated from large chunks and the chunks are
+/// all released at once when the module is destroyed.
+class Arena {
+private:
+  static constexpr std::size_t NODE_SIZE =
+    (sizeof(Node) + alignof(Node) - 1) / alignof(Node) * alignof(Node);
+
+  static constexpr std::size_t CHUNK_NODES = 1024;
+
+  std::vector<std::unique_ptr<std::byte[]>> _chunks;
+  std::byte *                               _next;
+  std::size_t                               _left;
+
+  auto allocate() -> void * {
+    if (_left == 0) {
+      _chunks.emplace_back(new std::byte[NODE_SIZE * CHUNK_NODES]);
+      _next = _chunks.back().get();
+      _left = CHUNK_NODES;
+    }
+
+    auto node = _next;
+    _next += NODE_SIZE;
+    _left--;
+    return node;
+  }
+
+public:
+  Arena() : _chunks(), _next(nullptr), _left(0) {
+  }
+
+  Arena(const Arena &) = delete;
+  Arena(Arena &&)      = delete;
+
+  /// Number of nodes allocated so far
+  auto size() const -> std::size_t {
+    return _chunks.size() * CHUNK_NODES - _left;
+  }
+
+  template <class... Args>
+  auto make(Args &&...args) -> NodePtr {
+    return NodePtr{new (allocate()) Node{std::forward<Args>(args)...}};
+  }
+};
+
 template <class... Ts>
 auto node_contains(const Node &node) -> bool {
   return (std::holds_alternative<Ts>(node.data) || ...);
 }
 
 template <class... Ts>
-auto node_contains(const std::unique_ptr<Node> &node) -> bool {
+auto node_contains(const NodePtr &node) -> bool {
   return node_contains<Ts...>(*node);
 }
 
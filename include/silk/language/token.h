@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <optional>
 #include <string>
+#include <string_view>
 
 namespace silk {
 
@@ -138,6 +140,11 @@ enum class TokenKind {
   SYM_HASH_BRACE,    // #{
 };
 
+/// Number of token kinds, for tables indexed by kind (the
+/// last kind above has to stay last)
+constexpr auto TOKEN_KIND_COUNT =
+  static_cast<std::size_t>(TokenKind::SYM_HASH_BRACE) + 1;
+
 /// Token is a struct used for storing logical groupings
 /// in the programs source code (e.g. `>=`), marking
 /// keywords to help the parser (e.g. `fct`) and storing
@@ -145,9 +152,9 @@ enum class TokenKind {
 /// the lexer turns the programs source file into an array
 /// of tokens
 struct Token {
-  TokenKind   kind;     //< Which kind of token this is
-  std::string lexeme;   //< Raw lexeme in the source file
-  Location    location; //< Where this token occurs in the source file
+  TokenKind        kind;     //< Which kind of token this is
+  std::string_view lexeme;   //< Raw lexeme, a view into the scanned source
+  Location         location; //< Where this token occurs in the source file
 };
 
 } // namespace silk
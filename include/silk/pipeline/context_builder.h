@@ -2,8 +2,11 @@
 
 #include <filesystem>
 #include <initializer_list>
-#include <regex>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include <silk/language/package.h>
@@ -17,17 +20,22 @@ class ContextBuilder final :
     public NonSyntaxTreeStage<ContextBuilder, Source, PackageSource> {
 
 private:
-  static const std::regex import_regex;
-
   const std::vector<fs::path> include_paths;
 
-  auto resolve_path(std::string) -> std::optional<fs::path>;
-  auto resolve_imports(
-    std::unordered_map<std::string, Source> &imports, Source &file) -> void;
+  std::vector<fs::path> _search_paths; //< Existing directories, in order
+  std::unordered_map<std::string, std::optional<fs::path>> _resolved;
+
+  static auto find_imports(std::string_view) -> std::vector<std::string>;
+
+  auto resolve_path(const std::string &) -> std::optional<fs::path>;
 
 public:
-  ContextBuilder(std::vector<fs::path> &&include_paths) :
-      include_paths(include_paths) {
+  static constexpr std::string_view NAME = "context builder";
+
+  ContextBuilder(
+    std::vector<fs::path> &&include_paths,
+    std::shared_ptr<ThreadPool> pool = nullptr) :
+      NonSyntaxTreeStage(std::move(pool)), include_paths(include_paths) {
   }
 
   ~ContextBuilder() {
@@ -9,6 +9,8 @@ namespace silk {
 class JsonDeserializer final :
     public NonSyntaxTreeStage<JsonDeserializer, std::string, Module> {
 public:
+  static constexpr std::string_view NAME = "json deserializer";
+
   JsonDeserializer() {
   }
 
@@ -4,6 +4,7 @@
 
 #include <silk/language/syntax_tree.h>
 #include <silk/pipeline/stage.h>
+#include <silk/utility/cache.h>
 #include <silk/utility/cli.h>
 
 namespace silk {
@@ -11,7 +12,10 @@ namespace silk {
 class JsonSerializer final :
     public Stage<JsonSerializer, Package, std::string> {
 private:
-  std::stringstream _output = {};
+  friend Stage; //< Dispatches nodes to the handlers below
+
+  std::stringstream            _output  = {};
+  std::shared_ptr<ModuleCache> _modules = {}; //< Reused between builds if set
 
   void obj_beg();
   void obj_end();
@@ -29,7 +33,8 @@ private:
 
   void serialize(st::Node &);
   void serialize(std::nullptr_t);
-  void serialize(std::unique_ptr<st::Node> &);
+  void serialize(st::Typing &);
+  void serialize(st::NodePtr &);
 
   void serialize(st::StatementVariable::Kind);
   void serialize(st::StatementIterationControl::Kind);
@@ -41,6 +46,8 @@ private:
 
   void serialize(Module&);
 
+  auto fragment(Module &) -> std::string;
+
   template <class T>
   void keyval(std::string_view key, T &&value) {
     _output << std::quoted(key) << ':';
@@ -95,56 +102,62 @@ private:
     _output << ',';
   }
 
-  void handle(st::Node &, st::Comment &) override;
-  void handle(st::Node &, st::ModuleMain &) override;
-  void handle(st::Node &, st::ModuleDeclaration &) override;
-  void handle(st::Node &, st::ModuleImport &) override;
-  void handle(st::Node &, st::DeclarationFunction &) override;
-  void handle(st::Node &, st::DeclarationEnum &) override;
-  void handle(st::Node &, st::DeclarationObject &) override;
-  void handle(st::Node &, st::DeclarationExternLibrary &) override;
-  void handle(st::Node &, st::DeclarationExternFunction &) override;
-  void handle(st::Node &, st::DeclarationMacro &) override;
-  void handle(st::Node &, st::StatementEmpty &) override;
-  void handle(st::Node &, st::StatementExpression &) override;
-  void handle(st::Node &, st::StatementBlock &) override;
-  void handle(st::Node &, st::StatementCircuit &) override;
-  void handle(st::Node &, st::StatementVariable &) override;
-  void handle(st::Node &, st::StatementConstant &) override;
-  void handle(st::Node &, st::StatementReturn &) override;
-  void handle(st::Node &, st::StatementSwitch &) override;
-  void handle(st::Node &, st::StatementIterationControl &) override;
-  void handle(st::Node &, st::StatementIf &) override;
-  void handle(st::Node &, st::StatementWhile &) override;
-  void handle(st::Node &, st::StatementLoop &) override;
-  void handle(st::Node &, st::StatementFor &) override;
-  void handle(st::Node &, st::StatementForeach &) override;
-  void handle(st::Node &, st::StatementMatch &) override;
-  void handle(st::Node &, st::ExpressionIdentifier &) override;
-  void handle(st::Node &, st::ExpressionVoid &) override;
-  void handle(st::Node &, st::ExpressionContinuation &) override;
-  void handle(st::Node &, st::ExpressionBool &) override;
-  void handle(st::Node &, st::ExpressionNat &) override;
-  void handle(st::Node &, st::ExpressionInt &) override;
-  void handle(st::Node &, st::ExpressionReal &) override;
-  void handle(st::Node &, st::ExpressionRealKeyword &) override;
-  void handle(st::Node &, st::ExpressionChar &) override;
-  void handle(st::Node &, st::ExpressionString &) override;
-  void handle(st::Node &, st::ExpressionTuple &) override;
-  void handle(st::Node &, st::ExpressionUnaryOp &) override;
-  void handle(st::Node &, st::ExpressionBinaryOp &) override;
-  void handle(st::Node &, st::ExpressionRange &) override;
-  void handle(st::Node &, st::ExpressionVector &) override;
-  void handle(st::Node &, st::ExpressionArray &) override;
-  void handle(st::Node &, st::ExpressionDictionary &) override;
-  void handle(st::Node &, st::ExpressionAssignment &) override;
-  void handle(st::Node &, st::ExpressionCall &) override;
-  void handle(st::Node &, st::ExpressionLambda &) override;
+  void handle(st::Node &, st::Comment &);
+  void handle(st::Node &, st::ModuleMain &);
+  void handle(st::Node &, st::ModuleDeclaration &);
+  void handle(st::Node &, st::ModuleImport &);
+  void handle(st::Node &, st::DeclarationFunction &);
+  void handle(st::Node &, st::DeclarationEnum &);
+  void handle(st::Node &, st::DeclarationObject &);
+  void handle(st::Node &, st::DeclarationExternLibrary &);
+  void handle(st::Node &, st::DeclarationExternFunction &);
+  void handle(st::Node &, st::DeclarationMacro &);
+  void handle(st::Node &, st::StatementEmpty &);
+  void handle(st::Node &, st::StatementExpression &);
+  void handle(st::Node &, st::StatementBlock &);
+  void handle(st::Node &, st::StatementCircuit &);
+  void handle(st::Node &, st::StatementVariable &);
+  void handle(st::Node &, st::StatementConstant &);
+  void handle(st::Node &, st::StatementReturn &);
+  void handle(st::Node &, st::StatementSwitch &);
+  void handle(st::Node &, st::StatementIterationControl &);
+  void handle(st::Node &, st::StatementIf &);
+  void handle(st::Node &, st::StatementWhile &);
+  void handle(st::Node &, st::StatementLoop &);
+  void handle(st::Node &, st::StatementFor &);
+  void handle(st::Node &, st::StatementForeach &);
+  void handle(st::Node &, st::StatementMatch &);
+  void handle(st::Node &, st::ExpressionIdentifier &);
+  void handle(st::Node &, st::ExpressionVoid &);
+  void handle(st::Node &, st::ExpressionContinuation &);
+  void handle(st::Node &, st::ExpressionBool &);
+  void handle(st::Node &, st::ExpressionNat &);
+  void handle(st::Node &, st::ExpressionInt &);
+  void handle(st::Node &, st::ExpressionReal &);
+  void handle(st::Node &, st::ExpressionRealKeyword &);
+  void handle(st::Node &, st::ExpressionChar &);
+  void handle(st::Node &, st::ExpressionString &);
+  void handle(st::Node &, st::ExpressionTuple &);
+  void handle(st::Node &, st::ExpressionUnaryOp &);
+  void handle(st::Node &, st::ExpressionBinaryOp &);
+  void handle(st::Node &, st::ExpressionRange &);
+  void handle(st::Node &, st::ExpressionVector &);
+  void handle(st::Node &, st::ExpressionArray &);
+  void handle(st::Node &, st::ExpressionDictionary &);
+  void handle(st::Node &, st::ExpressionAssignment &);
+  void handle(st::Node &, st::ExpressionCall &);
+  void handle(st::Node &, st::ExpressionLambda &);
 
 public:
+  static constexpr std::string_view NAME = "json serializer";
+
   JsonSerializer() {
   }
 
+  JsonSerializer(std::shared_ptr<ModuleCache> modules) :
+      _modules(std::move(modules)) {
+  }
+
   ~JsonSerializer() {
   }
 
@@ -1,17 +1,22 @@
 #pragma once
 
+#include <array>
+
 #include <silk/language/package.h>
 #include <silk/language/scanner.h>
 #include <silk/language/syntax_tree.h>
 #include <silk/pipeline/stage.h>
+#include <silk/utility/cache.h>
 #include <tuple>
 
 namespace silk {
 
 class Parser final : public NonSyntaxTreeStage<Parser, PackageSource, Package> {
 private:
-  std::optional<Scanner> _scanner;
-  std::vector<Token>     _tokens;
+  std::optional<Scanner>       _scanner;
+  std::vector<Token>           _tokens;
+  std::unique_ptr<st::Arena>   _arena;
+  std::shared_ptr<ModuleCache> _modules; //< Reused between builds if set
 
   enum class Precedence {
     ANY,        // lowest
@@ -29,16 +34,17 @@ private:
   };
 
   struct Rule {
-    using UnaParseFN = std::unique_ptr<st::Node> (Parser::*)();
-    using BinParseFN =
-      std::unique_ptr<st::Node> (Parser::*)(std::unique_ptr<st::Node> &&);
+    using UnaParseFN = st::NodePtr (Parser::*)();
+    using BinParseFN = st::NodePtr (Parser::*)(st::NodePtr &&);
     UnaParseFN prefix     = nullptr;
     BinParseFN infix      = nullptr;
     UnaParseFN postfix    = nullptr;
     Precedence precedence = Precedence::ANY;
   };
 
-  static const std::unordered_map<TokenKind, Rule> rules;
+  // Indexed by token kind, kinds without a rule have no functions
+  using Rules = std::array<Rule, TOKEN_KIND_COUNT>;
+  static const Rules rules;
 
   // check end of token stream
   inline auto eof() const -> bool;
@@ -87,15 +93,12 @@ private:
   inline auto must_consume(TokenKind, std::string_view) -> void;
 
   template <class T, class... Args>
-  auto make_node(Args &&...args) -> std::unique_ptr<st::Node> {
-    return std::unique_ptr<st::Node>(new st::Node{
-      .location = peek().location,
-      .data     = T{std::forward<Args>(args)...},
-    });
+  auto make_node(Args &&...args) -> st::NodePtr {
+    return _arena->make(peek().location, T{std::forward<Args>(args)...});
   };
 
   // Pratt Parser functions
-  auto precendece(Precedence) -> std::unique_ptr<st::Node>;
+  auto precendece(Precedence) -> st::NodePtr;
   auto higher(Precedence) const -> Precedence;
   auto lower(Precedence) const -> Precedence;
   auto get_rule(const Token &) const
@@ -112,62 +115,79 @@ private:
     -> std::tuple<std::string, st::TypedFields, st::Typing>;
   auto parse_nameless_function_header()
     -> std::tuple<st::TypedFields, st::Typing>;
-  auto parse_function_body() -> std::unique_ptr<st::Node>;
+  auto parse_function_body() -> st::NodePtr;
 
   // Declarations & Module
-  auto declaration() -> std::unique_ptr<st::Node>;
-  auto declaration_main() -> std::unique_ptr<st::Node>;
-  auto declaration_package() -> std::unique_ptr<st::Node>;
-  auto declaration_import() -> std::unique_ptr<st::Node>;
-  auto declaration_function() -> std::unique_ptr<st::Node>;
-  auto declaration_enum() -> std::unique_ptr<st::Node>;
-  auto declaration_object() -> std::unique_ptr<st::Node>;
-  auto declaration_library() -> std::unique_ptr<st::Node>;
-  auto declaration_macro() -> std::unique_ptr<st::Node>;
+  auto declaration() -> st::NodePtr;
+  auto declaration_main() -> st::NodePtr;
+  auto declaration_package() -> st::NodePtr;
+  auto declaration_import() -> st::NodePtr;
+  auto declaration_function() -> st::NodePtr;
+  auto declaration_enum() -> st::NodePtr;
+  auto declaration_object() -> st::NodePtr;
+  auto declaration_library() -> st::NodePtr;
+  auto declaration_macro() -> st::NodePtr;
 
   // Statements
-  auto statement() -> std::unique_ptr<st::Node>;
-  auto statement_empty() -> std::unique_ptr<st::Node>;
-  auto statement_expression() -> std::unique_ptr<st::Node>;
-  auto statement_block() -> std::unique_ptr<st::Node>;
-  auto statement_circuit() -> std::unique_ptr<st::Node>;
-  auto statement_variable() -> std::unique_ptr<st::Node>;
-  auto statement_constant() -> std::unique_ptr<st::Node>;
-  auto statement_return() -> std::unique_ptr<st::Node>;
-  auto statement_switch() -> std::unique_ptr<st::Node>;
-  auto statement_itercontrol() -> std::unique_ptr<st::Node>;
-  auto statement_if() -> std::unique_ptr<st::Node>;
-  auto statement_while() -> std::unique_ptr<st::Node>;
-  auto statement_loop() -> std::unique_ptr<st::Node>;
-  auto statement_for() -> std::unique_ptr<st::Node>;
-  auto statement_foreach() -> std::unique_ptr<st::Node>;
-  auto statement_match() -> std::unique_ptr<st::Node>;
+  auto statement() -> st::NodePtr;
+  auto statement_empty() -> st::NodePtr;
+  auto statement_expression() -> st::NodePtr;
+  auto statement_block() -> st::NodePtr;
+  auto statement_circuit() -> st::NodePtr;
+  auto statement_variable() -> st::NodePtr;
+  auto statement_constant() -> st::NodePtr;
+  auto statement_return() -> st::NodePtr;
+  auto statement_switch() -> st::NodePtr;
+  auto statement_itercontrol() -> st::NodePtr;
+  auto statement_if() -> st::NodePtr;
+  auto statement_while() -> st::NodePtr;
+  auto statement_loop() -> st::NodePtr;
+  auto statement_for() -> st::NodePtr;
+  auto statement_foreach() -> st::NodePtr;
+  auto statement_match() -> st::NodePtr;
 
   // expressions
-  auto expression() -> std::unique_ptr<st::Node>;
-  auto expression_identifier() -> std::unique_ptr<st::Node>;
-  auto expression_void() -> std::unique_ptr<st::Node>;
-  auto expression_continuation() -> std::unique_ptr<st::Node>;
-  auto expression_literal() -> std::unique_ptr<st::Node>;
-  auto expression_char() -> std::unique_ptr<st::Node>;
-  auto expression_string() -> std::unique_ptr<st::Node>;
-  auto expression_unary() -> std::unique_ptr<st::Node>;
-  auto expression_binary(std::unique_ptr<st::Node> &&)
-    -> std::unique_ptr<st::Node>;
-  auto expression_tuple() -> std::unique_ptr<st::Node>;
-  auto expression_range(std::unique_ptr<st::Node> &&left)
-    -> std::unique_ptr<st::Node>;
-  auto expression_vector() -> std::unique_ptr<st::Node>;
-  auto expression_array() -> std::unique_ptr<st::Node>;
-  auto expression_dictionary() -> std::unique_ptr<st::Node>;
-  auto expression_assignment(std::unique_ptr<st::Node> &&)
-    -> std::unique_ptr<st::Node>;
-  auto expression_call(std::unique_ptr<st::Node> &&)
-    -> std::unique_ptr<st::Node>;
-  auto expression_lambda() -> std::unique_ptr<st::Node>;
+  auto expression() -> st::NodePtr;
+  auto expression_identifier() -> st::NodePtr;
+  auto expression_void() -> st::NodePtr;
+  auto expression_continuation() -> st::NodePtr;
+  auto expression_literal() -> st::NodePtr;
+  auto expression_char() -> st::NodePtr;
+  auto expression_string() -> st::NodePtr;
+  auto expression_unary() -> st::NodePtr;
+  auto expression_binary(st::NodePtr &&) -> st::NodePtr;
+  auto expression_tuple() -> st::NodePtr;
+  auto expression_range(st::NodePtr &&left) -> st::NodePtr;
+  auto expression_vector() -> st::NodePtr;
+  auto expression_array() -> st::NodePtr;
+  auto expression_dictionary() -> st::NodePtr;
+  auto expression_assignment(st::NodePtr &&) -> st::NodePtr;
+  auto expression_call(st::NodePtr &&) -> st::NodePtr;
+  auto expression_lambda() -> st::NodePtr;
+
+  using Sources      = std::vector<Source *>;
+  using Parsed       = std::vector<std::optional<Module>>;
+  using Fingerprints = std::vector<Fingerprint>;
+
+  auto parse_all(const Sources &, const std::vector<std::size_t> &, Parsed &)
+    -> void;
+  auto reuse(const ModuleGraph &, const Sources &, Parsed &, Fingerprints &)
+    -> std::vector<std::size_t>;
 
 public:
-  Parser() : _scanner(), _tokens() {
+  static constexpr std::string_view NAME = "parser";
+
+  Parser() : _scanner(), _tokens(), _arena() {
+  }
+
+  Parser(
+    std::shared_ptr<ThreadPool>  pool,
+    std::shared_ptr<ModuleCache> modules = nullptr) :
+      NonSyntaxTreeStage(std::move(pool)),
+      _scanner(),
+      _tokens(),
+      _arena(),
+      _modules(std::move(modules)) {
   }
 
   Parser(const Parser &) = delete;
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <iterator>
 #include <memory>
+#include <vector>
 
 #include <silk/language/package.h>
 #include <silk/language/token.h>
+#include <silk/utility/profiler.h>
+#include <silk/utility/thread_pool.h>
 
 namespace silk {
 
@@ -54,7 +58,17 @@ public:
     "to be compatible to the second stage's input");
 
   auto execute(Input &&input) noexcept -> Output {
-    return _b.execute(_a.execute(std::move(input)));
+    return _b.run(_a.run(std::move(input)));
+  }
+
+  auto run(Input &&input) noexcept -> Output {
+    return execute(std::move(input));
+  }
+
+  /// Measure every stage of the pipeline with `profiler`
+  auto profile(const std::shared_ptr<Profiler> &profiler) -> void {
+    _a.profile(profiler);
+    _b.profile(profiler);
   }
 
   auto has_errors() const noexcept -> bool {
@@ -83,61 +97,24 @@ public:
 template <class D, class I = Module, class O = Module, class Nt = void>
 class Stage {
 private:
-  std::vector<Error> mutable _errors{};
+  std::vector<Error> mutable  _errors{};
+  std::shared_ptr<ThreadPool> _pool{};
+  std::shared_ptr<Profiler>   _profiler{};
+  std::size_t                 _visits{0};
 
 protected:
-  virtual auto handle(st::Node &, st::Comment &) -> Nt                   = 0;
-  virtual auto handle(st::Node &, st::ModuleMain &) -> Nt                = 0;
-  virtual auto handle(st::Node &, st::ModuleDeclaration &) -> Nt         = 0;
-  virtual auto handle(st::Node &, st::ModuleImport &) -> Nt              = 0;
-  virtual auto handle(st::Node &, st::DeclarationFunction &) -> Nt       = 0;
-  virtual auto handle(st::Node &, st::DeclarationEnum &) -> Nt           = 0;
-  virtual auto handle(st::Node &, st::DeclarationObject &) -> Nt         = 0;
-  virtual auto handle(st::Node &, st::DeclarationExternLibrary &) -> Nt  = 0;
-  virtual auto handle(st::Node &, st::DeclarationExternFunction &) -> Nt = 0;
-  virtual auto handle(st::Node &, st::DeclarationMacro &) -> Nt          = 0;
-  virtual auto handle(st::Node &, st::StatementEmpty &) -> Nt            = 0;
-  virtual auto handle(st::Node &, st::StatementExpression &) -> Nt       = 0;
-  virtual auto handle(st::Node &, st::StatementBlock &) -> Nt            = 0;
-  virtual auto handle(st::Node &, st::StatementCircuit &) -> Nt          = 0;
-  virtual auto handle(st::Node &, st::StatementVariable &) -> Nt         = 0;
-  virtual auto handle(st::Node &, st::StatementConstant &) -> Nt         = 0;
-  virtual auto handle(st::Node &, st::StatementReturn &) -> Nt           = 0;
-  virtual auto handle(st::Node &, st::StatementSwitch &) -> Nt           = 0;
-  virtual auto handle(st::Node &, st::StatementIterationControl &) -> Nt = 0;
-  virtual auto handle(st::Node &, st::StatementIf &) -> Nt               = 0;
-  virtual auto handle(st::Node &, st::StatementWhile &) -> Nt            = 0;
-  virtual auto handle(st::Node &, st::StatementLoop &) -> Nt             = 0;
-  virtual auto handle(st::Node &, st::StatementFor &) -> Nt              = 0;
-  virtual auto handle(st::Node &, st::StatementForeach &) -> Nt          = 0;
-  virtual auto handle(st::Node &, st::StatementMatch &) -> Nt            = 0;
-  virtual auto handle(st::Node &, st::ExpressionIdentifier &) -> Nt      = 0;
-  virtual auto handle(st::Node &, st::ExpressionVoid &) -> Nt            = 0;
-  virtual auto handle(st::Node &, st::ExpressionContinuation &) -> Nt    = 0;
-  virtual auto handle(st::Node &, st::ExpressionBool &) -> Nt            = 0;
-  virtual auto handle(st::Node &, st::ExpressionNat &) -> Nt             = 0;
-  virtual auto handle(st::Node &, st::ExpressionInt &) -> Nt             = 0;
-  virtual auto handle(st::Node &, st::ExpressionReal &) -> Nt            = 0;
-  virtual auto handle(st::Node &, st::ExpressionRealKeyword &) -> Nt     = 0;
-  virtual auto handle(st::Node &, st::ExpressionChar &) -> Nt            = 0;
-  virtual auto handle(st::Node &, st::ExpressionString &) -> Nt          = 0;
-  virtual auto handle(st::Node &, st::ExpressionTuple &) -> Nt           = 0;
-  virtual auto handle(st::Node &, st::ExpressionUnaryOp &) -> Nt         = 0;
-  virtual auto handle(st::Node &, st::ExpressionBinaryOp &) -> Nt        = 0;
-  virtual auto handle(st::Node &, st::ExpressionRange &) -> Nt           = 0;
-  virtual auto handle(st::Node &, st::ExpressionVector &) -> Nt          = 0;
-  virtual auto handle(st::Node &, st::ExpressionArray &) -> Nt           = 0;
-  virtual auto handle(st::Node &, st::ExpressionDictionary &) -> Nt      = 0;
-  virtual auto handle(st::Node &, st::ExpressionAssignment &) -> Nt      = 0;
-  virtual auto handle(st::Node &, st::ExpressionCall &) -> Nt            = 0;
-  virtual auto handle(st::Node &, st::ExpressionLambda &) -> Nt          = 0;
-
+  /// Call the handler of `D` for the node's data, the handlers are
+  /// found at compile time so passes inline across the traversal
   auto handle_node(st::Node &node) -> Nt {
+    _visits++;
     return std::visit(
-      [this, &node](auto &&data) { this->handle(node, data); }, node.data);
+      [this, &node](auto &data) -> Nt {
+        return static_cast<D *>(this)->handle(node, data);
+      },
+      node.data);
   }
 
-  auto handle_node(std::unique_ptr<st::Node> &ptr) -> Nt {
+  auto handle_node(st::NodePtr &ptr) -> Nt {
     return handle_node(*ptr);
   }
 
@@ -152,6 +129,43 @@ protected:
     return _errors.back();
   }
 
+  /// Number of nodes handled by this stage so far
+  auto visits() const -> std::size_t {
+    return _visits;
+  }
+
+  /// Measure the work on one module until the span is destroyed,
+  /// the span measures nothing unless the stage is being profiled
+  auto measure(std::string name) const -> Profiler::Span {
+    if (!_profiler) return {};
+    return _profiler->module(std::move(name));
+  }
+
+  /// Call `fn` with every index below `count`, on the pool
+  /// if this stage was given one and in order otherwise
+  template <class Fn>
+  auto parallel(std::size_t count, Fn &&fn) -> void {
+    if (_pool) {
+      _pool->run(count, fn);
+    } else {
+      for (auto i = std::size_t{0}; i < count; i++) fn(i);
+    }
+  }
+
+  /// Call `fn` with a stage of its own for every index below `count`,
+  /// on the pool if this stage was given one. The errors of those stages
+  /// are added by index, whichever of them finishes first.
+  template <class Fn>
+  auto for_each_parallel(std::size_t count, Fn &&fn) -> void {
+    auto stages = std::vector<D>(count);
+    parallel(count, [&](std::size_t i) { fn(stages[i], i); });
+
+    for (auto &stage : stages) {
+      const auto &errors = static_cast<Stage &>(stage)._errors;
+      std::copy(errors.begin(), errors.end(), std::back_inserter(_errors));
+    }
+  }
+
 public:
   using Input  = I;
   using Output = O;
@@ -160,11 +174,26 @@ public:
   Stage(const Stage &) = delete;
   Stage(Stage &&)      = default;
 
+  /// Stages given a pool work on the modules of a package in parallel
+  Stage(std::shared_ptr<ThreadPool> pool) : _pool(std::move(pool)) {
+  }
+
   virtual ~Stage() {
   }
 
   virtual auto execute(I &&input) noexcept -> O = 0;
 
+  /// Execute the stage, measuring it if it is being profiled
+  auto run(I &&input) noexcept -> O {
+    auto span = _profiler ? _profiler->stage(std::string{D::NAME})
+                          : Profiler::Span{};
+    return execute(std::move(input));
+  }
+
+  auto profile(const std::shared_ptr<Profiler> &profiler) -> void {
+    _profiler = profiler;
+  }
+
   virtual auto has_errors() const noexcept -> bool final {
     return !_errors.empty();
   }
@@ -177,60 +206,17 @@ public:
   auto operator>>(Nxt &&nxt) noexcept
     -> std::enable_if_t<is_stage_v<Nxt>, Pipeline<D, Nxt>> {
     return Pipeline<D, Nxt>{
-      std::move(*dynamic_cast<D *>(this)),
+      std::move(*static_cast<D *>(this)),
       std::move(nxt),
     };
   }
 };
 
+/// Stage that never walks a syntax tree, so it has no node handlers
 template <class D, class I, class O>
 class NonSyntaxTreeStage : public Stage<D, I, O> {
-private:
-  auto handle(st::Node &, st::Comment &) -> void final{};
-  auto handle(st::Node &, st::ModuleMain &) -> void final{};
-  auto handle(st::Node &, st::ModuleDeclaration &) -> void final{};
-  auto handle(st::Node &, st::ModuleImport &) -> void final{};
-  auto handle(st::Node &, st::DeclarationFunction &) -> void final{};
-  auto handle(st::Node &, st::DeclarationEnum &) -> void final{};
-  auto handle(st::Node &, st::DeclarationObject &) -> void final{};
-  auto handle(st::Node &, st::DeclarationExternLibrary &) -> void final{};
-  auto handle(st::Node &, st::DeclarationExternFunction &) -> void final{};
-  auto handle(st::Node &, st::DeclarationMacro &) -> void final{};
-  auto handle(st::Node &, st::StatementEmpty &) -> void final{};
-  auto handle(st::Node &, st::StatementExpression &) -> void final{};
-  auto handle(st::Node &, st::StatementBlock &) -> void final{};
-  auto handle(st::Node &, st::StatementCircuit &) -> void final{};
-  auto handle(st::Node &, st::StatementVariable &) -> void final{};
-  auto handle(st::Node &, st::StatementConstant &) -> void final{};
-  auto handle(st::Node &, st::StatementReturn &) -> void final{};
-  auto handle(st::Node &, st::StatementSwitch &) -> void final{};
-  auto handle(st::Node &, st::StatementIterationControl &) -> void final{};
-  auto handle(st::Node &, st::StatementIf &) -> void final{};
-  auto handle(st::Node &, st::StatementWhile &) -> void final{};
-  auto handle(st::Node &, st::StatementLoop &) -> void final{};
-  auto handle(st::Node &, st::StatementFor &) -> void final{};
-  auto handle(st::Node &, st::StatementForeach &) -> void final{};
-  auto handle(st::Node &, st::StatementMatch &) -> void final{};
-  auto handle(st::Node &, st::ExpressionIdentifier &) -> void final{};
-  auto handle(st::Node &, st::ExpressionVoid &) -> void final{};
-  auto handle(st::Node &, st::ExpressionContinuation &) -> void final{};
-  auto handle(st::Node &, st::ExpressionBool &) -> void final{};
-  auto handle(st::Node &, st::ExpressionNat &) -> void final{};
-  auto handle(st::Node &, st::ExpressionInt &) -> void final{};
-  auto handle(st::Node &, st::ExpressionReal &) -> void final{};
-  auto handle(st::Node &, st::ExpressionRealKeyword &) -> void final{};
-  auto handle(st::Node &, st::ExpressionChar &) -> void final{};
-  auto handle(st::Node &, st::ExpressionString &) -> void final{};
-  auto handle(st::Node &, st::ExpressionTuple &) -> void final{};
-  auto handle(st::Node &, st::ExpressionUnaryOp &) -> void final{};
-  auto handle(st::Node &, st::ExpressionBinaryOp &) -> void final{};
-  auto handle(st::Node &, st::ExpressionRange &) -> void final{};
-  auto handle(st::Node &, st::ExpressionVector &) -> void final{};
-  auto handle(st::Node &, st::ExpressionArray &) -> void final{};
-  auto handle(st::Node &, st::ExpressionDictionary &) -> void final{};
-  auto handle(st::Node &, st::ExpressionAssignment &) -> void final{};
-  auto handle(st::Node &, st::ExpressionCall &) -> void final{};
-  auto handle(st::Node &, st::ExpressionLambda &) -> void final{};
+public:
+  using Stage<D, I, O>::Stage;
 };
 
 } // namespace silk
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <optional>
 #include <stack>
+#include <unordered_set>
+#include <vector>
 
 #include <moth/program.h>
 #include <moth/value.h>
 #include <moth/vm.h>
 
+#include <silk/language/intrinsics.h>
 #include <silk/language/package.h>
 #include <silk/language/syntax_tree.h>
 #include <silk/pipeline/stage.h>
@@ -16,6 +20,8 @@ namespace moth {
 
 class Compiler final : public Stage<Compiler, Package, Program> {
 private:
+  friend Stage; //< Dispatches nodes to the handlers below
+
   // Standard library modules
   static const std::unordered_map<std::string_view, std::string_view> modules;
 
@@ -42,9 +48,15 @@ private:
   std::string_view              _pkg_name    = {};
   std::vector<std::string_view> _pkg_imports = {};
 
+  // Math functions compiled to a single instruction
+  Intrinsics _intrinsics = {};
+
   // Bytecode
   Program _program;
 
+  // Instructions are encoded as 32 bit words
+  bool _wordcode = false;
+
   // Global constants
   std::vector<std::string_view> _globals = {};
 
@@ -65,10 +77,24 @@ private:
   std::unordered_map<std::string_view, std::uint32_t> _strings  = {};
   std::unordered_map<std::string_view, std::uint32_t> _symbols  = {};
 
-  // bytecode functions
+  // Signatures of typed extern functions
+  std::unordered_set<std::string> _signatures = {};
+
+  // Typed extern functions declared so far, by name
+  std::unordered_map<std::string_view, std::string_view> _natives = {};
+
+  // Inline caches handed out to call sites
+  std::uint16_t _inline_caches = 0;
+
+  // bytecode functions, operand sizes are those of bytecode
+  auto emit_byte(std::uint8_t) -> void;
+  auto emit_word(std::uint32_t) -> void;
   auto emit(std::uint8_t) -> void;
+  auto emit(std::uint8_t, std::uint32_t, std::size_t) -> void;
+  auto emit_operand(std::uint32_t, std::size_t) -> void;
   auto emit_varbyte_arg(std::uint32_t, std::size_t) -> void;
   auto emit_varbyte_op_arg(std::uint8_t, std::uint32_t) -> void;
+  auto emit_cached_key(std::uint8_t, std::string_view) -> void;
 
   auto get_offset() -> std::uint32_t;
   auto get_buffer() -> std::uint8_t *;
@@ -91,6 +117,8 @@ private:
   auto store_stack_var(std::uint16_t) -> void;
 
   auto encode_rodata(Value) -> std::uint32_t;
+  auto encode_string(std::string_view) -> std::uint32_t;
+  auto encode_inline_cache() -> std::uint16_t;
   auto load_rodata(std::uint32_t) -> void;
 
   auto encode_symbol(std::string_view) -> std::uint32_t;
@@ -98,63 +126,81 @@ private:
   auto define_symbol(std::uint32_t) -> void;
   auto assign_symbol(std::uint32_t) -> void;
 
+  auto extern_signature(const st::DeclarationExternFunction &)
+    -> std::optional<std::string>;
+
+  auto intrinsic_op(Intrinsic) -> std::uint8_t;
+
   auto jmp_insert(std::uint8_t) -> std::uint32_t;
+  auto jmp_patch(std::uint32_t, std::uint32_t) -> void;
   auto jmp_finish(std::uint32_t) -> void;
 
   auto logical_or(st::Node &, st::Node &) -> void;
   auto logical_and(st::Node &, st::Node &) -> void;
 
-  auto handle(st::Node &, st::Comment &) -> void override;
-  auto handle(st::Node &, st::ModuleMain &) -> void override;
-  auto handle(st::Node &, st::ModuleDeclaration &) -> void override;
-  auto handle(st::Node &, st::ModuleImport &) -> void override;
-
-  auto handle(st::Node &, st::DeclarationFunction &) -> void override;
-  auto handle(st::Node &, st::DeclarationEnum &) -> void override;
-  auto handle(st::Node &, st::DeclarationObject &) -> void override;
-  auto handle(st::Node &, st::DeclarationExternLibrary &) -> void override;
-  auto handle(st::Node &, st::DeclarationExternFunction &) -> void override;
-  auto handle(st::Node &, st::DeclarationMacro &) -> void override;
-
-  auto handle(st::Node &, st::StatementEmpty &) -> void override;
-  auto handle(st::Node &, st::StatementExpression &) -> void override;
-  auto handle(st::Node &, st::StatementBlock &) -> void override;
-  auto handle(st::Node &, st::StatementCircuit &) -> void override;
-  auto handle(st::Node &, st::StatementVariable &) -> void override;
-  auto handle(st::Node &, st::StatementConstant &) -> void override;
-  auto handle(st::Node &, st::StatementReturn &) -> void override;
-  auto handle(st::Node &, st::StatementSwitch &) -> void override;
-  auto handle(st::Node &, st::StatementIterationControl &) -> void override;
-  auto handle(st::Node &, st::StatementIf &) -> void override;
-  auto handle(st::Node &, st::StatementWhile &) -> void override;
-  auto handle(st::Node &, st::StatementLoop &) -> void override;
-  auto handle(st::Node &, st::StatementFor &) -> void override;
-  auto handle(st::Node &, st::StatementForeach &) -> void override;
-  auto handle(st::Node &, st::StatementMatch &) -> void override;
-
-  auto handle(st::Node &, st::ExpressionIdentifier &) -> void override;
-  auto handle(st::Node &, st::ExpressionVoid &) -> void override;
-  auto handle(st::Node &, st::ExpressionContinuation &) -> void override;
-  auto handle(st::Node &, st::ExpressionBool &) -> void override;
-  auto handle(st::Node &, st::ExpressionNat &) -> void override;
-  auto handle(st::Node &, st::ExpressionInt &) -> void override;
-  auto handle(st::Node &, st::ExpressionReal &) -> void override;
-  auto handle(st::Node &, st::ExpressionRealKeyword &) -> void override;
-  auto handle(st::Node &, st::ExpressionChar &) -> void override;
-  auto handle(st::Node &, st::ExpressionString &) -> void override;
-  auto handle(st::Node &, st::ExpressionTuple &) -> void override;
-  auto handle(st::Node &, st::ExpressionUnaryOp &) -> void override;
-  auto handle(st::Node &, st::ExpressionBinaryOp &) -> void override;
-  auto handle(st::Node &, st::ExpressionRange &) -> void override;
-  auto handle(st::Node &, st::ExpressionVector &) -> void override;
-  auto handle(st::Node &, st::ExpressionArray &) -> void override;
-  auto handle(st::Node &, st::ExpressionDictionary &) -> void override;
-  auto handle(st::Node &, st::ExpressionAssignment &) -> void override;
-  auto handle(st::Node &, st::ExpressionCall &) -> void override;
-  auto handle(st::Node &, st::ExpressionLambda &) -> void override;
+  auto invoke_method(st::ExpressionCall &) -> bool;
+  auto native_type(const st::Node &) -> char;
+  auto native_arg(st::Node &, char) -> void;
+  auto call_native(st::ExpressionCall &) -> bool;
+
+  auto compile_module(Module &) -> void;
+
+  auto handle(st::Node &, st::Comment &) -> void;
+  auto handle(st::Node &, st::ModuleMain &) -> void;
+  auto handle(st::Node &, st::ModuleDeclaration &) -> void;
+  auto handle(st::Node &, st::ModuleImport &) -> void;
+
+  auto handle(st::Node &, st::DeclarationFunction &) -> void;
+  auto handle(st::Node &, st::DeclarationEnum &) -> void;
+  auto handle(st::Node &, st::DeclarationObject &) -> void;
+  auto handle(st::Node &, st::DeclarationExternLibrary &) -> void;
+  auto handle(st::Node &, st::DeclarationExternFunction &) -> void;
+  auto handle(st::Node &, st::DeclarationMacro &) -> void;
+
+  auto handle(st::Node &, st::StatementEmpty &) -> void;
+  auto handle(st::Node &, st::StatementExpression &) -> void;
+  auto handle(st::Node &, st::StatementBlock &) -> void;
+  auto handle(st::Node &, st::StatementCircuit &) -> void;
+  auto handle(st::Node &, st::StatementVariable &) -> void;
+  auto handle(st::Node &, st::StatementConstant &) -> void;
+  auto handle(st::Node &, st::StatementReturn &) -> void;
+  auto handle(st::Node &, st::StatementSwitch &) -> void;
+  auto handle(st::Node &, st::StatementIterationControl &) -> void;
+  auto handle(st::Node &, st::StatementIf &) -> void;
+  auto handle(st::Node &, st::StatementWhile &) -> void;
+  auto handle(st::Node &, st::StatementLoop &) -> void;
+  auto handle(st::Node &, st::StatementFor &) -> void;
+  auto handle(st::Node &, st::StatementForeach &) -> void;
+  auto handle(st::Node &, st::StatementMatch &) -> void;
+
+  auto handle(st::Node &, st::ExpressionIdentifier &) -> void;
+  auto handle(st::Node &, st::ExpressionVoid &) -> void;
+  auto handle(st::Node &, st::ExpressionContinuation &) -> void;
+  auto handle(st::Node &, st::ExpressionBool &) -> void;
+  auto handle(st::Node &, st::ExpressionNat &) -> void;
+  auto handle(st::Node &, st::ExpressionInt &) -> void;
+  auto handle(st::Node &, st::ExpressionReal &) -> void;
+  auto handle(st::Node &, st::ExpressionRealKeyword &) -> void;
+  auto handle(st::Node &, st::ExpressionChar &) -> void;
+  auto handle(st::Node &, st::ExpressionString &) -> void;
+  auto handle(st::Node &, st::ExpressionTuple &) -> void;
+  auto handle(st::Node &, st::ExpressionUnaryOp &) -> void;
+  auto handle(st::Node &, st::ExpressionBinaryOp &) -> void;
+  auto handle(st::Node &, st::ExpressionRange &) -> void;
+  auto handle(st::Node &, st::ExpressionVector &) -> void;
+  auto handle(st::Node &, st::ExpressionArray &) -> void;
+  auto handle(st::Node &, st::ExpressionDictionary &) -> void;
+  auto handle(st::Node &, st::ExpressionAssignment &) -> void;
+  auto handle(st::Node &, st::ExpressionCall &) -> void;
+  auto handle(st::Node &, st::ExpressionLambda &) -> void;
 
 public:
-  Compiler() {
+  static constexpr std::string_view NAME = "moth compiler";
+
+  // An empty program owns no memory, so moving the
+  // compiler before it executes is safe
+  Compiler(bool wordcode = false) : _wordcode(wordcode) {
+    init_program(&_program, 0, 0, 0);
   }
 
   ~Compiler() {
@@ -10,56 +10,60 @@ namespace wasm {
 
 class Compiler final : public Stage<Compiler, Package, void> {
 private:
-  auto handle(st::Node &, st::Comment &) -> void override;
-  auto handle(st::Node &, st::ModuleMain &) -> void override;
-  auto handle(st::Node &, st::ModuleDeclaration &) -> void override;
-  auto handle(st::Node &, st::ModuleImport &) -> void override;
+  friend Stage; //< Dispatches nodes to the handlers below
 
-  auto handle(st::Node &, st::DeclarationFunction &) -> void override;
-  auto handle(st::Node &, st::DeclarationEnum &) -> void override;
-  auto handle(st::Node &, st::DeclarationObject &) -> void override;
-  auto handle(st::Node &, st::DeclarationExternLibrary &) -> void override;
-  auto handle(st::Node &, st::DeclarationExternFunction &) -> void override;
-  auto handle(st::Node &, st::DeclarationMacro &) -> void override;
+  auto handle(st::Node &, st::Comment &) -> void;
+  auto handle(st::Node &, st::ModuleMain &) -> void;
+  auto handle(st::Node &, st::ModuleDeclaration &) -> void;
+  auto handle(st::Node &, st::ModuleImport &) -> void;
 
-  auto handle(st::Node &, st::StatementEmpty &) -> void override;
-  auto handle(st::Node &, st::StatementExpression &) -> void override;
-  auto handle(st::Node &, st::StatementBlock &) -> void override;
-  auto handle(st::Node &, st::StatementCircuit &) -> void override;
-  auto handle(st::Node &, st::StatementVariable &) -> void override;
-  auto handle(st::Node &, st::StatementConstant &) -> void override;
-  auto handle(st::Node &, st::StatementReturn &) -> void override;
-  auto handle(st::Node &, st::StatementSwitch &) -> void override;
-  auto handle(st::Node &, st::StatementIterationControl &) -> void override;
-  auto handle(st::Node &, st::StatementIf &) -> void override;
-  auto handle(st::Node &, st::StatementWhile &) -> void override;
-  auto handle(st::Node &, st::StatementLoop &) -> void override;
-  auto handle(st::Node &, st::StatementFor &) -> void override;
-  auto handle(st::Node &, st::StatementForeach &) -> void override;
-  auto handle(st::Node &, st::StatementMatch &) -> void override;
+  auto handle(st::Node &, st::DeclarationFunction &) -> void;
+  auto handle(st::Node &, st::DeclarationEnum &) -> void;
+  auto handle(st::Node &, st::DeclarationObject &) -> void;
+  auto handle(st::Node &, st::DeclarationExternLibrary &) -> void;
+  auto handle(st::Node &, st::DeclarationExternFunction &) -> void;
+  auto handle(st::Node &, st::DeclarationMacro &) -> void;
 
-  auto handle(st::Node &, st::ExpressionIdentifier &) -> void override;
-  auto handle(st::Node &, st::ExpressionVoid &) -> void override;
-  auto handle(st::Node &, st::ExpressionContinuation &) -> void override;
-  auto handle(st::Node &, st::ExpressionBool &) -> void override;
-  auto handle(st::Node &, st::ExpressionNat &) -> void override;
-  auto handle(st::Node &, st::ExpressionInt &) -> void override;
-  auto handle(st::Node &, st::ExpressionReal &) -> void override;
-  auto handle(st::Node &, st::ExpressionRealKeyword &) -> void override;
-  auto handle(st::Node &, st::ExpressionChar &) -> void override;
-  auto handle(st::Node &, st::ExpressionString &) -> void override;
-  auto handle(st::Node &, st::ExpressionTuple &) -> void override;
-  auto handle(st::Node &, st::ExpressionUnaryOp &) -> void override;
-  auto handle(st::Node &, st::ExpressionBinaryOp &) -> void override;
-  auto handle(st::Node &, st::ExpressionRange &) -> void override;
-  auto handle(st::Node &, st::ExpressionVector &) -> void override;
-  auto handle(st::Node &, st::ExpressionArray &) -> void override;
-  auto handle(st::Node &, st::ExpressionDictionary &) -> void override;
-  auto handle(st::Node &, st::ExpressionAssignment &) -> void override;
-  auto handle(st::Node &, st::ExpressionCall &) -> void override;
-  auto handle(st::Node &, st::ExpressionLambda &) -> void override;
+  auto handle(st::Node &, st::StatementEmpty &) -> void;
+  auto handle(st::Node &, st::StatementExpression &) -> void;
+  auto handle(st::Node &, st::StatementBlock &) -> void;
+  auto handle(st::Node &, st::StatementCircuit &) -> void;
+  auto handle(st::Node &, st::StatementVariable &) -> void;
+  auto handle(st::Node &, st::StatementConstant &) -> void;
+  auto handle(st::Node &, st::StatementReturn &) -> void;
+  auto handle(st::Node &, st::StatementSwitch &) -> void;
+  auto handle(st::Node &, st::StatementIterationControl &) -> void;
+  auto handle(st::Node &, st::StatementIf &) -> void;
+  auto handle(st::Node &, st::StatementWhile &) -> void;
+  auto handle(st::Node &, st::StatementLoop &) -> void;
+  auto handle(st::Node &, st::StatementFor &) -> void;
+  auto handle(st::Node &, st::StatementForeach &) -> void;
+  auto handle(st::Node &, st::StatementMatch &) -> void;
+
+  auto handle(st::Node &, st::ExpressionIdentifier &) -> void;
+  auto handle(st::Node &, st::ExpressionVoid &) -> void;
+  auto handle(st::Node &, st::ExpressionContinuation &) -> void;
+  auto handle(st::Node &, st::ExpressionBool &) -> void;
+  auto handle(st::Node &, st::ExpressionNat &) -> void;
+  auto handle(st::Node &, st::ExpressionInt &) -> void;
+  auto handle(st::Node &, st::ExpressionReal &) -> void;
+  auto handle(st::Node &, st::ExpressionRealKeyword &) -> void;
+  auto handle(st::Node &, st::ExpressionChar &) -> void;
+  auto handle(st::Node &, st::ExpressionString &) -> void;
+  auto handle(st::Node &, st::ExpressionTuple &) -> void;
+  auto handle(st::Node &, st::ExpressionUnaryOp &) -> void;
+  auto handle(st::Node &, st::ExpressionBinaryOp &) -> void;
+  auto handle(st::Node &, st::ExpressionRange &) -> void;
+  auto handle(st::Node &, st::ExpressionVector &) -> void;
+  auto handle(st::Node &, st::ExpressionArray &) -> void;
+  auto handle(st::Node &, st::ExpressionDictionary &) -> void;
+  auto handle(st::Node &, st::ExpressionAssignment &) -> void;
+  auto handle(st::Node &, st::ExpressionCall &) -> void;
+  auto handle(st::Node &, st::ExpressionLambda &) -> void;
 
 public:
+  static constexpr std::string_view NAME = "wasm compiler";
+
   Compiler() {
   }
 
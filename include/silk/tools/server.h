@@ -0,0 +1,47 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+
+#include <silk/utility/cli.h>
+
+namespace silk {
+
+/// Long lived compiler listening on a local socket. Each request
+/// carries the arguments and working directory of a `silk` call,
+/// the reply carries its exit code and everything it printed.
+/// Requests are served one at a time, in the order they arrive.
+/// Clients have a few seconds to send their request and to have it
+/// accepted, a client the server is too busy for builds by itself.
+class Server {
+public:
+  using Handler =
+    std::function<int(const CLIFlags &, std::ostream &out, std::ostream &err)>;
+
+private:
+  const std::string _path;
+
+public:
+  explicit Server(std::string path) : _path(std::move(path)) {
+  }
+
+  /// `$SILK_SERVER_SOCKET` if set, a socket private to the user otherwise
+  static auto default_path() -> std::optional<std::string>;
+
+  /// Serve requests with `handler` until the process is stopped
+  auto run(const Handler &handler) -> int;
+
+  /// Have the server at `path` handle this call, printing its output
+  /// to `out` and `err`. Nothing is returned when no server answered
+  /// in time, nothing was printed then.
+  static auto forward(
+    const std::string &path,
+    int                argc,
+    const char       **argv,
+    std::ostream      &out,
+    std::ostream      &err) -> std::optional<int>;
+};
+
+} // namespace silk
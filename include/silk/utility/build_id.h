@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string_view>
+
+namespace silk {
+
+/// Hash of the sources and toolchain this compiler was built from.
+/// Artifacts and servers of any other build are never reused, even
+/// when the two builds report the same version.
+auto build_id() noexcept -> std::string_view;
+
+} // namespace silk
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <silk/language/package.h>
+
+namespace silk {
+
+namespace fs = std::filesystem;
+
+/// Content addressed cache of compiled packages. Artifacts are keyed
+/// by a hash of every source in the package, the build of the compiler
+/// and the flags. Once the cache grows past its size limit the least
+/// recently used artifacts are evicted.
+class CompileCache {
+private:
+  const fs::path       _directory;
+  const std::uintmax_t _max_size;
+
+  // Compilers serving many builds keep artifacts in memory as well
+  bool                                                   _resident    = false;
+  std::unordered_map<std::uint64_t, std::string> mutable _memory      = {};
+  std::uintmax_t mutable                                 _memory_size = 0;
+
+  auto entry_path(std::uint64_t) const -> fs::path;
+  auto write(std::uint64_t, std::string_view) const noexcept -> bool;
+  auto remember(std::uint64_t, std::string_view) const noexcept -> void;
+  auto evict() const noexcept -> void;
+
+public:
+  static constexpr std::uintmax_t DEFAULT_MAX_SIZE = 64 * 1024 * 1024;
+
+  CompileCache(fs::path directory, std::uintmax_t max_size = DEFAULT_MAX_SIZE) :
+      _directory(std::move(directory)), _max_size(max_size) {
+  }
+
+  ~CompileCache() {
+  }
+
+  CompileCache(const CompileCache &) = delete;
+  CompileCache(CompileCache &&)      = default;
+
+  /// Keep loaded and stored artifacts in memory up to the size
+  /// limit, later loads of them never touch the file system
+  auto keep_resident() noexcept -> void {
+    _resident = true;
+  }
+
+  /// `$SILK_CACHE_DIR` if set, the user's cache directory otherwise
+  static auto default_directory() noexcept -> std::optional<fs::path>;
+
+  /// Hash every source of the package, sources are read into
+  /// memory once and the parser scans the same buffers
+  static auto key(PackageSource &, std::uint64_t flags) -> std::uint64_t;
+
+  auto load(std::uint64_t) const noexcept -> std::optional<std::string>;
+  auto store(std::uint64_t, std::string_view) const noexcept -> bool;
+
+  /// Store many artifacts at once, evicting only after the last one
+  auto store(const std::vector<std::pair<std::uint64_t, std::string>> &) const
+    noexcept -> bool;
+};
+
+/// Artifacts of single modules kept in a compile cache between builds.
+/// A module is only built again when its source or the interface of a
+/// module it imports changed, the others reuse their earlier artifacts.
+/// Artifacts are staged while building and only stored by `commit`,
+/// once the whole package built without errors.
+class ModuleCache {
+private:
+  const CompileCache &_cache;
+  const std::uint64_t _flags;
+
+  std::vector<std::pair<std::uint64_t, std::string>> _staged = {};
+
+  static auto interface_key(std::uint64_t source) -> std::uint64_t;
+
+public:
+  ModuleCache(const CompileCache &cache, std::uint64_t flags) :
+      _cache(cache), _flags(flags) {
+  }
+
+  ModuleCache(const ModuleCache &) = delete;
+  ModuleCache(ModuleCache &&)      = default;
+
+  /// Hash of the text of a source
+  static auto fingerprint(Source &) -> std::uint64_t;
+
+  /// Hash of the top level declarations of a parsed module
+  static auto interface(const Module &) -> std::uint64_t;
+
+  /// Interface of a source that was built before, if it was
+  auto interface(std::uint64_t source) const -> std::optional<std::uint64_t>;
+
+  /// Key of the artifact of a module, given the interfaces it imports
+  auto key(
+    const std::string &path,
+    std::uint64_t source,
+    const std::vector<std::uint64_t> &imports) const -> std::uint64_t;
+
+  auto load(std::uint64_t key) const -> std::shared_ptr<const std::string>;
+  auto stage(const Module &, std::string artifact) -> void;
+  auto commit() -> void;
+};
+
+} // namespace silk
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <bitset>
+#include <cstdint>
 #include <iostream>
 #include <string_view>
 #include <vector>
@@ -9,6 +10,7 @@
 #define fmt_function fmt::format
 
 #include <silk/language/token.h>
+#include <silk/utility/thread_pool.h>
 
 namespace silk {
 
@@ -50,6 +52,12 @@ private:
     DEBUG,
     INTERACTIVE,
     RUN,
+    NO_CACHE,
+    WORDCODE,
+    JOBS,
+    SERVER,
+    TIME_STAGES,
+    TIME_JSON,
 
     // used for iteration and counting
     // do not touch !
@@ -58,6 +66,7 @@ private:
 
   std::bitset<(size_t)Flag::LAST> _bits;
   std::vector<std::string>        _files;
+  std::size_t                     _jobs;
 
   auto is_flag(const char *) const -> bool;
   auto is_flag(const char *, Flag) const -> bool;
@@ -72,11 +81,20 @@ public:
   static constexpr auto DEBUG       = Flag::DEBUG;
   static constexpr auto INTERACTIVE = Flag::INTERACTIVE;
   static constexpr auto RUN         = Flag::RUN;
+  static constexpr auto NO_CACHE    = Flag::NO_CACHE;
+  static constexpr auto WORDCODE    = Flag::WORDCODE;
+  static constexpr auto JOBS        = Flag::JOBS;
+  static constexpr auto SERVER      = Flag::SERVER;
+  static constexpr auto TIME_STAGES = Flag::TIME_STAGES;
+  static constexpr auto TIME_JSON   = Flag::TIME_JSON;
 
   auto is_set(Flag) const -> bool;
+  auto mask() const -> std::uint64_t;
   auto files() const -> const std::vector<std::string> &;
+  auto jobs() const -> std::size_t;
 
-  CLIFlags(const int argc, const char **argv) : _bits() {
+  CLIFlags(const int argc, const char **argv) :
+      _bits(), _files(), _jobs(ThreadPool::default_jobs()) {
     parse(argc, argv);
   }
 
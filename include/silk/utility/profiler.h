@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace silk {
+
+/// What a piece of work cost and how many items it went through
+struct Measurement {
+  using Items = std::map<std::string, std::uint64_t, std::less<>>;
+
+  std::string   name        = {};
+  double        wall        = 0; //< Seconds
+  double        cpu         = 0; //< Seconds, of every thread for stages
+  std::int64_t  peak_rss    = 0; //< Growth of the peak in KiB, stages only
+  std::uint64_t allocations = 0;
+  Items         items       = {};
+};
+
+/// A stage and the modules it worked on, in the order they finished
+struct StageProfile : Measurement {
+  std::vector<Measurement> modules = {};
+};
+
+/// Records where a build spends its time. Stages are measured one
+/// after the other, the modules of a stage may be measured from many
+/// threads at once. Allocations are only counted while a profiler
+/// exists, the counting costs every allocation a relaxed atomic load.
+class Profiler {
+public:
+  /// Measures from its creation until it is destroyed, a span
+  /// without a profiler measures nothing and costs nothing
+  class Span {
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    Profiler         *_profiler = nullptr;
+    bool              _stage    = false;
+    Measurement       _measure  = {};
+    Clock::time_point _wall     = {};
+    double            _cpu      = 0;
+    std::int64_t      _peak_rss = 0;
+    std::uint64_t     _allocs   = 0;
+
+  public:
+    Span() = default;
+    Span(Profiler *, std::string name, bool stage);
+    ~Span();
+
+    Span(const Span &) = delete;
+    Span(Span &&other) noexcept;
+
+    /// Add `n` to the count of `item`
+    auto count(std::string_view item, std::uint64_t n) -> void;
+  };
+
+private:
+  mutable std::mutex        _mutex  = {};
+  std::vector<StageProfile> _stages = {};
+
+  auto finish(Measurement &&, bool stage) -> void;
+
+public:
+  Profiler();
+  ~Profiler();
+
+  Profiler(const Profiler &) = delete;
+  Profiler(Profiler &&)      = delete;
+
+  auto stage(std::string name) -> Span;
+  auto module(std::string name) -> Span;
+
+  auto stages() const -> std::vector<StageProfile>;
+
+  auto print_table(std::ostream &) const -> void;
+  auto print_json(std::ostream &) const -> void;
+};
+
+} // namespace silk
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace silk {
+
+/// Fixed set of worker threads shared by the pipeline stages. Work is
+/// handed out as batches of indices, the calling thread takes part in
+/// every batch so a pool of one job never starts a thread at all.
+class ThreadPool {
+private:
+  using Task = std::function<void(std::size_t)>;
+
+  std::vector<std::thread> _workers;
+  std::mutex               _mutex;
+  std::condition_variable  _wake;
+  std::condition_variable  _done;
+
+  const Task   *_task       = nullptr;
+  std::size_t   _count      = 0;
+  std::size_t   _next       = 0;
+  std::size_t   _busy       = 0;
+  std::uint64_t _generation = 0;
+  bool          _stopping   = false;
+
+  auto work() -> void;
+  auto drain(std::unique_lock<std::mutex> &) -> void;
+
+public:
+  /// `jobs` threads work on each batch, the caller included
+  explicit ThreadPool(std::size_t jobs);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool(ThreadPool &&)      = delete;
+
+  /// One per hardware thread, at least one
+  static auto default_jobs() noexcept -> std::size_t;
+
+  auto jobs() const noexcept -> std::size_t;
+
+  /// Call `task` with every index below `count` and return once
+  /// all calls are done, the order of the calls is unspecified
+  auto run(std::size_t count, const Task &task) -> void;
+};
+
+} // namespace silk
@@ -0,0 +1,55 @@
+#include <moth/builtins.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <stdsilk/bytes.h>
+#include <stdsilk/io.h>
+
+#define BUILTIN(NAME) {#NAME, NAME}
+
+// Sorted by name, looked up with a binary search
+static const Builtin builtins[] = {
+  BUILTIN(stdsilk_bytes_alloc),
+  BUILTIN(stdsilk_bytes_open),
+  BUILTIN(stdsilk_bytes_read),
+  BUILTIN(stdsilk_bytes_to_array),
+  BUILTIN(stdsilk_bytes_to_string),
+  BUILTIN(stdsilk_bytes_write),
+  BUILTIN(stdsilk_feof),
+  BUILTIN(stdsilk_fopen),
+  BUILTIN(stdsilk_format),
+  BUILTIN(stdsilk_fread),
+  BUILTIN(stdsilk_fwrite),
+  BUILTIN(stdsilk_print),
+  BUILTIN(stdsilk_scan),
+};
+
+#undef BUILTIN
+
+static int compare_builtin(const void* key, const void* elem) {
+  return strcmp((const char*)key, ((const Builtin*)elem)->name);
+}
+
+bool builtin_library(const char* name) {
+  return strcmp(name, MOTH_BUILTIN_LIBRARY) == 0;
+}
+
+FFIFunction builtin_lookup(const char* name) {
+  const Builtin* builtin = bsearch(
+    name,
+    builtins,
+    sizeof(builtins) / sizeof(Builtin),
+    sizeof(Builtin),
+    compare_builtin);
+
+  return builtin ? builtin->fun : NULL;
+}
+
+const char* builtin_name(FFIFunction fun) {
+  for (size_t i = 0; i < sizeof(builtins) / sizeof(Builtin); i++) {
+    if (builtins[i].fun == fun) return builtins[i].name;
+  }
+
+  return NULL;
+}
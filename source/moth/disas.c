@@ -1,5 +1,6 @@
 #include <moth/disas.h>
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -16,11 +17,27 @@ typedef struct {
   Symtable* symtab;
   uint8_t*  codes;
   uint32_t  ofst;
+  bool      wcd;  // codes are wordcode
+  uint32_t  at;   // offset of the instruction being printed
+  uint32_t  arg;  // operand held by the instruction's word
+  uint32_t  ext;  // high byte of the next operand
+  int       read; // operands read so far
 } DissasmInfo;
 
-static void single(DissasmInfo* info, const char* name) {
-  printf("0x%03x %s\n", info->ofst, name);
-  info->ofst++;
+// Moves past the opcode, to the operands
+static void begin(DissasmInfo* info) {
+  info->at   = info->ofst;
+  info->read = 0;
+
+  if (!info->wcd) {
+    info->ofst++;
+    return;
+  }
+
+  uint32_t word = LOAD_WORD(info->codes + info->ofst);
+  info->arg     = info->ext | WORD_ARG(word);
+  info->ext     = 0;
+  info->ofst += 4;
 }
 
 static uint32_t read_address(DissasmInfo* info, int addr_sz) {
@@ -35,67 +52,123 @@ static uint32_t read_address(DissasmInfo* info, int addr_sz) {
   return val_ofst;
 }
 
+// Reads the next operand, bytecode operands are addr_sz bytes
+// wide, in wordcode the first is in the instruction's word and
+// the others in the words after it
+static uint32_t operand(DissasmInfo* info, int addr_sz) {
+  if (!info->wcd) {
+    uint32_t val = read_address(info, addr_sz);
+    info->ofst += addr_sz;
+    return val;
+  }
+
+  if (info->read++ == 0) return info->arg;
+
+  uint32_t word = LOAD_WORD(info->codes + info->ofst);
+  info->ofst += 4;
+  return word;
+}
+
+static void single(DissasmInfo* info, const char* name) {
+  begin(info);
+  printf("0x%03x %s\n", info->at, name);
+}
+
+static void extend(DissasmInfo* info) {
+  begin(info);
+  info->ext = info->arg << 24;
+  printf("0x%03x EXT 0x%02x\n", info->at, info->arg & 0xff);
+}
+
 static void move(DissasmInfo* info, const char* name, const char* op) {
-  info->ofst++;
-  uint8_t index = read_address(info, 2);
+  begin(info);
+  uint32_t index = operand(info, 2);
 
-  printf("0x%03x %s %s [%d]\n", info->ofst, name, op, index);
-  info->ofst += 2;
+  printf("0x%03x %s %s [%d]\n", info->at, name, op, index);
 }
 
 static void load_val(DissasmInfo* info, int addr_sz) {
-  info->ofst++;
-  uint32_t val_ofst = read_address(info, addr_sz);
+  begin(info);
+  uint32_t val_ofst = operand(info, addr_sz);
 
-  printf("0x%03x VAL%d 0x%02x (", info->ofst, addr_sz, val_ofst);
+  printf("0x%03x VAL%d 0x%02x (", info->at, addr_sz, val_ofst);
   print_value(info->rodata->arr[val_ofst]);
   printf(")\n");
-
-  info->ofst += addr_sz;
 }
 
 static void symbol_op(DissasmInfo* info, const char* op, int addr_sz) {
-  info->ofst++;
-
-  uint32_t sym_off = read_address(info, addr_sz);
+  begin(info);
+  uint32_t sym_off = operand(info, addr_sz);
 
   const char* sym_str = info->symtab->arr[sym_off].str;
-  printf("0x%03x %s%d $%s [0x%02x]", info->ofst, op, addr_sz, sym_str, sym_off);
+  printf("0x%03x %s%d $%s [0x%02x]", info->at, op, addr_sz, sym_str, sym_off);
   printf("\n");
-
-  info->ofst += addr_sz;
 }
 
 static void jump(DissasmInfo* info, const char* op, int dir) {
-  info->ofst++;
+  begin(info);
 
-  uint32_t off     = read_address(info, 2);
-  uint32_t landing = info->ofst + 2 + off * dir;
-  printf("0x%03x %s +%u (0x%03x)\n", info->ofst, op, off, landing);
-  info->ofst += 2;
+  uint32_t off     = operand(info, 2);
+  uint32_t landing = info->ofst + off * dir;
+  printf("0x%03x %s +%u (0x%03x)\n", info->at, op, off, landing);
 }
 
 static void call(DissasmInfo* info, const char* op) {
-  info->ofst++;
-  uint8_t argc = info->codes[info->ofst++];
-  printf("0x%03x %s #%d\n", info->ofst, op, argc);
+  begin(info);
+  uint8_t argc = operand(info, 1);
+  printf("0x%03x %s #%d\n", info->at, op, argc);
+}
+
+static void invoke(DissasmInfo* info, const char* op) {
+  begin(info);
+  uint8_t argc = operand(info, 1);
+
+  printf("0x%03x %s #%d (", info->at, op, argc);
+  print_value(info->rodata->arr[operand(info, 4)]);
+  printf(") [ic %u]\n", operand(info, 2));
+}
+
+static void native(DissasmInfo* info, const char* op) {
+  begin(info);
+  uint8_t argc = operand(info, 1);
+
+  printf("0x%03x %s #%d (", info->at, op, argc);
+  print_value(info->rodata->arr[operand(info, 4)]);
+  printf(")\n");
+}
+
+static void index_key(DissasmInfo* info, const char* op) {
+  begin(info);
+
+  printf("0x%03x %s (", info->at, op);
+  print_value(info->rodata->arr[operand(info, 4)]);
+  printf(") [ic %u]\n", operand(info, 2));
 }
 
 static void frame(DissasmInfo* info, const char* op, int addr_sz) {
-  info->ofst++;
-  uint32_t address = read_address(info, addr_sz);
+  begin(info);
+  uint32_t address = operand(info, addr_sz);
+  uint8_t  argc    = operand(info, 1);
 
-  printf("0x%03x %s >=> 0x%03x\n", info->ofst, op, address);
-  info->ofst += addr_sz;
+  printf("0x%03x %s >=> 0x%03x #%d\n", info->at, op, address, argc);
 }
 
 static void instruction(DissasmInfo* info) {
-  OpCode code = info->codes[info->ofst];
+  OpCode code = info->wcd ? WORD_OP(LOAD_WORD(info->codes + info->ofst))
+                          : info->codes[info->ofst];
   switch (code) {
     case VM_FIN: return single(info, "FIN");
+    case VM_GC: return single(info, "GC");
+    case VM_DBG: return single(info, "DBG");
+
+    case VM_DLL: return symbol_op(info, "DLL", 4);
+    case VM_FFN: return symbol_op(info, "FFN", 4);
+    case VM_FFT: return symbol_op(info, "FFT", 4);
 
     case VM_CLO: return single(info, "CLO");
     case VM_CAL: return call(info, "CAL");
+    case VM_PRO: return single(info, "PRO");
+    case VM_NTV: return native(info, "NTV");
     case VM_FRM: return frame(info, "FRM", 1);
     case VM_FRM2: return frame(info, "FRM", 2);
     case VM_FRM3: return frame(info, "FRM", 3);
@@ -132,6 +205,10 @@ static void instruction(DissasmInfo* info) {
     case VM_ASN3: return symbol_op(info, "ASN", 3);
     case VM_ASN4: return symbol_op(info, "ASN", 4);
 
+    case VM_VEC: return call(info, "VEC");
+    case VM_ARR: return call(info, "ARR");
+    case VM_DCT: return call(info, "DCT");
+
     case VM_NEG: return single(info, "NEG");
     case VM_NOT: return single(info, "NOT");
 
@@ -143,6 +220,10 @@ static void instruction(DissasmInfo* info) {
     case VM_POW: return single(info, "POW");
     case VM_MOD: return single(info, "MOD");
 
+    case VM_IDX: return single(info, "IDX");
+    case VM_IDA: return single(info, "IDA");
+    case VM_MRG: return single(info, "MRG");
+
     case VM_NOP: return single(info, "NOP");
     case VM_VID: return single(info, "VID");
     case VM_TRU: return single(info, "TRU");
@@ -159,6 +240,21 @@ static void instruction(DissasmInfo* info) {
     case VM_TAU: return single(info, "TAU");
     case VM_EUL: return single(info, "EUL");
 
+    case VM_SQT: return single(info, "SQT");
+    case VM_FLR: return single(info, "FLR");
+    case VM_ABS: return single(info, "ABS");
+    case VM_SIN: return single(info, "SIN");
+    case VM_COS: return single(info, "COS");
+    case VM_EXP: return single(info, "EXP");
+    case VM_LOG: return single(info, "LOG");
+    case VM_MIN: return single(info, "MIN");
+    case VM_MAX: return single(info, "MAX");
+
+    case VM_INV: return invoke(info, "INV");
+    case VM_IDK: return index_key(info, "IDK");
+    case VM_IAK: return index_key(info, "IAK");
+    case VM_EXT: return extend(info);
+
     default: return single(info, "???");
   }
 };
@@ -167,6 +263,8 @@ void disassemble(const char* name, Program* prog) {
   DissasmInfo info;
   info.rodata = &prog->rod;
   info.symtab = &prog->stb;
+  info.wcd    = prog->wcd;
+  info.ext    = 0;
 
   printf("%% %-10s: \n", name);
   for (Value* v = info.rodata->arr; v < info.rodata->arr + info.rodata->len;
@@ -1,5 +1,183 @@
 #include <moth/ffi.h>
 
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+  #include <windows.h>
+  #define DLL_PREFIX ""
+  #define DLL_SUFFIX ".dll"
+#else
+  #include <dlfcn.h>
+  #define DLL_PREFIX "lib"
+  #ifdef __APPLE__
+    #define DLL_SUFFIX ".dylib"
+  #else
+    #define DLL_SUFFIX ".so"
+  #endif
+#endif
+
+#define DLL_NAME_MAX 256
+
+//   _                                 _ _                         //
+//  | |                               | (_)                        //
+//  | |_ _ __ __ _ _ __ ___  _ __   ___ | |_ _ __   ___  ___       //
+//  | __| '__/ _` | '_ ` _ \| '_ \ / _ \| | | '_ \ / _ \/ __|      //
+//  | |_| | | (_| | | | | | | |_) | (_) | | | | | |  __/\__ \      //
+//   \__|_|  \__,_|_| |_| |_| .__/ \___/|_|_|_| |_|\___||___/      //
+//                          | |                                    //
+//                          |_|                                    //
+
+// Arguments are unboxed once, before the call, into one of
+// three classes: integers, reals and pointers. Each trampoline
+// casts the native function to its exact C type and calls it,
+// there is one trampoline per return class & parameter classes.
+
+#define CT_v void
+#define CT_i int64_t
+#define CT_r double
+#define CT_p void *
+
+#define RET_v(CALL) (CALL, (FFIArg){.i = 0})
+#define RET_i(CALL) ((FFIArg){.i = CALL})
+#define RET_r(CALL) ((FFIArg){.r = CALL})
+#define RET_p(CALL) ((FFIArg){.p = CALL})
+
+#define TRAMPOLINE(R, NAME, PARAMS, ARGS)                                      \
+  static FFIArg tramp_##R##NAME(FFINative fn, FFIArg *argv) {                  \
+    return RET_##R(((CT_##R(*) PARAMS)fn) ARGS);                               \
+  }
+
+#define TRAMP_0(R)    TRAMPOLINE(R, , (void), ())
+#define TRAMP_1(R, A) TRAMPOLINE(R, A, (CT_##A), (argv[0].A))
+#define TRAMP_2(R, A, B)                                                       \
+  TRAMPOLINE(R, A##B, (CT_##A, CT_##B), (argv[0].A, argv[1].B))
+#define TRAMP_3(R, A, B, C)                                                    \
+  TRAMPOLINE(                                                                  \
+    R, A##B##C, (CT_##A, CT_##B, CT_##C), (argv[0].A, argv[1].B, argv[2].C))
+
+// The preprocessor won't expand a macro inside itself
+// so every nesting level needs its own copy
+#define EACH_1(M, ...) M(__VA_ARGS__, i) M(__VA_ARGS__, r) M(__VA_ARGS__, p)
+#define EACH_2(M, ...) M(__VA_ARGS__, i) M(__VA_ARGS__, r) M(__VA_ARGS__, p)
+#define EACH_3(M, ...) M(__VA_ARGS__, i) M(__VA_ARGS__, r) M(__VA_ARGS__, p)
+
+#define TRAMPS_2_(R, A)     EACH_2(TRAMP_2, R, A)
+#define TRAMPS_3__(R, A, B) EACH_3(TRAMP_3, R, A, B)
+#define TRAMPS_3_(R, A)     EACH_2(TRAMPS_3__, R, A)
+
+#define TRAMPOLINES(R)                                                         \
+  TRAMP_0(R)                                                                   \
+  EACH_1(TRAMP_1, R)                                                           \
+  EACH_1(TRAMPS_2_, R)                                                         \
+  EACH_1(TRAMPS_3_, R)
+
+TRAMPOLINES(v)
+TRAMPOLINES(i)
+TRAMPOLINES(r)
+TRAMPOLINES(p)
+
+#undef TRAMPOLINE
+#define TRAMPOLINE(R, NAME, PARAMS, ARGS) tramp_##R##NAME,
+
+// Trampolines of the same arity are laid out as a base 3
+// number, the first parameter being the most significant digit
+#define TRAMPOLINE_COUNT (1 + 3 + 9 + 27)
+
+static const uint8_t arity_offsets[MOTH_FFI_MAX_TYPED_ARGS + 1] = {0, 1, 4, 13};
+
+static const FFITrampoline trampolines[][TRAMPOLINE_COUNT] = {
+  {TRAMPOLINES(v)},
+  {TRAMPOLINES(i)},
+  {TRAMPOLINES(r)},
+  {TRAMPOLINES(p)},
+};
+
+#undef TRAMPOLINE
+
+static int return_class(char type) {
+  switch (type) {
+    case 'v': return 0;
+    case 'i': return 1;
+    case 'r': return 2;
+    case 's': // fallthrough
+    case 'p': return 3;
+    default: return -1;
+  }
+}
+
+static int param_class(char type) {
+  switch (type) {
+    case 'i': return 0;
+    case 'r': return 1;
+    case 's': // fallthrough
+    case 'p': return 2;
+    default: return -1;
+  }
+}
+
+static bool unbox_arg(char type, Value val, FFIArg *arg) {
+  switch (type) {
+    case 'i': {
+      if (!IS_INT(val)) return false;
+      arg->i = val.as.integer;
+      return true;
+    }
+
+    case 'r': {
+      if (IS_INT(val)) {
+        arg->r = (double)val.as.integer;
+        return true;
+      }
+
+      if (!IS_REAL(val)) return false;
+      arg->r = val.as.real;
+      return true;
+    }
+
+    case 's': {
+      arg->p = (void *)string_value(val);
+      return arg->p != NULL;
+    }
+
+    case 'p': {
+      if (!IS_OBJ_FFI_PTR(val)) return false;
+      arg->p = OBJ_FFI_PTR(val.as.object)->ptr;
+      return true;
+    }
+
+    default: return false;
+  }
+}
+
+static Value box_ret(char type, FFIArg ret) {
+  switch (type) {
+    case 'i': return INT_VAL(ret.i);
+    case 'r': return REAL_VAL(ret.r);
+
+    case 's': {
+      if (!ret.p) return VOID_VAL;
+      return OBJ_VAL((Object *)obj_str_from_raw((const char *)ret.p));
+    }
+
+    case 'p': {
+      if (!ret.p) return VOID_VAL;
+      return OBJ_VAL((Object *)obj_ffi_ptr_new(0x0, ret.p, NULL));
+    }
+
+    default: return VOID_VAL;
+  }
+}
+
+//         _     _           _                                     //
+//        | |   (_)         | |                                    //
+//    ___ | |__  _  ___  ___| |_ ___                               //
+//   / _ \| '_ \| |/ _ \/ __| __/ __|                              //
+//  | (_) | |_) | |  __/ (__| |_\__ \                              //
+//   \___/|_.__/| |\___|\___|\__|___/                              //
+//             _/ |                                                //
+//            |__/                                                 //
+
 ObjectFFIFunction *obj_ffi_fun_new(FFIFunction fun) {
   ObjectFFIFunction *obj = (ObjectFFIFunction *)alloc_object(
     O_FFI_FUNCTION, sizeof(ObjectFFIFunction));
@@ -21,3 +199,99 @@ ObjectFFIPointer *obj_ffi_ptr_new(uint32_t tag, void *ptr, FFIDeleter del) {
 void obj_ffi_ptr_del(ObjectFFIPointer *ffi_ptr) {
   if (ffi_ptr->del != NULL) ffi_ptr->del(ffi_ptr->tag, ffi_ptr->ptr);
 }
+
+ObjectFFINative *obj_ffi_ntv_new(FFINative fun, const char *sig) {
+  size_t argc = strlen(sig);
+  if (argc == 0 || argc - 1 > MOTH_FFI_MAX_TYPED_ARGS) return NULL;
+  argc -= 1;
+
+  // Pick the trampoline matching the signature
+  int ret = return_class(sig[0]);
+  if (ret < 0) return NULL;
+
+  size_t idx = 0;
+  for (size_t i = 1; i <= argc; i++) {
+    int param = param_class(sig[i]);
+    if (param < 0) return NULL;
+    idx = idx * 3 + param;
+  }
+
+  ObjectFFINative *obj =
+    (ObjectFFINative *)alloc_object(O_FFI_NATIVE, sizeof(ObjectFFINative));
+
+  obj->fun   = fun;
+  obj->tramp = trampolines[ret][arity_offsets[argc] + idx];
+  obj->argc  = argc;
+  obj->src   = NULL;
+  strcpy(obj->sig, sig);
+  return obj;
+}
+
+FFIResult ffi_ntv_call(ObjectFFINative *ntv, Value *argv, uint8_t argc,
+                       Value *ret) {
+  FFIArg args[MOTH_FFI_MAX_TYPED_ARGS];
+
+  if (argc != ntv->argc) return FFI_RESULT_ARITY;
+
+  for (uint8_t i = 0; i < argc; i++) {
+    if (!unbox_arg(ntv->sig[i + 1], argv[i], &args[i])) {
+      return FFI_RESULT_TYPES;
+    }
+  }
+
+  *ret = box_ret(ntv->sig[0], ntv->tramp(ntv->fun, args));
+
+  return FFI_RESULT_OK;
+}
+
+Value ffi_ntv_call_typed(ObjectFFINative *ntv, Value *argv) {
+  FFIArg args[MOTH_FFI_MAX_TYPED_ARGS];
+
+  // Ints, reals & strings are held by a value the way the
+  // trampolines take them, typed arguments are passed as they are
+  for (uint8_t i = 0; i < ntv->argc; i++) {
+    memcpy(&args[i], &argv[i].as, sizeof(FFIArg));
+  }
+
+  return box_ret(ntv->sig[0], ntv->tramp(ntv->fun, args));
+}
+
+//       _ _ _                                                     //
+//      | | | |                                                    //
+//    __| | | |___                                                 //
+//   / _` | | / __|                                                //
+//  | (_| | | \__ \                                                //
+//   \__,_|_|_|___/                                                //
+//                                                                 //
+//                                                                 //
+
+static void *dll_open(const char *path) {
+#ifdef _WIN32
+  return (void *)LoadLibraryA(path);
+#else
+  return dlopen(path, RTLD_NOW | RTLD_LOCAL);
+#endif
+}
+
+void *ffi_dll_open(const char *name) {
+  char path[DLL_NAME_MAX];
+
+  // Try the decorated name first (`m` -> `libm.so`),
+  // and then the name exactly as it was written
+  snprintf(path, DLL_NAME_MAX, DLL_PREFIX "%s" DLL_SUFFIX, name);
+
+  void *dll = dll_open(path);
+  return dll ? dll : dll_open(name);
+}
+
+void *ffi_dll_symbol(void *dll, const char *name) {
+#ifdef _WIN32
+  return (void *)GetProcAddress((HMODULE)dll, name);
+#else
+  return dlsym(dll, name);
+#endif
+}
+
+bool ffi_dll_is_library(void *dll) {
+  return ffi_dll_symbol(dll, MOTH_FFI_LIBRARY_MARKER) != NULL;
+}
@@ -1,5 +1,41 @@
 /**
- *  Here's the structure of the bytecode file:
+ *  Here's the structure of the bytecode file (version 4):
+ *   - "SILKEXE"
+ *   - version, 2 bytes
+ *   - flags, 1 byte (bit 0 is set for wordcode programs)
+ *   - padding, 2 bytes
+ *   - checksum, 4 bytes (CRC32C of everything after the
+ *     header up to the footer, followed by the flags)
+ *   - section count [c], 4 bytes
+ *   ~~ [c] section entries, 16 bytes each
+ *      - kind, 4 bytes
+ *      - record count, 4 bytes
+ *      - offset in the file, 4 bytes
+ *      - size in bytes, 4 bytes
+ *   ~~ sections, each aligned to 8 bytes
+ *      - code: instructions, 1 byte each (or 4 byte little
+ *        endian words, see opcode.h)
+ *      - rodata: values, 16 bytes each
+ *          - type, 1 byte; object type, 1 byte; unused, 6 bytes
+ *          - payload, 8 bytes (string offset, function index,
+ *            integer index or real index)
+ *      - symbols: 8 bytes each, string offset & hash
+ *      - functions: 8 bytes each, offset & length of the
+ *        body in the section, followed by the bodies
+ *      - strings: NUL terminated strings
+ *      - integers: 8 bytes each, two's complement
+ *      - reals: 8 bytes each, IEEE-754 binary64 bits
+ *   - "SILKEND"
+ *
+ *  Version 3 files have no flags, their checksum only covers
+ *  what comes after the header. Version 2 files are checksummed
+ *  by hashing the instructions
+ *  and the symbols instead. Version 1 files also have no integer
+ *  & real sections, integers are stored in the rodata payload and
+ *  reals as a fixed point number (4 bytes integral part, 4 bytes
+ *  fraction).
+ *
+ *  Version 0 files are still read and can be written:
  *   - "SILKEXE"
  *   - version, 2 byte
  *   - instruction count [n], 4 bytes
@@ -13,11 +49,32 @@
  */
 #include <moth/file.h>
 
+#include <errno.h>
+#include <limits.h>
 #include <math.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  #include <nmmintrin.h>
+  #define CRC32C_SSE42
+#endif
+
+#ifdef _WIN32
+  #include <fcntl.h>
+  #include <io.h>
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <pthread.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <sys/uio.h>
+  #include <unistd.h>
+#endif
+
 #include <moth/macros.h>
 #include <moth/mem.h>
 #include <moth/object.h>
@@ -25,9 +82,69 @@
 #include <moth/value.h>
 
 static const char *   header  = "SILKEXE";
-static const uint16_t version = 0;
+static const uint16_t version = 4;
 static const char *   footer  = "SILKEND";
 
+// Flags of version 4 files
+#define FLAG_WORDCODE 0x1
+
+// Sections of version 1 to 4 files, readers skip
+// kinds they don't know about
+typedef enum {
+  SECTION_CODE,
+  SECTION_RODATA,
+  SECTION_SYMBOLS,
+  SECTION_FUNCTIONS,
+  SECTION_STRINGS,
+  SECTION_INTEGERS, // since version 2
+  SECTION_REALS,    // since version 2
+  SECTION_COUNT,
+
+  SECTION_DEBUG = 0x100, // reserved for debug information
+} SectionKind;
+
+// Size of one record of each section
+static const uint32_t section_records[SECTION_COUNT] = {
+  [SECTION_CODE]      = 1,
+  [SECTION_RODATA]    = 16,
+  [SECTION_SYMBOLS]   = 8,
+  [SECTION_FUNCTIONS] = 8,
+  [SECTION_STRINGS]   = 1,
+  [SECTION_INTEGERS]  = 8,
+  [SECTION_REALS]     = 8,
+};
+
+#define HEADER_SIZE        20
+#define FLAGS_OFFSET       9
+#define CHECKSUM_OFFSET    12
+#define SECTION_ENTRY_SIZE 16
+#define SECTION_ALIGN      8
+
+#define SET_ERR(to_what)                                                       \
+  if (err) { *err = to_what; }
+
+#define MALFORMED() SET_ERR("malformed silk executable");
+
+#define MALFORMED_EOF()                                                        \
+  if (cur->eof || cur->ptr == cur->end) {                                      \
+    MALFORMED();                                                               \
+    return;                                                                    \
+  }
+
+#define SWAP_IF_BIG_ENDIAN(x)                                                  \
+  if (IS_BIG_ENDIAN) { x = SWAP_BYTES(x); }
+
+//        _               _                                        //
+//       | |             | |                                       //
+//    ___| |__   ___  ___| | _____ _   _ _ __ ___  ___             //
+//   / __| '_ \ / _ \/ __| |/ / __| | | | '_ ` _ \/ __|            //
+//  | (__| | | |  __/ (__|   <\__ \ |_| | | | | | \__ \            //
+//   \___|_| |_|\___|\___|_|\_\___/\__,_|_| |_| |_|___/            //
+//                                                                 //
+//                                                                 //
+
+// Checksum of version 0 to 2 files, only covers
+// the instructions and the symbols
 uint32_t checksum(Program *prog) {
   uint32_t x = 2166136261u;
 
@@ -44,29 +161,465 @@ uint32_t checksum(Program *prog) {
   return x;
 }
 
-#define SET_ERR(to_what)                                                       \
-  if (err) { *err = to_what; }
+// CRC32C (Castagnoli) is computed with the crc32 instruction
+// where SSE 4.2 is available, otherwise with lookup tables that
+// consume 8 bytes at a time (slicing by 8)
 
-#define MALFORMED() SET_ERR("malformed silk executable");
+#define CRC32C_POLY 0x82F63B78u
 
-#define MALFORMED_EOF()                                                        \
-  if (feof(f)) {                                                               \
-    MALFORMED();                                                               \
-    return;                                                                    \
+typedef uint32_t (*CRC32C)(uint32_t, const uint8_t *, size_t);
+
+static uint32_t crc_table[8][256];
+
+static void init_crc_table(void) {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (CRC32C_POLY & -(crc & 1));
+    }
+
+    crc_table[0][i] = crc;
   }
 
-#define SWAP_IF_BIG_ENDIAN(x)                                                  \
-  if (IS_BIG_ENDIAN) { x = SWAP_BYTES(x); }
+  for (uint32_t i = 0; i < 256; i++) {
+    for (int t = 1; t < 8; t++) {
+      uint32_t prev   = crc_table[t - 1][i];
+      crc_table[t][i] = (prev >> 8) ^ crc_table[0][prev & 0xFF];
+    }
+  }
+}
 
-static uint8_t read_u8(FILE *f) {
-  return fgetc(f);
+static uint32_t crc32c_table(uint32_t crc, const uint8_t *data, size_t len) {
+  for (; len >= 8; data += 8, len -= 8) {
+    uint64_t word = 0;
+    memcpy(&word, data, sizeof(uint64_t));
+    SWAP_IF_BIG_ENDIAN(word);
+    word ^= crc;
+
+    crc = crc_table[7][word & 0xFF] ^ crc_table[6][(word >> 8) & 0xFF] ^
+          crc_table[5][(word >> 16) & 0xFF] ^
+          crc_table[4][(word >> 24) & 0xFF] ^
+          crc_table[3][(word >> 32) & 0xFF] ^
+          crc_table[2][(word >> 40) & 0xFF] ^
+          crc_table[1][(word >> 48) & 0xFF] ^ crc_table[0][word >> 56];
+  }
+
+  for (; len; data++, len--) {
+    crc = (crc >> 8) ^ crc_table[0][(crc ^ *data) & 0xFF];
+  }
+
+  return crc;
+}
+
+#ifdef CRC32C_SSE42
+__attribute__((target("sse4.2"))) static uint32_t
+crc32c_sse42(uint32_t crc, const uint8_t *data, size_t len) {
+  uint64_t crc64 = crc;
+
+  for (; len >= 8; data += 8, len -= 8) {
+    uint64_t word = 0;
+    memcpy(&word, data, sizeof(uint64_t));
+    crc64 = _mm_crc32_u64(crc64, word);
+  }
+
+  crc = (uint32_t)crc64;
+
+  for (; len; data++, len--) {
+    crc = _mm_crc32_u8(crc, *data);
+  }
+
+  return crc;
+}
+#endif
+
+static CRC32C select_crc32c(void) {
+#ifdef CRC32C_SSE42
+  if (__builtin_cpu_supports("sse4.2")) return crc32c_sse42;
+#endif
+
+  init_crc_table();
+  return crc32c_table;
+}
+
+// The implementation is picked once, by whichever thread
+// computes a crc first
+static CRC32C crc_impl = NULL;
+
+#ifdef _WIN32
+static INIT_ONCE crc_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK select_once(PINIT_ONCE once, PVOID arg, PVOID *ctx) {
+  crc_impl = select_crc32c();
+  return TRUE;
+}
+#else
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void select_once(void) {
+  crc_impl = select_crc32c();
+}
+#endif
+
+// The crc of a buffer can be continued with the next
+// buffer by passing in the crc returned so far
+uint32_t crc32c(uint32_t crc, const uint8_t *data, size_t len) {
+#ifdef _WIN32
+  InitOnceExecuteOnce(&crc_once, select_once, NULL, NULL);
+#else
+  pthread_once(&crc_once, select_once);
+#endif
+
+  return ~crc_impl(~crc, data, len);
+}
+
+//   _                                                             //
+//  (_)                                                            //
+//   _ _ __ ___   __ _  __ _  ___                                  //
+//  | | '_ ` _ \ / _` |/ _` |/ _ \                                 //
+//  | | | | | | | (_| | (_| |  __/                                 //
+//  |_|_| |_| |_|\__,_|\__, |\___|                                 //
+//                      __/ |                                      //
+//                     |___/                                       //
+
+// The executable is mapped read only and private, instructions
+// and strings are used in place so every process running the
+// same program shares the same physical pages.
+
+// Identifies the contents of a file without reading it
+typedef struct {
+  uint64_t size;
+  uint64_t mtime; // last modification, in nanoseconds
+  uint64_t inode;
+} Stamp;
+
+static uint8_t *map_stamped(const char *file, size_t *len, Stamp *stamp) {
+#ifdef _WIN32
+  HANDLE f = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, NULL,
+                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (f == INVALID_HANDLE_VALUE) return NULL;
+
+  BY_HANDLE_FILE_INFORMATION info;
+  if (!GetFileInformationByHandle(f, &info)) {
+    CloseHandle(f);
+    return NULL;
+  }
+
+  ULARGE_INTEGER size  = {.LowPart = info.nFileSizeLow,
+                          .HighPart = info.nFileSizeHigh};
+  ULARGE_INTEGER mtime = {.LowPart = info.ftLastWriteTime.dwLowDateTime,
+                          .HighPart = info.ftLastWriteTime.dwHighDateTime};
+  ULARGE_INTEGER inode = {.LowPart = info.nFileIndexLow,
+                          .HighPart = info.nFileIndexHigh};
+
+  if (size.QuadPart == 0) {
+    CloseHandle(f);
+    return NULL;
+  }
+
+  *stamp = (Stamp){
+    .size  = size.QuadPart,
+    .mtime = mtime.QuadPart * 100,
+    .inode = inode.QuadPart,
+  };
+
+  HANDLE map = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(f);
+  if (!map) return NULL;
+
+  // The view keeps the mapping alive
+  void *img = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(map);
+  if (!img) return NULL;
+
+  *len = (size_t)size.QuadPart;
+  return img;
+#else
+  int fd = open(file, O_RDONLY);
+  if (fd < 0) return NULL;
+
+  struct stat st;
+  if (fstat(fd, &st) < 0 || st.st_size == 0) {
+    close(fd);
+    return NULL;
+  }
+
+  #ifdef __APPLE__
+  struct timespec mtime = st.st_mtimespec;
+  #else
+  struct timespec mtime = st.st_mtim;
+  #endif
+
+  *stamp = (Stamp){
+    .size  = (uint64_t)st.st_size,
+    .mtime = (uint64_t)mtime.tv_sec * 1000000000u + mtime.tv_nsec,
+    .inode = (uint64_t)st.st_ino,
+  };
+
+  // The mapping stays valid after the descriptor is closed
+  void *img = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (img == MAP_FAILED) return NULL;
+
+  *len = (size_t)st.st_size;
+  return img;
+#endif
+}
+
+uint8_t *map_image(const char *file, size_t *len) {
+  Stamp stamp;
+  return map_stamped(file, len, &stamp);
+}
+
+void unmap_image(uint8_t *img, size_t len) {
+#ifdef _WIN32
+  UnmapViewOfFile(img);
+#else
+  munmap(img, len);
+#endif
+}
+
+// Executables whose checksum matched are remembered in the
+// cache directory of the compiler, a file is not checked again
+// by any process as long as its stamp & header are the same
+
+#define VERIFIED_MAX      64
+#define VERIFIED_PATH_MAX 1024
+
+typedef struct {
+  char     path[VERIFIED_PATH_MAX];
+  Stamp    stamp;
+  uint32_t crc; // of the header, which holds the checksum
+} Verified;
+
+#ifdef _WIN32
+static SRWLOCK verified_lock = SRWLOCK_INIT;
+  #define LOCK_VERIFIED()   AcquireSRWLockExclusive(&verified_lock)
+  #define UNLOCK_VERIFIED() ReleaseSRWLockExclusive(&verified_lock)
+#else
+static pthread_mutex_t verified_lock = PTHREAD_MUTEX_INITIALIZER;
+  #define LOCK_VERIFIED()   pthread_mutex_lock(&verified_lock)
+  #define UNLOCK_VERIFIED() pthread_mutex_unlock(&verified_lock)
+#endif
+
+// Same directory as the compile cache of the compiler
+static bool verified_dir(char *dir, size_t len) {
+  const char *env;
+  int         n = -1;
+
+  if ((env = getenv("SILK_CACHE_DIR"))) {
+    n = snprintf(dir, len, "%s", env);
+#ifdef _WIN32
+  } else if ((env = getenv("LOCALAPPDATA"))) {
+    n = snprintf(dir, len, "%s\\silk", env);
+#else
+  } else if ((env = getenv("XDG_CACHE_HOME"))) {
+    n = snprintf(dir, len, "%s/silk", env);
+  } else if ((env = getenv("HOME"))) {
+    n = snprintf(dir, len, "%s/.cache/silk", env);
+#endif
+  }
+
+  return n > 0 && (size_t)n < len;
+}
+
+static bool verified_path(char *path, size_t len, const char *name) {
+  char dir[VERIFIED_PATH_MAX];
+  if (!verified_dir(dir, sizeof(dir))) return false;
+
+  int n = snprintf(path, len, "%s/%s", dir, name);
+  return n > 0 && (size_t)n < len;
+}
+
+// Entries are stamps followed by the path, one per line
+static size_t load_verified(Verified *entries) {
+  char  path[VERIFIED_PATH_MAX];
+  FILE *f = verified_path(path, sizeof(path), "verified")
+              ? fopen(path, "r")
+              : NULL;
+
+  if (!f) return 0;
+
+  size_t n = 0;
+  char   line[VERIFIED_PATH_MAX + 80];
+
+  while (n < VERIFIED_MAX && fgets(line, sizeof(line), f)) {
+    Verified          *entry = entries + n;
+    unsigned long long size, mtime, inode;
+    unsigned           crc;
+    int                at = 0;
+
+    line[strcspn(line, "\n")] = '\0';
+
+    if (sscanf(line, "%llu %llu %llu %x %n", &size, &mtime, &inode, &crc,
+               &at) != 4 ||
+        strlen(line + at) >= VERIFIED_PATH_MAX) {
+      continue;
+    }
+
+    strcpy(entry->path, line + at);
+    entry->stamp = (Stamp){.size = size, .mtime = mtime, .inode = inode};
+    entry->crc   = crc;
+    n++;
+  }
+
+  fclose(f);
+  return n;
+}
+
+// Written to a file of this process first and moved in place,
+// readers see either the old entries or the new ones
+static void store_verified(const Verified *entries, size_t n) {
+  char path[VERIFIED_PATH_MAX];
+  char temp[VERIFIED_PATH_MAX + 32];
+  char dir[VERIFIED_PATH_MAX];
+
+  if (!verified_dir(dir, sizeof(dir))) return;
+  if (!verified_path(path, sizeof(path), "verified")) return;
+
+#ifdef _WIN32
+  CreateDirectoryA(dir, NULL);
+  snprintf(temp, sizeof(temp), "%s.%lu", path, GetCurrentProcessId());
+#else
+  mkdir(dir, 0700);
+  snprintf(temp, sizeof(temp), "%s.%ld", path, (long)getpid());
+#endif
+
+  FILE *f = fopen(temp, "w");
+  if (!f) return;
+
+  for (size_t i = 0; i < n; i++) {
+    fprintf(f, "%llu %llu %llu %08x %s\n",
+            (unsigned long long)entries[i].stamp.size,
+            (unsigned long long)entries[i].stamp.mtime,
+            (unsigned long long)entries[i].stamp.inode,
+            (unsigned)entries[i].crc, entries[i].path);
+  }
+
+  if (fclose(f) != 0) {
+    remove(temp);
+    return;
+  }
+
+#ifdef _WIN32
+  if (!MoveFileExA(temp, path, MOVEFILE_REPLACE_EXISTING)) remove(temp);
+#else
+  if (rename(temp, path) != 0) remove(temp);
+#endif
+}
+
+// Files are remembered by their absolute path, so the
+// same file is found from any working directory
+static bool verified_entry(const char *file, const uint8_t *img, size_t len,
+                           Stamp *stamp, Verified *entry) {
+#ifdef _WIN32
+  if (!_fullpath(entry->path, file, VERIFIED_PATH_MAX)) return false;
+#else
+  char real[PATH_MAX];
+  if (!realpath(file, real) || strlen(real) >= VERIFIED_PATH_MAX) {
+    return false;
+  }
+
+  strcpy(entry->path, real);
+#endif
+
+  if (strchr(entry->path, '\n')) return false;
+
+  entry->stamp = *stamp;
+  entry->crc   = crc32c(0, img, len < HEADER_SIZE ? len : HEADER_SIZE);
+  return true;
+}
+
+static bool is_verified(const char *file, const uint8_t *img, size_t len,
+                        Stamp *stamp) {
+  Verified want;
+  if (!verified_entry(file, img, len, stamp, &want)) return false;
+
+  // Any thread may get here, so not from the memory stack
+  Verified *entries = malloc(sizeof(Verified) * VERIFIED_MAX);
+  bool      found   = false;
+  if (!entries) return false;
+
+  LOCK_VERIFIED();
+  size_t n = load_verified(entries);
+  UNLOCK_VERIFIED();
+
+  for (size_t i = 0; i < n && !found; i++) {
+    found = strcmp(entries[i].path, want.path) == 0 &&
+            entries[i].stamp.size == want.stamp.size &&
+            entries[i].stamp.mtime == want.stamp.mtime &&
+            entries[i].stamp.inode == want.stamp.inode &&
+            entries[i].crc == want.crc;
+  }
+
+  free(entries);
+  return found;
+}
+
+static void remember_verified(const char *file, const uint8_t *img,
+                              size_t len, Stamp *stamp) {
+  Verified entry;
+  if (!verified_entry(file, img, len, stamp, &entry)) return;
+
+  Verified *entries = malloc(sizeof(Verified) * VERIFIED_MAX);
+  if (!entries) return;
+
+  LOCK_VERIFIED();
+  size_t n = load_verified(entries);
+
+  // The newest entry goes first, the oldest one
+  // falls off the end once the table is full
+  size_t kept = 0;
+  for (size_t i = 0; i < n && kept < VERIFIED_MAX - 1; i++) {
+    if (strcmp(entries[i].path, entry.path) != 0) entries[kept++] = entries[i];
+  }
+
+  memmove(entries + 1, entries, sizeof(Verified) * kept);
+  entries[0] = entry;
+  store_verified(entries, kept + 1);
+  UNLOCK_VERIFIED();
+
+  free(entries);
+}
+
+//                     _ _                                         //
+//                    | (_)                                        //
+//   _ __ ___  __ _  __| |_ _ __   __ _                            //
+//  | '__/ _ \/ _` |/ _` | | '_ \ / _` |                           //
+//  | | |  __/ (_| | (_| | | | | | (_| |                           //
+//  |_|  \___|\__,_|\__,_|_|_| |_|\__, |                           //
+//                                 __/ |                           //
+//                                |___/                            //
+
+typedef struct {
+  const uint8_t *ptr; // read position
+  const uint8_t *end; // end of the image
+  bool           eof; // tried reading past the end
+} Cursor;
+
+static const uint8_t *take(Cursor *cur, size_t n) {
+  if ((size_t)(cur->end - cur->ptr) < n) {
+    cur->eof = true;
+    cur->ptr = cur->end;
+    return NULL;
+  }
+
+  const uint8_t *at = cur->ptr;
+  cur->ptr += n;
+  return at;
+}
+
+static uint8_t read_u8(Cursor *cur) {
+  const uint8_t *at = take(cur, 1);
+  return at ? *at : 0;
 }
 
 #define DEFINE_READ(FUNCTION, TYPE)                                            \
-  static TYPE FUNCTION(FILE *f) {                                              \
-    TYPE   x    = 0;                                                           \
-    size_t read = fread(&x, sizeof(TYPE), 1, f);                               \
-    if (read != 1) return 0;                                                   \
+  static TYPE FUNCTION(Cursor *cur) {                                          \
+    TYPE           x  = 0;                                                     \
+    const uint8_t *at = take(cur, sizeof(TYPE));                               \
+    if (!at) return 0;                                                         \
+    memcpy(&x, at, sizeof(TYPE));                                              \
     SWAP_IF_BIG_ENDIAN(x);                                                     \
     return x;                                                                  \
   }
@@ -75,40 +628,35 @@ DEFINE_READ(read_u16, uint16_t);
 DEFINE_READ(read_u32, uint32_t);
 DEFINE_READ(read_chr, wchar_t);
 DEFINE_READ(read_i64, int64_t);
+DEFINE_READ(read_u64, uint64_t);
 
-static double read_dbl(FILE *f) {
-  double integral = read_u32(f);
-  double fraction = read_u32(f);
+static double read_dbl(Cursor *cur) {
+  double integral = read_u32(cur);
+  double fraction = read_u32(cur);
   return integral + (fraction / 10E+10);
 }
 
-static char *read_str(FILE *f) {
-  if (feof(f)) return NULL;
-
-  long start = ftell(f);
-
-  while (true) {
-    if (feof(f)) return NULL;
-    if (read_u8(f) == 0x0) break;
-  }
-
-  long  str_len = ftell(f) - start;
-  char *str     = memory(NULL, 0, str_len * sizeof(char));
+// Strings are NUL terminated in the image, they
+// are borrowed from it instead of being copied
+static char *read_str(Cursor *cur) {
+  const uint8_t *nul = memchr(cur->ptr, 0x0, cur->end - cur->ptr);
 
-  fseek(f, start, SEEK_SET);
-  size_t read = fread(str, sizeof(char), str_len, f);
-
-  if (read != str_len) {
-    release(str, str_len * sizeof(char));
+  if (!nul) {
+    cur->eof = true;
+    cur->ptr = cur->end;
     return NULL;
   }
 
+  char *str = (char *)cur->ptr;
+  cur->ptr  = nul + 1;
   return str;
 }
 
-static void read_value(Value *x, FILE *f, const char **err) {
+// Version 0 ---------------------------------------------------------
+
+static void read_value(Value *x, Cursor *cur, const char **err) {
   MALFORMED_EOF();
-  x->type = read_u8(f);
+  x->type = read_u8(cur);
 
   switch (x->type) {
 
@@ -118,52 +666,55 @@ static void read_value(Value *x, FILE *f, const char **err) {
 
     case T_BOOL: {
       MALFORMED_EOF();
-      x->as.boolean = read_u8(f);
+      x->as.boolean = read_u8(cur);
       break;
     }
 
     case T_INT: {
       MALFORMED_EOF();
-      x->as.integer = read_i64(f);
+      x->as.integer = read_i64(cur);
       break;
     }
 
     case T_REAL: {
       MALFORMED_EOF();
-      x->as.real = read_dbl(f);
+      x->as.real = read_dbl(cur);
       break;
     }
 
     case T_CHAR: {
       MALFORMED_EOF();
-      x->as.charac = read_chr(f);
+      x->as.charac = read_chr(cur);
       break;
     }
 
     case T_STR: {
       MALFORMED_EOF();
-      x->as.string = read_str(f);
+      x->as.string = read_str(cur);
       break;
     }
 
     case T_OBJ: {
       MALFORMED_EOF();
-      ObjType type = read_u8(f);
+      ObjType type = read_u8(cur);
 
       switch (type) {
         case O_FUNCTION: {
           MALFORMED_EOF();
-          uint32_t len = read_u32(f);
+          uint32_t       len   = read_u32(cur);
+          const uint8_t *bytes = take(cur, len);
 
-          ObjectFunction *fct =
-            memory(NULL, 0x0, sizeof(ObjectFunction) + sizeof(uint8_t) * len);
+          // Bodies are stored inline with the values,
+          // so they are copied out of the image
+          ObjectFunction *fct = obj_fct_with_len(bytes ? len : 0);
+          x->as.object        = (Object *)fct;
 
-          fct->obj.type = type;
-          fct->len      = len;
-          x->as.object  = (Object *)fct;
-          size_t read   = fread(fct->bytes, sizeof(uint8_t), len, f);
+          if (!bytes) {
+            SET_ERR("malformed silk executable");
+            break;
+          }
 
-          if (read != len) SET_ERR("malformed silk executable");
+          memcpy(fct->bytes, bytes, len);
           break;
         }
 
@@ -172,71 +723,388 @@ static void read_value(Value *x, FILE *f, const char **err) {
       break;
     }
   }
+
+  if (cur->eof) MALFORMED();
 }
 
-void read_file(const char *file, Program *prog, const char **err) {
-  FILE *f = fopen(file, "r");
+static void read_v0(Cursor *cur, Program *prog, bool verify,
+                    const char **err) {
+  uint32_t ins_len = read_u32(cur);
+  uint32_t rod_len = read_u32(cur);
+  uint32_t sym_len = read_u32(cur);
 
-  if (!f) {
-    SET_ERR("file not found");
+  // Instructions are executed straight from the image
+  const uint8_t *ins = take(cur, ins_len);
+  MALFORMED_EOF();
+
+  prog->bytes = (uint8_t *)ins;
+  prog->len   = ins_len;
+
+  // Strings are borrowed from the image, only values
+  // that were decoded so far are counted
+  init_rodata(&prog->rod, rod_len);
+  init_symtable(&prog->stb, sym_len);
+  prog->rod.brw = true;
+  prog->stb.brw = true;
+  prog->rod.len = 0;
+  prog->stb.len = 0;
+
+  for (uint32_t i = 0; i < rod_len; i++) {
+    MALFORMED_EOF();
+    read_value(prog->rod.arr + i, cur, err);
+    prog->rod.len++;
+    if (err && *err) return;
+  }
+
+  for (uint32_t i = 0; i < sym_len; i++) {
+    MALFORMED_EOF();
+    Symbol *sym = prog->stb.arr + i;
+    sym->str    = read_str(cur);
+    sym->hash   = sym->str ? hash(sym->str) : 0;
+    prog->stb.len++;
+  }
+
+  if (cur->eof) {
+    MALFORMED();
     return;
+  }
+
+  // Check the checksum of the program
+  uint32_t check = read_u32(cur);
+  if (verify && check != checksum(prog)) MALFORMED();
+
+  // Finally check the footer of the file
+  const uint8_t *end = take(cur, strlen(footer));
+  if (!end || memcmp(end, footer, strlen(footer)) != 0) MALFORMED();
+}
+
+// Version 1 & 2 -----------------------------------------------------
+
+typedef struct {
+  const uint8_t *data;  // start of the section in the image
+  uint32_t       count; // number of records
+  uint32_t       size;  // size in bytes
+} Section;
+
+// Records are fixed width, a section is valid if
+// it fits in the image and holds all its records
+static bool read_sections(Cursor *cur, const uint8_t *img, size_t len,
+                          Section *sections) {
+  uint32_t count = read_u32(cur);
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t kind   = read_u32(cur);
+    uint32_t items  = read_u32(cur);
+    uint32_t offset = read_u32(cur);
+    uint32_t size   = read_u32(cur);
+
+    if (cur->eof) return false;
+    if ((uint64_t)offset + size > len) return false;
+
+    // Sections added by newer writers are skipped
+    if (kind >= SECTION_COUNT) continue;
+
+    if ((uint64_t)items * section_records[kind] > size) return false;
+
+    sections[kind] = (Section){
+      .data  = img + offset,
+      .count = items,
+      .size  = size,
+    };
+  }
+
+  return true;
+}
+
+static Cursor section_cursor(Section *section) {
+  return (Cursor){
+    .ptr = section->data,
+    .end = section->data + section->size,
+    .eof = false,
+  };
+}
+
+static char *section_str(Section *strings, uint64_t offset) {
+  if (offset >= strings->size) return NULL;
+  return (char *)strings->data + offset;
+}
+
+// Integers & reals are a contiguous array of 8 byte
+// little endian words, indexed by the rodata records
+static bool section_u64(Section *section, uint64_t index, uint64_t *x) {
+  if (index >= section->count) return false;
+
+  memcpy(x, section->data + index * sizeof(uint64_t), sizeof(uint64_t));
+  SWAP_IF_BIG_ENDIAN(*x);
+  return true;
+}
+
+static bool read_number(Value *x, Cursor *rec, Section *sections) {
+  uint64_t index = read_u64(rec);
+  uint64_t bits  = 0;
+
+  if (x->type == T_INT) {
+    if (!section_u64(&sections[SECTION_INTEGERS], index, &bits)) return false;
+    x->as.integer = (int64_t)bits;
   } else {
-    SET_ERR(NULL);
+    if (!section_u64(&sections[SECTION_REALS], index, &bits)) return false;
+    memcpy(&x->as.real, &bits, sizeof(double));
   }
 
-  for (size_t i = 0; i < strlen(header); i++) {
-    if (feof(f) || getc(f) != header[i]) {
-      MALFORMED();
-      return;
+  return true;
+}
+
+static bool read_record(Value *x, Cursor *rec, uint16_t ver, Section *sections,
+                        ObjectFunction **functions, uint32_t fct_len) {
+  x->type      = read_u8(rec);
+  ObjType type = read_u8(rec);
+
+  // Unused, reserved for larger values
+  read_u16(rec);
+  read_u32(rec);
+
+  // Numbers are only stored in the payload in version 1
+  if ((x->type == T_INT || x->type == T_REAL) && ver >= 2) {
+    return read_number(x, rec, sections);
+  }
+
+  switch (x->type) {
+    case T_VOID: read_u64(rec); return true;
+    case T_BOOL: x->as.boolean = read_u64(rec); return true;
+    case T_INT: x->as.integer = read_i64(rec); return true;
+    case T_REAL: x->as.real = read_dbl(rec); return true;
+    case T_CHAR: x->as.charac = read_u64(rec); return true;
+
+    case T_STR: {
+      x->as.string = section_str(&sections[SECTION_STRINGS], read_u64(rec));
+      return x->as.string != NULL;
     }
+
+    case T_OBJ: {
+      uint64_t index = read_u64(rec);
+      if (type != O_FUNCTION || index >= fct_len) return false;
+      if (!functions[index]) return false;
+
+      // The value owns the function from now on
+      x->as.object     = (Object *)functions[index];
+      functions[index] = NULL;
+      return true;
+    }
+
+    default: return false;
   }
+}
+
+// Version 3 checksums everything after the header, version
+// 4 also the flags which change how the code is read
+static uint32_t image_checksum(const uint8_t *img, size_t len, uint16_t ver) {
+  uint32_t crc =
+    crc32c(0, img + HEADER_SIZE, len - HEADER_SIZE - strlen(footer));
 
-  if (read_u16(f) != version) {
+  if (ver >= 4) crc = crc32c(crc, img + FLAGS_OFFSET, 1);
+  return crc;
+}
+
+static void read_sectioned(Cursor *cur, Program *prog, uint16_t ver,
+                           bool verify, const char **err) {
+  const uint8_t *img = prog->img;
+  size_t         len = prog->iml;
+
+  // Flags are padding before version 4
+  uint8_t flags = read_u8(cur);
+  take(cur, 2);
+
+  if (ver >= 4 && (flags & ~FLAG_WORDCODE)) {
     MALFORMED();
     return;
   }
 
-  uint32_t ins_len = read_u32(f);
-  uint32_t rod_len = read_u32(f);
-  uint32_t sym_len = read_u32(f);
-  init_program(prog, ins_len, rod_len, sym_len);
+  prog->wcd = ver >= 4 && (flags & FLAG_WORDCODE);
 
-  for (uint32_t i = 0; i < ins_len; i++) {
-    MALFORMED_EOF();
-    prog->bytes[i] = read_u8(f);
+  uint32_t check                   = read_u32(cur);
+  Section  sections[SECTION_COUNT] = {0};
+
+  if (!read_sections(cur, img, len, sections)) {
+    MALFORMED();
+    return;
   }
 
-  for (uint32_t i = 0; i < rod_len; i++) {
-    MALFORMED_EOF();
-    read_value(prog->rod.arr + i, f, err);
-    if (*err) return;
+  Section *code      = &sections[SECTION_CODE];
+  Section *rodata    = &sections[SECTION_RODATA];
+  Section *symbols   = &sections[SECTION_SYMBOLS];
+  Section *functions = &sections[SECTION_FUNCTIONS];
+  Section *strings   = &sections[SECTION_STRINGS];
+
+  // Every string offset is valid if the pool is terminated
+  if (strings->size && strings->data[strings->size - 1] != 0x0) {
+    MALFORMED();
+    return;
   }
 
-  for (uint32_t i = 0; i < sym_len; i++) {
-    MALFORMED_EOF();
-    Symbol *sym = prog->stb.arr + i;
-    sym->str    = read_str(f);
-    sym->hash   = hash(sym->str);
+  if (!code->data) {
+    MALFORMED();
+    return;
   }
 
-  // Check the checksum of the program
-  if (read_u32(f) != checksum(prog)) MALFORMED();
+  prog->bytes = (uint8_t *)code->data;
+  prog->len   = code->count;
 
-  // Finally check the footer of the file
-  for (size_t i = 0; i < strlen(footer); i++) {
-    if (feof(f) || getc(f) != footer[i]) {
-      MALFORMED();
-      return;
-    }
+  // Functions only get a header pointing at their body in the
+  // image, a body is paged in the first time it is called
+  ObjectFunction **fcts =
+    memory(NULL, 0x0, sizeof(ObjectFunction *) * (functions->count + 1));
+
+  Cursor   table   = section_cursor(functions);
+  uint32_t fct_len = 0;
+
+  for (; fct_len < functions->count; fct_len++) {
+    uint32_t offset = read_u32(&table);
+    uint32_t length = read_u32(&table);
+
+    if ((uint64_t)offset + length > functions->size) break;
+
+    uint8_t *body = (uint8_t *)functions->data + offset;
+    fcts[fct_len] = obj_fct_from_image(body, length);
   }
 
-  fclose(f);
+  init_rodata(&prog->rod, rodata->count);
+  init_symtable(&prog->stb, symbols->count);
+  prog->rod.brw = true;
+  prog->stb.brw = true;
+  prog->rod.len = 0;
+  prog->stb.len = 0;
+
+  Cursor rec = section_cursor(rodata);
+  bool   ok  = fct_len == functions->count;
+
+  for (uint32_t i = 0; ok && i < rodata->count; i++) {
+    ok = read_record(prog->rod.arr + i, &rec, ver, sections, fcts, fct_len);
+    if (ok) prog->rod.len++;
+  }
+
+  // Functions not referenced by any value would leak
+  for (uint32_t i = 0; i < fct_len; i++) {
+    if (fcts[i]) free_object((Object *)fcts[i]);
+  }
+
+  release(fcts, sizeof(ObjectFunction *) * (functions->count + 1));
+
+  Cursor sym = section_cursor(symbols);
+
+  for (uint32_t i = 0; ok && i < symbols->count; i++) {
+    Symbol *symbol = prog->stb.arr + i;
+    symbol->str    = section_str(strings, read_u32(&sym));
+    symbol->hash   = read_u32(&sym);
+
+    ok = symbol->str != NULL;
+    if (ok) prog->stb.len++;
+  }
+
+  if (!ok) {
+    MALFORMED();
+    return;
+  }
+
+  // The footer closes the file, after every section
+  if (len < HEADER_SIZE + strlen(footer) ||
+      memcmp(img + len - strlen(footer), footer, strlen(footer)) != 0) {
+    MALFORMED();
+    return;
+  }
+
+  if (!verify) return;
+
+  uint32_t sum = ver >= 3 ? image_checksum(img, len, ver) : checksum(prog);
+  if (check != sum) MALFORMED();
+}
+
+void read_file(const char *file, Program *prog, const char **err) {
+  read_file_verify(file, prog, VERIFY_CACHED, err);
+}
+
+void read_file_verify(
+  const char *file, Program *prog, Verify mode, const char **err) {
+  Stamp    stamp = {0};
+  size_t   len   = 0;
+  uint8_t *img   = map_stamped(file, &len, &stamp);
+
+  // The program owns the image from now on, even if
+  // it turns out to be malformed
+  init_program(prog, 0, 0, 0);
+
+  if (!img) {
+    SET_ERR("file not found");
+    return;
+  } else {
+    SET_ERR(NULL);
+  }
+
+  prog->img = img;
+  prog->iml = len;
+
+  Cursor  cursor = {.ptr = img, .end = img + len, .eof = false};
+  Cursor *cur    = &cursor;
+
+  const uint8_t *magic = take(cur, strlen(header));
+  if (!magic || memcmp(magic, header, strlen(header)) != 0) {
+    MALFORMED();
+    return;
+  }
+
+  bool verify = mode == VERIFY_ALWAYS ||
+                (mode == VERIFY_CACHED && !is_verified(file, img, len, &stamp));
+
+  switch (read_u16(cur)) {
+    case 0: read_v0(cur, prog, verify, err); break;
+    case 1: read_sectioned(cur, prog, 1, verify, err); break;
+    case 2: read_sectioned(cur, prog, 2, verify, err); break;
+    case 3: read_sectioned(cur, prog, 3, verify, err); break;
+    case 4: read_sectioned(cur, prog, 4, verify, err); break;
+    default: MALFORMED(); return;
+  }
+
+  if (err && *err) return;
+  if (verify) remember_verified(file, img, len, &stamp);
+
+  // Resolve builtins now that all symbols are known
+  link_program(prog);
+}
+
+//                    _ _   _                                      //
+//                   (_) | (_)                                     //
+//  __      ___ __ _ _| |_ _ _ __   __ _                           //
+//  \ \ /\ / / '__| | | __| | '_ \ / _` |                          //
+//   \ V  V /| |  | | | |_| | | | | (_| |                          //
+//    \_/\_/ |_|  |_|_|\__|_|_| |_|\__, |                          //
+//                                  __/ |                          //
+//                                 |___/                           //
+
+// Every part of the executable is serialized to memory first,
+// the parts are then written with a single call
+
+typedef struct {
+  uint8_t *ptr;
+  size_t   len;
+  size_t   cap;
+} Buffer;
+
+static void put(Buffer *buf, const void *data, size_t n) {
+  if (buf->len + n > buf->cap) {
+    size_t cap = buf->cap;
+    while (cap < buf->len + n) cap = GROW_CAP(cap);
+
+    buf->ptr = memory(buf->ptr, buf->cap, cap);
+    buf->cap = cap;
+  }
+
+  memcpy(buf->ptr + buf->len, data, n);
+  buf->len += n;
 }
 
 #define DEFINE_WRITE(FUNCTION, TYPE)                                           \
-  static void FUNCTION(TYPE t, FILE *f) {                                      \
+  static void FUNCTION(TYPE t, Buffer *buf) {                                  \
     SWAP_IF_BIG_ENDIAN(t);                                                     \
-    fwrite(&t, sizeof(TYPE), 1, f);                                            \
+    put(buf, &t, sizeof(TYPE));                                                \
   }
 
 DEFINE_WRITE(write_u8, uint8_t);
@@ -244,31 +1112,61 @@ DEFINE_WRITE(write_u16, uint16_t);
 DEFINE_WRITE(write_u32, uint32_t);
 DEFINE_WRITE(write_chr, wchar_t);
 DEFINE_WRITE(write_i64, int64_t);
+DEFINE_WRITE(write_u64, uint64_t);
 
-static void write_dbl(double d, FILE *f) {
+static void write_dbl(double d, Buffer *buf) {
   double ingr, frac;
   frac = modf(d, &ingr);
 
   uint32_t integral = ingr;
   uint32_t fraction = frac * 10E+10;
 
-  write_u32(integral, f);
-  write_u32(fraction, f);
+  write_u32(integral, buf);
+  write_u32(fraction, buf);
 }
 
-static void write_str(const char *s, FILE *f) {
-  fwrite(s, sizeof(char), strlen(s), f);
-  write_u8(0x0, f);
+static void write_str(const char *s, Buffer *buf) {
+  put(buf, s, strlen(s) + 1);
 }
 
-static void write_obj(Object *obj, FILE *f) {
-  write_u8(obj->type, f);
+// The parts of an executable, in the order they are written
+#define PARTS_MAX (SECTION_COUNT + 2)
+
+typedef struct {
+  Buffer parts[PARTS_MAX];
+  size_t len;
+} Output;
+
+static Buffer *next_part(Output *out) {
+  Buffer *part = out->parts + out->len++;
+  *part        = (Buffer){.ptr = NULL, .len = 0, .cap = 0};
+  return part;
+}
+
+static size_t output_size(Output *out) {
+  size_t size = 0;
+  for (size_t i = 0; i < out->len; i++) size += out->parts[i].len;
+  return size;
+}
+
+static void free_output(Output *out) {
+  for (size_t i = 0; i < out->len; i++) {
+    release(out->parts[i].ptr, out->parts[i].cap);
+  }
+
+  out->len = 0;
+}
+
+// Version 0 ---------------------------------------------------------
+
+static void write_obj(Object *obj, Buffer *buf) {
+  write_u8(obj->type, buf);
   switch (obj->type) {
 
     case O_FUNCTION: {
       ObjectFunction *fct = OBJ_FCT(obj);
-      write_u32(fct->len, f);
-      fwrite(fct->bytes, sizeof(uint8_t), fct->len, f);
+      write_u32(fct->len, buf);
+      put(buf, fct->bytes, fct->len);
       break;
     }
 
@@ -276,52 +1174,377 @@ static void write_obj(Object *obj, FILE *f) {
   }
 }
 
-static void write_value(Value v, FILE *f) {
-  write_u8(v.type, f);
+static void write_value(Value v, Buffer *buf) {
+  write_u8(v.type, buf);
   switch (v.type) {
-    case T_BOOL: return write_u8(v.as.boolean, f);
-    case T_INT: return write_i64(v.as.integer, f);
-    case T_REAL: return write_dbl(v.as.real, f);
-    case T_CHAR: return write_chr(v.as.charac, f);
-    case T_STR: return write_str(v.as.string, f);
-    case T_OBJ: return write_obj(v.as.object, f);
+    case T_BOOL: return write_u8(v.as.boolean, buf);
+    case T_INT: return write_i64(v.as.integer, buf);
+    case T_REAL: return write_dbl(v.as.real, buf);
+    case T_CHAR: return write_chr(v.as.charac, buf);
+    case T_STR: return write_str(v.as.string, buf);
+    case T_OBJ: return write_obj(v.as.object, buf);
     default: return;
   }
 }
 
-static void write_symbol(Symbol sy, FILE *f) {
-  write_str(sy.str, f);
+static void write_symbol(Symbol sy, Buffer *buf) {
+  write_str(sy.str, buf);
 }
 
-void write_file(const char *file, Program *prog, const char **err) {
-  FILE *f = fopen(file, "w");
-  if (!f) {
-    SET_ERR("could not find file");
-    return;
+static void write_v0(Program *prog, Output *out) {
+  Buffer *buf = next_part(out);
+
+  write_u32(prog->len, buf);
+  write_u32(prog->rod.len, buf);
+  write_u32(prog->stb.len, buf);
+
+  put(buf, prog->bytes, prog->len);
+
+  for (uint32_t i = 0; i < prog->rod.len; i++) {
+    write_value(prog->rod.arr[i], buf);
   }
 
-  fwrite(header, strlen(header), 1, f);
-  write_u16(version, f);
+  for (uint32_t i = 0; i < prog->stb.len; i++) {
+    write_symbol(prog->stb.arr[i], buf);
+  }
+
+  // Write the checksum to the program
+  write_u32(checksum(prog), buf);
+}
+
+// Version 1 to 4 ----------------------------------------------------
+
+#define SECTION_ALIGNED(X) (((X) + SECTION_ALIGN - 1) & ~(SECTION_ALIGN - 1))
+
+// Pads the part so the next one starts at an aligned offset
+static void write_padding(size_t offset, Buffer *buf) {
+  static const uint8_t zeros[SECTION_ALIGN] = {0};
+  put(buf, zeros, SECTION_ALIGNED(offset) - offset);
+}
+
+// Where the payload of the next record of each kind points to
+typedef struct {
+  uint64_t str; // offset in the string pool
+  uint64_t fct; // index in the function table
+  uint64_t itg; // index in the integer array
+  uint64_t rea; // index in the real array
+} Payloads;
 
-  write_u32(prog->len, f);
-  write_u32(prog->rod.len, f);
-  write_u32(prog->stb.len, f);
+static void write_record(Value v, uint16_t ver, Payloads *pay, Buffer *buf) {
+  write_u8(v.type, buf);
+  write_u8(v.type == T_OBJ ? v.as.object->type : 0, buf);
+  write_u16(0, buf);
+  write_u32(0, buf);
+
+  switch (v.type) {
+    case T_BOOL: return write_u64(v.as.boolean, buf);
+    case T_CHAR: return write_u64((uint32_t)v.as.charac, buf);
+
+    case T_INT: {
+      if (ver >= 2) return write_u64(pay->itg++, buf);
+      return write_i64(v.as.integer, buf);
+    }
+
+    case T_REAL: {
+      if (ver >= 2) return write_u64(pay->rea++, buf);
+      return write_dbl(v.as.real, buf);
+    }
+
+    case T_STR: {
+      write_u64(pay->str, buf);
+      pay->str += strlen(v.as.string) + 1;
+      return;
+    }
 
-  for (uint32_t i = 0; i < prog->len; i++) {
-    write_u8(prog->bytes[i], f);
+    case T_OBJ: {
+      write_u64(IS_OBJ_FCT(v) ? pay->fct++ : 0, buf);
+      return;
+    }
+
+    default: return write_u64(0, buf);
   }
+}
+
+static uint8_t flags_of(Program *prog) {
+  return prog->wcd ? FLAG_WORDCODE : 0x0;
+}
+
+// Each section is its own part, so no section
+// is copied again once it is serialized
+static void write_sections(Program *prog, uint16_t ver, Buffer *parts) {
+  Buffer * code   = parts + SECTION_CODE;
+  Buffer * rodata = parts + SECTION_RODATA;
+  Buffer * syms   = parts + SECTION_SYMBOLS;
+  Buffer * fcts   = parts + SECTION_FUNCTIONS;
+  Buffer * strs   = parts + SECTION_STRINGS;
+  Buffer * itgs   = parts + SECTION_INTEGERS;
+  Buffer * reas   = parts + SECTION_REALS;
+  Payloads pay    = {0};
+
+  put(code, prog->bytes, prog->len);
+
+  uint32_t fct_len = 0;
 
   for (uint32_t i = 0; i < prog->rod.len; i++) {
-    write_value(prog->rod.arr[i], f);
+    Value v = prog->rod.arr[i];
+    write_record(v, ver, &pay, rodata);
+
+    if (IS_OBJ_FCT(v)) fct_len += 1;
+    if (IS_STR(v)) write_str(v.as.string, strs);
+    if (IS_INT(v) && ver >= 2) write_i64(v.as.integer, itgs);
+
+    if (IS_REAL(v) && ver >= 2) {
+      // Numbers are stored bit for bit, reals are never rounded
+      uint64_t bits = 0;
+      memcpy(&bits, &v.as.real, sizeof(double));
+      write_u64(bits, reas);
+    }
   }
 
+  // Function offsets are relative to the section, the
+  // bodies follow right after the offset table
+  uint32_t body = fct_len * section_records[SECTION_FUNCTIONS];
+
+  for (uint32_t i = 0; i < prog->rod.len; i++) {
+    if (!IS_OBJ_FCT(prog->rod.arr[i])) continue;
+
+    uint32_t len = OBJ_FCT(prog->rod.arr[i].as.object)->len;
+    write_u32(body, fcts);
+    write_u32(len, fcts);
+    body += len;
+  }
+
+  for (uint32_t i = 0; i < prog->rod.len; i++) {
+    if (!IS_OBJ_FCT(prog->rod.arr[i])) continue;
+
+    ObjectFunction *fct = OBJ_FCT(prog->rod.arr[i].as.object);
+    put(fcts, fct->bytes, fct->len);
+  }
+
+  // Strings of values first, then the symbols
   for (uint32_t i = 0; i < prog->stb.len; i++) {
-    write_symbol(prog->stb.arr[i], f);
+    write_u32(pay.str, syms);
+    write_u32(hash(prog->stb.arr[i].str), syms);
+    write_str(prog->stb.arr[i].str, strs);
+    pay.str += strlen(prog->stb.arr[i].str) + 1;
   }
+}
 
-  // Write the checksum to the program
-  write_u32(checksum(prog), f);
+static void write_sectioned(Program *prog, uint16_t ver, Output *out) {
+  // Version 1 has no number sections
+  uint32_t sections = ver >= 2 ? SECTION_COUNT : SECTION_INTEGERS;
 
-  fwrite(footer, strlen(footer), 1, f);
-  fclose(f);
-}
\ No newline at end of file
+  Buffer *head   = next_part(out);
+  Buffer *parts  = out->parts + out->len;
+
+  for (uint32_t kind = 0; kind < sections; kind++) next_part(out);
+
+  write_sections(prog, ver, parts);
+
+  // Records are counted in bytes for code & strings
+  uint32_t counts[SECTION_COUNT] = {
+    [SECTION_CODE]      = prog->len,
+    [SECTION_RODATA]    = prog->rod.len,
+    [SECTION_SYMBOLS]   = prog->stb.len,
+    [SECTION_FUNCTIONS] = 0,
+    [SECTION_STRINGS]   = parts[SECTION_STRINGS].len,
+    [SECTION_INTEGERS]  = 0,
+    [SECTION_REALS]     = 0,
+  };
+
+  for (uint32_t i = 0; i < prog->rod.len; i++) {
+    Value v = prog->rod.arr[i];
+    if (IS_OBJ_FCT(v)) counts[SECTION_FUNCTIONS] += 1;
+    if (IS_INT(v)) counts[SECTION_INTEGERS] += 1;
+    if (IS_REAL(v)) counts[SECTION_REALS] += 1;
+  }
+
+  // Header, padded so the section table is aligned, the
+  // checksum of version 3 is filled in once the file is written
+  put(head, header, strlen(header));
+  write_u16(ver, head);
+  write_u8(ver >= 4 ? flags_of(prog) : 0x0, head);
+  write_u16(0x0, head);
+  write_u32(ver >= 3 ? 0x0 : checksum(prog), head);
+  write_u32(sections, head);
+
+  // Lay the sections out one after the other, aligned
+  size_t offset = SECTION_ALIGNED(HEADER_SIZE + sections * SECTION_ENTRY_SIZE);
+
+  for (uint32_t kind = 0; kind < sections; kind++) {
+    write_u32(kind, head);
+    write_u32(counts[kind], head);
+    write_u32(offset, head);
+    write_u32(parts[kind].len, head);
+
+    offset = SECTION_ALIGNED(offset + parts[kind].len);
+  }
+
+  write_padding(head->len, head);
+
+  for (uint32_t kind = 0; kind < sections; kind++) {
+    write_padding(parts[kind].len, parts + kind);
+  }
+
+  if (ver < 3) return;
+
+  // Everything after the header is checksummed, then the flags
+  uint32_t crc = crc32c(0, head->ptr + HEADER_SIZE, head->len - HEADER_SIZE);
+
+  for (size_t i = 1; i < out->len; i++) {
+    crc = crc32c(crc, out->parts[i].ptr, out->parts[i].len);
+  }
+
+  if (ver >= 4) {
+    uint8_t flags = flags_of(prog);
+    crc           = crc32c(crc, &flags, 1);
+  }
+
+  SWAP_IF_BIG_ENDIAN(crc);
+  memcpy(head->ptr + CHECKSUM_OFFSET, &crc, sizeof(uint32_t));
+}
+
+static void serialize(Program *prog, uint16_t ver, Output *out,
+                      const char **err) {
+  out->len = 0;
+
+  if (ver > version) {
+    SET_ERR("unsupported silk executable version");
+    return;
+  }
+
+  // Older readers would take the words for bytecode
+  if (prog->wcd && ver < 4) {
+    SET_ERR("wordcode needs silk executable version 4");
+    return;
+  }
+
+  SET_ERR(NULL);
+
+  if (ver == 0) {
+    Buffer *magic = next_part(out);
+    put(magic, header, strlen(header));
+    write_u16(ver, magic);
+    write_v0(prog, out);
+  } else {
+    write_sectioned(prog, ver, out);
+  }
+
+  put(next_part(out), footer, strlen(footer));
+}
+
+// Writes every part, short writes are continued
+static bool write_parts(int fd, Output *out) {
+#ifdef _WIN32
+  for (size_t i = 0; i < out->len; i++) {
+    const uint8_t *ptr = out->parts[i].ptr;
+    size_t         len = out->parts[i].len;
+
+    while (len > 0) {
+      int n = _write(fd, ptr, (unsigned)MIN(len, INT_MAX));
+      if (n <= 0) return false;
+
+      ptr += n;
+      len -= n;
+    }
+  }
+
+  return true;
+#else
+  struct iovec iov[PARTS_MAX];
+  size_t       len = 0;
+
+  for (size_t i = 0; i < out->len; i++) {
+    if (out->parts[i].len == 0) continue;
+
+    iov[len].iov_base = out->parts[i].ptr;
+    iov[len].iov_len  = out->parts[i].len;
+    len++;
+  }
+
+  for (struct iovec *at = iov; len > 0;) {
+    ssize_t n = writev(fd, at, len);
+
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+
+    // Skip what was written, part of a buffer may be left
+    for (; len > 0 && (size_t)n >= at->iov_len; at++, len--) {
+      n -= at->iov_len;
+    }
+
+    if (len > 0) {
+      at->iov_base = (uint8_t *)at->iov_base + n;
+      at->iov_len -= n;
+    }
+  }
+
+  return true;
+#endif
+}
+
+void write_file(const char *file, Program *prog, const char **err) {
+  write_file_version(file, prog, version, err);
+}
+
+void write_file_version(
+  const char *file, Program *prog, uint16_t ver, const char **err) {
+  Output out;
+  serialize(prog, ver, &out, err);
+
+  if (err && *err) return free_output(&out);
+
+#ifdef _WIN32
+  int fd = _open(file, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+  int fd = open(file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+
+  if (fd < 0) {
+    SET_ERR("could not find file");
+  } else if (!write_parts(fd, &out)) {
+    SET_ERR("could not write file");
+  }
+
+#ifdef _WIN32
+  if (fd >= 0) _close(fd);
+#else
+  if (fd >= 0) close(fd);
+#endif
+
+  free_output(&out);
+}
+
+void write_fd(int fd, Program *prog, const char **err) {
+  Output out;
+  serialize(prog, version, &out, err);
+
+  if (!(err && *err) && !write_parts(fd, &out)) {
+    SET_ERR("could not write file");
+  }
+
+  free_output(&out);
+}
+
+uint8_t *write_memory(Program *prog, size_t *len, const char **err) {
+  Output out;
+  serialize(prog, version, &out, err);
+
+  *len = 0;
+
+  if (err && *err) {
+    free_output(&out);
+    return NULL;
+  }
+
+  // The parts are joined, the image is a single allocation
+  uint8_t *img = memory(NULL, 0, output_size(&out));
+
+  for (size_t i = 0; i < out.len; i++) {
+    memcpy(img + *len, out.parts[i].ptr, out.parts[i].len);
+    *len += out.parts[i].len;
+  }
+
+  free_output(&out);
+  return img;
+}
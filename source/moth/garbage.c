@@ -65,13 +65,18 @@ static void mark_object(Object *obj) {
     case O_FFI_POINTER: {
       break;
     }
+
+    case O_FFI_NATIVE: {
+      break;
+    }
   }
 }
 
-void init_gc(GarbageCollector *gc, Stack *stk) {
+void init_gc(GarbageCollector *gc, Stack *stk, Environment *env) {
   gc->len  = 0;
   gc->cap  = GC_INIT_CAP;
   gc->stk  = stk;
+  gc->env  = env;
   gc->objs = memory(NULL, 0, sizeof(Object *) * GC_INIT_CAP);
 }
 
@@ -82,6 +87,12 @@ void gc_collect(GarbageCollector *gc) {
     mark_object(v->as.object);
   }
 
+  // ... and all values bound in the global environment
+  for (Entry *e = gc->env->ptr; e < gc->env->ptr + gc->env->cap; e++) {
+    if (e->key.str == NULL || e->value.type != T_OBJ) continue;
+    mark_object(e->value.as.object);
+  }
+
   // Free unreachable objects on the GC's registry
   for (Object **obj = gc->objs; obj < gc->objs + gc->len;) {
     if (!(*obj)->reachable) {
@@ -116,6 +127,20 @@ void gc_register(GarbageCollector *gc, Object *obj) {
   gc->len++;
 }
 
+void gc_reserve(GarbageCollector *gc, size_t n) {
+  // Registering the next n objects won't trigger a collection,
+  // so they can be registered before anything refers to them
+  if (gc->len + n < gc->cap) return;
+
+  size_t new_cap = gc->len + n + 1;
+
+  size_t new_size = sizeof(Object *) * new_cap;
+  size_t old_size = sizeof(Object *) * gc->cap;
+
+  gc->cap  = new_cap;
+  gc->objs = memory(gc->objs, old_size, new_size);
+}
+
 void free_gc(GarbageCollector *gc) {
   // Free all objects, we are done for today
   for (Object **obj = gc->objs; obj < gc->objs + gc->len; obj++) {
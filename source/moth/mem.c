@@ -7,7 +7,7 @@
 
 #define MEM_STACK_SIZE 2048
 
-static char  stack[MEM_STACK_SIZE];
+static _Alignas(8) char stack[MEM_STACK_SIZE];
 static void *top = stack;
 
 static const void *const bottom = stack + MEM_STACK_SIZE;
@@ -21,20 +21,23 @@ void *memory(void *ptr, size_t old_sz, size_t new_sz) {
 
   // Use malloc if the stack is full, or the new allocation
   // is over 32 bytes
-  if (top == bottom || new_sz > 32) {
-    // Release the stack storage
+  if (top + new_sz > bottom || new_sz > 32) {
+    // Move out of the stack storage
     if ((void *)stack <= ptr && ptr < bottom) {
+      void *new_ptr = malloc(new_sz);
+      memcpy(new_ptr, ptr, old_sz < new_sz ? old_sz : new_sz);
       release(ptr, old_sz);
-      ptr = NULL;
+      return new_ptr;
     }
 
     return realloc(ptr, new_sz);
   }
 
   void *new_ptr = top;
-  top += (new_sz > 8) ? new_sz : 8;
+  // Rounded up so every allocation stays 8 byte aligned
+  top += (new_sz + 7) & ~(size_t)7;
 
-  memcpy(new_ptr, ptr, old_sz);
+  if (ptr) memcpy(new_ptr, ptr, old_sz < new_sz ? old_sz : new_sz);
   release(ptr, old_sz);
 
   return new_ptr;
@@ -42,7 +45,7 @@ void *memory(void *ptr, size_t old_sz, size_t new_sz) {
 
 void release(void *ptr, size_t size) {
   // If the value is allocated outside of the memory stack
-  if (ptr < (void *)stack || bottom < ptr) return free(ptr);
+  if (ptr < (void *)stack || bottom <= ptr) return free(ptr);
 
   // TODO: deallocate memory on the Stack
   // if (stack <= (char*)ptr && (char*)ptr <= top) {
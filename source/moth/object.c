@@ -44,7 +44,12 @@ void free_object(Object *obj) {
     }
 
     case O_FUNCTION: {
-      obj_size = sizeof(ObjectFunction) + sizeof(uint8_t) * OBJ_FCT(obj)->len;
+      obj_size = sizeof(ObjectFunction);
+
+      // Bodies inside a mapped image are not owned
+      if (OBJ_FCT(obj)->bytes == (uint8_t *)(OBJ_FCT(obj) + 1)) {
+        obj_size += sizeof(uint8_t) * OBJ_FCT(obj)->len;
+      }
       break;
     }
 
@@ -68,6 +73,11 @@ void free_object(Object *obj) {
       obj_ffi_ptr_del(OBJ_FFI_PTR(obj));
       break;
     }
+
+    case O_FFI_NATIVE: {
+      obj_size = sizeof(ObjectFFINative);
+      break;
+    }
   }
 
   release(obj, obj_size);
@@ -119,6 +129,10 @@ bool equal_objects(Object *a, Object *b) {
     case O_FFI_POINTER: {
       return OBJ_FFI_PTR(a)->ptr == OBJ_FFI_PTR(b);
     }
+
+    case O_FFI_NATIVE: {
+      return OBJ_FFI_NTV(a)->fun == OBJ_FFI_NTV(b)->fun;
+    }
   }
 }
 
@@ -131,8 +145,9 @@ void print_object(Object *obj) {
     case O_FUNCTION: printf("{fun}"); break;
     case O_CLOSURE: printf("{closure}"); break;
     case O_HEAPVAL: print_value(OBJ_HPV(obj)->val); break;
-    case O_FFI_FUNCTION: printf("{ffi fun @ <%lxd>}", (long) OBJ_FFI_FUN(obj)->fun);
-    case O_FFI_POINTER: printf("{ffi ptr @ <%lxd>}", (long) OBJ_FFI_PTR(obj)->ptr);
+    case O_FFI_FUNCTION: printf("{ffi fun @ <%lxd>}", (long) OBJ_FFI_FUN(obj)->fun); break;
+    case O_FFI_POINTER: printf("{ffi ptr @ <%lxd>}", (long) OBJ_FFI_PTR(obj)->ptr); break;
+    case O_FFI_NATIVE: printf("{ffi fun %s @ <%lxd>}", OBJ_FFI_NTV(obj)->sig, (long) OBJ_FFI_NTV(obj)->fun); break;
   }
 }
 
@@ -418,6 +433,7 @@ static void obj_dct_resize(ObjectDictionary *obj, size_t new_n) {
   ObjectDictionaryEntry *old_entries = obj->entries;
 
   obj->cap     = GROW_CAP(new_n);
+  obj->len     = 0;
   obj->entries = memory(NULL, 0x0, sizeof(ObjectDictionaryEntry) * obj->cap);
 
   // Initialize all new entries to empty
@@ -440,14 +456,17 @@ static void obj_dct_resize(ObjectDictionary *obj, size_t new_n) {
 }
 
 void obj_dct_insert(ObjectDictionary *obj, Value key, Value value) {
-  uint32_t key_hash = hash_value(key);
+  obj_dct_insert_hashed(obj, key, hash_value(key), value);
+}
 
+size_t obj_dct_insert_hashed(
+  ObjectDictionary *obj, Value key, uint32_t hash, Value value) {
   if (obj->len + 1 > obj->cap * DICTIONARY_LOAD_FACTOR) {
     obj_dct_resize(obj, obj->len + 1);
   }
 
   ObjectDictionaryEntry *end   = obj->entries + obj->cap;
-  ObjectDictionaryEntry *entry = obj->entries + (key_hash % obj->cap);
+  ObjectDictionaryEntry *entry = obj->entries + (hash % obj->cap);
 
   while (!obj_dct_entry_empty(entry)) {
     if (equal_values(entry->key, key)) break;
@@ -456,8 +475,12 @@ void obj_dct_insert(ObjectDictionary *obj, Value key, Value value) {
     if (entry == end) entry = obj->entries;
   }
 
+  // Only new keys count towards the load factor
+  if (!obj_dct_entry_occupied(entry)) obj->len++;
+
   entry->key   = key;
   entry->value = value;
+  return entry - obj->entries;
 }
 
 bool obj_dct_has_key(ObjectDictionary *obj, Value key) {
@@ -465,19 +488,27 @@ bool obj_dct_has_key(ObjectDictionary *obj, Value key) {
 }
 
 Value obj_dct_get(ObjectDictionary *obj, Value key) {
-  uint32_t key_hash = hash_value(key);
+  size_t slot = obj_dct_find(obj, key);
+  return slot < obj->cap ? obj->entries[slot].value : VOID_VAL;
+}
+
+size_t obj_dct_find(ObjectDictionary *obj, Value key) {
+  return obj_dct_find_hashed(obj, key, hash_value(key));
+}
 
+size_t obj_dct_find_hashed(ObjectDictionary *obj, Value key, uint32_t hash) {
   ObjectDictionaryEntry *end   = obj->entries + obj->cap;
-  ObjectDictionaryEntry *entry = obj->entries + (key_hash % obj->cap);
+  ObjectDictionaryEntry *entry = obj->entries + (hash % obj->cap);
 
   while (!obj_dct_entry_empty(entry)) {
-    if (equal_values(entry->key, key)) return entry->value;
+    if (equal_values(entry->key, key)) return entry - obj->entries;
 
     entry++;
     if (entry == end) entry = obj->entries;
   }
 
-  return VOID_VAL;
+  // Missing keys have no slot
+  return obj->cap;
 }
 
 Value obj_dct_delete(ObjectDictionary *obj, Value key) {
@@ -535,6 +566,28 @@ void obj_dct_merge(ObjectDictionary *obj, ObjectDictionary *with) {
   }
 }
 
+ObjectFunction *obj_fct_with_len(size_t len) {
+  ObjectFunction *obj = (ObjectFunction *)alloc_object(
+    O_FUNCTION, sizeof(ObjectFunction) + sizeof(uint8_t) * len);
+
+  obj->len   = len;
+  obj->bytes = (uint8_t *)(obj + 1);
+  obj->arity = 0;
+  obj->depth = 0;
+  return obj;
+}
+
+ObjectFunction *obj_fct_from_image(uint8_t *bytes, size_t len) {
+  ObjectFunction *obj =
+    (ObjectFunction *)alloc_object(O_FUNCTION, sizeof(ObjectFunction));
+
+  obj->len   = len;
+  obj->bytes = bytes;
+  obj->arity = 0;
+  obj->depth = 0;
+  return obj;
+}
+
 ObjectClosure *obj_clj_from_fct(ObjectFunction *fct) {
   ObjectClosure *obj =
     (ObjectClosure *)alloc_object(O_CLOSURE, sizeof(ObjectClosure));
@@ -2,6 +2,8 @@
 
 #include <stdint.h>
 
+#include <moth/builtins.h>
+#include <moth/file.h>
 #include <moth/mem.h>
 #include <moth/rodata.h>
 #include <moth/symtable.h>
@@ -11,12 +13,31 @@ void init_program(
   prog->len   = init_len;
   prog->cap   = init_len;
   prog->bytes = init_len ? memory(NULL, 0, sizeof(uint8_t) * init_len) : NULL;
+  prog->wcd   = false;
+
+  // not mapped from a file
+  prog->img = NULL;
+  prog->iml = 0;
 
   // readonly data
   init_rodata(&prog->rod, rod_len);
 
   // symbol data
   init_symtable(&prog->stb, sym_len);
+
+  // not linked yet
+  prog->ntv = NULL;
+  prog->rdh = NULL;
+  prog->ntl = 0;
+  prog->rdl = 0;
+
+  // caches are created as call sites are reached
+  prog->icl = 0;
+  prog->ics = NULL;
+
+  // verified before it first runs
+  prog->vfd = false;
+  prog->msd = 0;
 }
 
 void write_byte(Program* prog, uint8_t byte) {
@@ -32,10 +53,20 @@ void write_byte(Program* prog, uint8_t byte) {
 
   prog->bytes[prog->len] = byte;
   prog->len++;
+  prog->vfd = false;
+}
+
+// Words are stored little endian whatever the host, so
+// images can be run in place on any machine
+void write_word(Program* prog, uint32_t word) {
+  for (int i = 0; i < 4; i++) {
+    write_byte(prog, (word >> (8 * i)) & 0xff);
+  }
 }
 
 uint32_t write_rodata(Program* prog, Value val) {
   rodata_write(&prog->rod, val);
+  prog->vfd = false;
   return prog->rod.len - 1;
 }
 
@@ -44,8 +75,69 @@ uint32_t write_symtable(Program* prog, Symbol sym) {
   return prog->stb.len - 1;
 }
 
+// Bytes taken by a linked table of `len` entries, never empty
+#define LINKED_SIZE(TYPE, LEN) (sizeof(TYPE) * ((LEN) ? (LEN) : 1))
+
+void link_program(Program* prog) {
+  // Only symbols and values added since the last link are resolved
+  if (prog->ntv && prog->ntl == prog->stb.len && prog->rdl == prog->rod.len) {
+    return;
+  }
+
+  // Resolve builtins once, by name, so loading a builtin
+  // function is a single array access
+  size_t old_size = prog->ntv ? LINKED_SIZE(FFIFunction, prog->ntl) : 0;
+  size_t new_size = LINKED_SIZE(FFIFunction, prog->stb.len);
+  prog->ntv       = memory(prog->ntv, old_size, new_size);
+
+  for (uint32_t i = prog->ntl; i < prog->stb.len; i++) {
+    prog->ntv[i] = builtin_lookup(prog->stb.arr[i].str);
+  }
+
+  // Constant keys are hashed once here instead of
+  // every time they are used to index a dictionary
+  old_size  = prog->rdh ? LINKED_SIZE(uint32_t, prog->rdl) : 0;
+  new_size  = LINKED_SIZE(uint32_t, prog->rod.len);
+  prog->rdh = memory(prog->rdh, old_size, new_size);
+
+  for (uint32_t i = prog->rdl; i < prog->rod.len; i++) {
+    prog->rdh[i] = hash_value(prog->rod.arr[i]);
+  }
+
+  prog->ntl = prog->stb.len;
+  prog->rdl = prog->rod.len;
+}
+
+void reserve_caches(Program* prog, uint32_t len) {
+  if (len <= prog->icl) return;
+  if (len < GROW_CAP(prog->icl)) len = GROW_CAP(prog->icl);
+
+  size_t old_size = sizeof(InlineCache) * prog->icl;
+  size_t new_size = sizeof(InlineCache) * len;
+  prog->ics       = memory(prog->ics, old_size, new_size);
+
+  // An empty cache never matches a dictionary slot
+  for (uint32_t i = prog->icl; i < len; i++) {
+    prog->ics[i].slot = UINT32_MAX;
+  }
+
+  prog->icl = len;
+}
+
 void free_program(Program* prog) {
+  // Released with the lengths they were linked with, the
+  // program may have grown since it was last linked
+  if (prog->rdh) release(prog->rdh, LINKED_SIZE(uint32_t, prog->rdl));
+  if (prog->ics) release(prog->ics, sizeof(InlineCache) * prog->icl);
+  if (prog->ntv) release(prog->ntv, LINKED_SIZE(FFIFunction, prog->ntl));
+
   free_rodata(&prog->rod);
   free_symtable(&prog->stb);
-  release(prog->bytes, sizeof(uint8_t) * prog->cap);
+
+  // Instructions of mapped programs live in the image
+  if (prog->img) {
+    unmap_image(prog->img, prog->iml);
+  } else {
+    release(prog->bytes, sizeof(uint8_t) * prog->cap);
+  }
 }
\ No newline at end of file
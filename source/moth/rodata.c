@@ -12,6 +12,7 @@ void init_rodata(Rodata* rod, uint32_t init_len) {
   rod->len = init_len;
   rod->cap = init_len;
   rod->arr = init_len ? memory(NULL, 0, init_len * sizeof(Value)) : NULL;
+  rod->brw = false;
 }
 
 void rodata_write(Rodata* rod, Value val) {
@@ -33,6 +34,8 @@ void free_rodata(Rodata* rod) {
   for (uint32_t i = 0; i < rod->len; i++) {
     switch (rod->arr[i].type) {
       case T_STR: {
+        if (rod->brw) break;
+
         char*  str_ptr  = rod->arr[i].as.string;
         size_t str_size = strlen(str_ptr) + 1;
         release(str_ptr, str_size);
@@ -0,0 +1,815 @@
+/**
+ *  Here's the structure of a heap snapshot (version 0):
+ *   - "SILKSNP"
+ *   - version, 2 bytes
+ *   - padding, 3 bytes
+ *   - checksum, 4 bytes (CRC32C of everything after the header)
+ *   - program checksum, 4 bytes
+ *   - instruction offset, 4 bytes, where execution continues
+ *   - object count [o], 4 bytes
+ *   - global count [g], 4 bytes
+ *   - stack value count [s], 4 bytes
+ *   ~~ [o] object shapes, 9 bytes each
+ *      - object type, 1 byte
+ *      - length of the string, array, vector or dictionary, 8 bytes
+ *   ~~ [o] object contents, variable size
+ *   ~~ [g] globals, symbol index, 4 bytes & value
+ *   ~~ [s] values on the stack, from the bottom up
+ *
+ *  Values are a type byte followed by their payload. Strings are
+ *  indices into the program's read only data, objects are indices
+ *  into either the read only data or the snapshot's object table.
+ *  Shapes come first so every object can be allocated before any
+ *  pointer to it is fixed up.
+ */
+#include <moth/snapshot.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <moth/builtins.h>
+#include <moth/ffi.h>
+#include <moth/file.h>
+#include <moth/macros.h>
+#include <moth/mem.h>
+#include <moth/object.h>
+#include <moth/stack.h>
+#include <moth/value.h>
+
+static const char *   header  = "SILKSNP";
+static const uint16_t version = 0;
+
+#define HEADER_SIZE     16
+#define CHECKSUM_OFFSET 12
+
+// Where the object a value points to lives
+typedef enum {
+  ORIGIN_HEAP,
+  ORIGIN_RODATA,
+} Origin;
+
+#define SET_ERR(to_what)                                                       \
+  if (err) { *err = to_what; }
+
+#define SWAP_IF_BIG_ENDIAN(x)                                                  \
+  if (IS_BIG_ENDIAN) { x = SWAP_BYTES(x); }
+
+//                    _ _   _                                      //
+//                   (_) | (_)                                     //
+//  __      ___ __ _ _| |_ _ _ __   __ _                           //
+//  \ \ /\ / / '__| | | __| | '_ \ / _` |                          //
+//   \ V  V /| |  | | | |_| | | | | (_| |                          //
+//    \_/\_/ |_|  |_|_|\__|_|_| |_|\__, |                          //
+//                                  __/ |                          //
+//                                 |___/                           //
+
+// Maps the addresses of strings, symbols & objects to their index,
+// open addressing with linear probing
+
+typedef struct {
+  const void *key;
+  uint32_t    idx;
+} Ref;
+
+typedef struct {
+  size_t cap;
+  size_t len;
+  Ref *  ptr;
+} Refs;
+
+static void init_refs(Refs *refs) {
+  refs->cap = 0;
+  refs->len = 0;
+  refs->ptr = NULL;
+}
+
+static Ref *refs_bucket(Refs *refs, const void *key) {
+  // Allocations are aligned, the low bits carry no information
+  Ref *end    = refs->ptr + refs->cap;
+  Ref *bucket = refs->ptr + (((uintptr_t)key >> 3) % refs->cap);
+
+  while (bucket->key != NULL && bucket->key != key) {
+    bucket++;
+    if (bucket == end) bucket = refs->ptr;
+  }
+
+  return bucket;
+}
+
+static void refs_insert(Refs *refs, const void *key, uint32_t idx) {
+  if (2 * (refs->len + 1) > refs->cap) {
+    Ref *  old     = refs->ptr;
+    size_t old_cap = refs->cap;
+
+    refs->cap = GROW_CAP(2 * (refs->len + 1));
+    refs->ptr = memory(NULL, 0, sizeof(Ref) * refs->cap);
+    memset(refs->ptr, 0x0, sizeof(Ref) * refs->cap);
+
+    for (size_t i = 0; i < old_cap; i++) {
+      if (old[i].key) *refs_bucket(refs, old[i].key) = old[i];
+    }
+
+    release(old, sizeof(Ref) * old_cap);
+  }
+
+  Ref *bucket = refs_bucket(refs, key);
+  if (bucket->key == NULL) refs->len++;
+
+  bucket->key = key;
+  bucket->idx = idx;
+}
+
+static bool refs_find(Refs *refs, const void *key, uint32_t *idx) {
+  if (refs->len == 0) return false;
+
+  Ref *bucket = refs_bucket(refs, key);
+  if (bucket->key == NULL) return false;
+
+  *idx = bucket->idx;
+  return true;
+}
+
+static void free_refs(Refs *refs) {
+  release(refs->ptr, sizeof(Ref) * refs->cap);
+}
+
+typedef struct {
+  uint8_t *ptr;
+  size_t   len;
+  size_t   cap;
+} Buffer;
+
+static void put(Buffer *buf, const void *data, size_t n) {
+  if (buf->len + n > buf->cap) {
+    size_t cap = buf->cap;
+    while (cap < buf->len + n) cap = GROW_CAP(cap);
+
+    buf->ptr = memory(buf->ptr, buf->cap, cap);
+    buf->cap = cap;
+  }
+
+  memcpy(buf->ptr + buf->len, data, n);
+  buf->len += n;
+}
+
+#define DEFINE_PUT(FUNCTION, TYPE)                                             \
+  static void FUNCTION(Buffer *buf, TYPE t) {                                  \
+    SWAP_IF_BIG_ENDIAN(t);                                                     \
+    put(buf, &t, sizeof(TYPE));                                                \
+  }
+
+DEFINE_PUT(put_u8, uint8_t);
+DEFINE_PUT(put_u16, uint16_t);
+DEFINE_PUT(put_u32, uint32_t);
+DEFINE_PUT(put_i64, int64_t);
+DEFINE_PUT(put_u64, uint64_t);
+
+static void put_dbl(Buffer *buf, double d) {
+  uint64_t bits;
+  memcpy(&bits, &d, sizeof(bits));
+  put_u64(buf, bits);
+}
+
+typedef struct {
+  Program *prg;
+  Refs     rodata;  // strings & objects of the program
+  Refs     symbols; // symbol strings of the program
+  Refs     heap;    // objects already in the table
+  Object **objs;    // the object table, in discovery order
+  uint32_t len;
+  uint32_t cap;
+} Snapshot;
+
+static bool snapshotable(Object *obj) {
+  switch (obj->type) {
+    case O_STRING:     // fallthrough
+    case O_ARRAY:      // fallthrough
+    case O_VECTOR:     // fallthrough
+    case O_DICTIONARY: // fallthrough
+    case O_CLOSURE:    // fallthrough
+    case O_HEAPVAL: return true;
+
+    // Builtins are looked up again by name, anything
+    // else from a foreign library can't be restored
+    case O_FFI_FUNCTION: return builtin_name(OBJ_FFI_FUN(obj)->fun) != NULL;
+    case O_FFI_POINTER: return OBJ_FFI_PTR(obj)->tag == MOTH_BUILTIN_TAG;
+
+    // Functions only ever come from the read only data
+    case O_FUNCTION: // fallthrough
+    case O_FFI_NATIVE: return false;
+  }
+
+  return false;
+}
+
+// Gives the object a value points to its place in the table
+static void discover(Snapshot *snp, Value val, const char **err) {
+  uint32_t idx;
+
+  if (val.type == T_STR && !refs_find(&snp->rodata, val.as.string, &idx)) {
+    SET_ERR("snapshot holds a string from another program");
+    return;
+  }
+
+  if (val.type != T_OBJ) return;
+  if (refs_find(&snp->rodata, val.as.object, &idx)) return;
+  if (refs_find(&snp->heap, val.as.object, &idx)) return;
+
+  if (!snapshotable(val.as.object)) {
+    SET_ERR("snapshot holds a foreign object");
+    return;
+  }
+
+  if (snp->len == snp->cap) {
+    size_t old_cap = snp->cap;
+    snp->cap       = GROW_CAP(snp->cap);
+    snp->objs      = memory(
+      snp->objs, sizeof(Object *) * old_cap, sizeof(Object *) * snp->cap);
+  }
+
+  refs_insert(&snp->heap, val.as.object, snp->len);
+  snp->objs[snp->len++] = val.as.object;
+}
+
+static void discover_children(Snapshot *snp, Object *obj, const char **err) {
+  switch (obj->type) {
+    case O_ARRAY: {
+      ObjectArray *arr = OBJ_ARR(obj);
+      for (size_t i = 0; i < arr->size; i++) discover(snp, arr->vals[i], err);
+      break;
+    }
+
+    case O_DICTIONARY: {
+      ObjectDictionary *dct = OBJ_DCT(obj);
+
+      for (size_t i = 0; i < dct->cap; i++) {
+        if (IS_VOID(dct->entries[i].key)) continue;
+        discover(snp, dct->entries[i].key, err);
+        discover(snp, dct->entries[i].value, err);
+      }
+
+      break;
+    }
+
+    case O_CLOSURE: {
+      discover(snp, OBJ_VAL((Object *)OBJ_CLJ(obj)->fct), err);
+      break;
+    }
+
+    case O_HEAPVAL: {
+      discover(snp, OBJ_HPV(obj)->val, err);
+      break;
+    }
+
+    default: break;
+  }
+}
+
+static void put_value(Buffer *buf, Snapshot *snp, Value val) {
+  uint32_t idx = 0;
+  put_u8(buf, val.type);
+
+  switch (val.type) {
+    case T_BOOL: return put_u8(buf, val.as.boolean);
+    case T_INT: return put_i64(buf, val.as.integer);
+    case T_REAL: return put_dbl(buf, val.as.real);
+    case T_CHAR: return put_u32(buf, val.as.charac);
+
+    case T_STR: {
+      refs_find(&snp->rodata, val.as.string, &idx);
+      return put_u32(buf, idx);
+    }
+
+    case T_OBJ: {
+      if (refs_find(&snp->rodata, val.as.object, &idx)) {
+        put_u8(buf, ORIGIN_RODATA);
+      } else {
+        refs_find(&snp->heap, val.as.object, &idx);
+        put_u8(buf, ORIGIN_HEAP);
+      }
+
+      return put_u32(buf, idx);
+    }
+
+    default: return;
+  }
+}
+
+static uint64_t shape_length(Object *obj) {
+  switch (obj->type) {
+    case O_STRING: return OBJ_STR(obj)->size;
+    case O_ARRAY: return OBJ_ARR(obj)->size;
+    case O_VECTOR: return OBJ_VEC(obj)->card;
+    case O_DICTIONARY: return OBJ_DCT(obj)->len;
+    default: return 0;
+  }
+}
+
+static void put_contents(Buffer *buf, Snapshot *snp, Object *obj) {
+  switch (obj->type) {
+    case O_STRING: {
+      put(buf, OBJ_STR(obj)->data, OBJ_STR(obj)->size);
+      break;
+    }
+
+    case O_ARRAY: {
+      ObjectArray *arr = OBJ_ARR(obj);
+      for (size_t i = 0; i < arr->size; i++) put_value(buf, snp, arr->vals[i]);
+      break;
+    }
+
+    case O_VECTOR: {
+      ObjectVector *vec = OBJ_VEC(obj);
+      for (size_t i = 0; i < vec->card; i++) put_dbl(buf, vec->comp[i]);
+      break;
+    }
+
+    case O_DICTIONARY: {
+      // Keys hashed by address are rehashed when restored,
+      // so only the entries are kept and not their slots
+      ObjectDictionary *dct = OBJ_DCT(obj);
+
+      for (size_t i = 0; i < dct->cap; i++) {
+        if (IS_VOID(dct->entries[i].key)) continue;
+        put_value(buf, snp, dct->entries[i].key);
+        put_value(buf, snp, dct->entries[i].value);
+      }
+
+      break;
+    }
+
+    case O_CLOSURE: {
+      put_value(buf, snp, OBJ_VAL((Object *)OBJ_CLJ(obj)->fct));
+      break;
+    }
+
+    case O_HEAPVAL: {
+      put_value(buf, snp, OBJ_HPV(obj)->val);
+      break;
+    }
+
+    case O_FFI_FUNCTION: {
+      const char *name = builtin_name(OBJ_FFI_FUN(obj)->fun);
+      put(buf, name, strlen(name) + 1);
+      break;
+    }
+
+    case O_FFI_POINTER: {
+      put_u32(buf, OBJ_FFI_PTR(obj)->tag);
+      break;
+    }
+
+    default: break;
+  }
+}
+
+static void init_snapshot(Snapshot *snp, Program *prog) {
+  snp->prg  = prog;
+  snp->objs = NULL;
+  snp->len  = 0;
+  snp->cap  = 0;
+
+  init_refs(&snp->rodata);
+  init_refs(&snp->symbols);
+  init_refs(&snp->heap);
+
+  for (uint32_t i = 0; i < prog->rod.len; i++) {
+    Value val = prog->rod.arr[i];
+    if (val.type == T_STR) refs_insert(&snp->rodata, val.as.string, i);
+    if (val.type == T_OBJ) refs_insert(&snp->rodata, val.as.object, i);
+  }
+
+  for (uint32_t i = 0; i < prog->stb.len; i++) {
+    refs_insert(&snp->symbols, prog->stb.arr[i].str, i);
+  }
+}
+
+static void free_snapshot(Snapshot *snp) {
+  free_refs(&snp->rodata);
+  free_refs(&snp->symbols);
+  free_refs(&snp->heap);
+  release(snp->objs, sizeof(Object *) * snp->cap);
+}
+
+static void snapshot_vm(Buffer *buf, Snapshot *snp, VM *vm, const char **err) {
+  Environment *env = &vm->env;
+  Stack *      stk = &vm->stk;
+
+  uint32_t globals = 0;
+  uint32_t idx;
+
+  // Everything reachable from the globals & the stack
+  for (Entry *e = env->ptr; e < env->ptr + env->cap; e++) {
+    if (e->key.str == NULL) continue;
+
+    if (!refs_find(&snp->symbols, e->key.str, &idx)) {
+      SET_ERR("snapshot holds a global from another program");
+      return;
+    }
+
+    discover(snp, e->value, err);
+    globals++;
+  }
+
+  for (Value *v = stk->varr; v < stk->vtop; v++) discover(snp, *v, err);
+
+  for (uint32_t i = 0; i < snp->len; i++) {
+    discover_children(snp, snp->objs[i], err);
+  }
+
+  if (err && *err) return;
+
+  put_u32(buf, checksum(vm->prg));
+  put_u32(buf, (uint32_t)(vm->ip - vm->prg->bytes));
+  put_u32(buf, snp->len);
+  put_u32(buf, globals);
+  put_u32(buf, (uint32_t)(stk->vtop - stk->varr));
+
+  for (uint32_t i = 0; i < snp->len; i++) {
+    put_u8(buf, snp->objs[i]->type);
+    put_u64(buf, shape_length(snp->objs[i]));
+  }
+
+  for (uint32_t i = 0; i < snp->len; i++) {
+    put_contents(buf, snp, snp->objs[i]);
+  }
+
+  for (Entry *e = env->ptr; e < env->ptr + env->cap; e++) {
+    if (e->key.str == NULL) continue;
+    refs_find(&snp->symbols, e->key.str, &idx);
+    put_u32(buf, idx);
+    put_value(buf, snp, e->value);
+  }
+
+  for (Value *v = stk->varr; v < stk->vtop; v++) put_value(buf, snp, *v);
+}
+
+void write_snapshot(const char *file, VM *vm, const char **err) {
+  SET_ERR(NULL);
+
+  // Return addresses & base pointers of frames would
+  // need fixing up as well, only the top level is saved
+  if (!vm->prg || vm->stk.ftop != vm->stk.farr + 1) {
+    SET_ERR("snapshots are only taken at the top level");
+    return;
+  }
+
+  Buffer   buf = {.ptr = NULL, .len = 0, .cap = 0};
+  Snapshot snp;
+  init_snapshot(&snp, vm->prg);
+
+  put(&buf, header, strlen(header));
+  put_u16(&buf, version);
+  put(&buf, "\0\0\0", 3);
+  put_u32(&buf, 0x0);
+
+  snapshot_vm(&buf, &snp, vm, err);
+  free_snapshot(&snp);
+
+  if (err && *err) {
+    release(buf.ptr, buf.cap);
+    return;
+  }
+
+  uint32_t crc = crc32c(0, buf.ptr + HEADER_SIZE, buf.len - HEADER_SIZE);
+  SWAP_IF_BIG_ENDIAN(crc);
+  memcpy(buf.ptr + CHECKSUM_OFFSET, &crc, sizeof(crc));
+
+  // The snapshot is built in memory and written at once
+  FILE *f = fopen(file, "wb");
+
+  if (!f) {
+    SET_ERR("could not find file");
+  } else if (fwrite(buf.ptr, sizeof(uint8_t), buf.len, f) != buf.len) {
+    SET_ERR("could not write snapshot");
+  }
+
+  if (f) fclose(f);
+  release(buf.ptr, buf.cap);
+}
+
+//                     _ _                                         //
+//                    | (_)                                        //
+//   _ __ ___  __ _  __| |_ _ __   __ _                            //
+//  | '__/ _ \/ _` |/ _` | | '_ \ / _` |                           //
+//  | | |  __/ (_| | (_| | | | | | (_| |                           //
+//  |_|  \___|\__,_|\__,_|_|_| |_|\__, |                           //
+//                                 __/ |                           //
+//                                |___/                            //
+
+typedef struct {
+  const uint8_t *ptr; // read position
+  const uint8_t *end; // end of the image
+  bool           eof; // tried reading past the end
+} Cursor;
+
+static const uint8_t *take(Cursor *cur, size_t n) {
+  if ((size_t)(cur->end - cur->ptr) < n) {
+    cur->eof = true;
+    cur->ptr = cur->end;
+    return NULL;
+  }
+
+  const uint8_t *at = cur->ptr;
+  cur->ptr += n;
+  return at;
+}
+
+static uint8_t read_u8(Cursor *cur) {
+  const uint8_t *at = take(cur, 1);
+  return at ? *at : 0;
+}
+
+#define DEFINE_READ(FUNCTION, TYPE)                                            \
+  static TYPE FUNCTION(Cursor *cur) {                                          \
+    TYPE           x  = 0;                                                     \
+    const uint8_t *at = take(cur, sizeof(TYPE));                               \
+    if (!at) return 0;                                                         \
+    memcpy(&x, at, sizeof(TYPE));                                              \
+    SWAP_IF_BIG_ENDIAN(x);                                                     \
+    return x;                                                                  \
+  }
+
+DEFINE_READ(read_u16, uint16_t);
+DEFINE_READ(read_u32, uint32_t);
+DEFINE_READ(read_i64, int64_t);
+DEFINE_READ(read_u64, uint64_t);
+
+static double read_dbl(Cursor *cur) {
+  uint64_t bits = read_u64(cur);
+  double   d;
+  memcpy(&d, &bits, sizeof(d));
+  return d;
+}
+
+typedef struct {
+  Program *prg;
+  Object **objs;
+  uint32_t len;
+} Restore;
+
+// Fixes up the pointers of a value, false if it is malformed
+static bool read_value(Cursor *cur, Restore *rst, Value *x) {
+  Rodata * rod = &rst->prg->rod;
+  uint32_t idx;
+
+  switch (read_u8(cur)) {
+    case T_VOID: *x = VOID_VAL; break;
+    case T_BOOL: *x = BOOL_VAL(read_u8(cur) != 0); break;
+    case T_INT: *x = INT_VAL(read_i64(cur)); break;
+    case T_REAL: *x = REAL_VAL(read_dbl(cur)); break;
+    case T_CHAR: *x = CHAR_VAL((wchar_t)read_u32(cur)); break;
+
+    case T_STR: {
+      idx = read_u32(cur);
+      if (idx >= rod->len || rod->arr[idx].type != T_STR) return false;
+      *x = rod->arr[idx];
+      break;
+    }
+
+    case T_OBJ: {
+      uint8_t origin = read_u8(cur);
+      idx            = read_u32(cur);
+
+      if (origin == ORIGIN_HEAP) {
+        if (idx >= rst->len) return false;
+        *x = OBJ_VAL(rst->objs[idx]);
+      } else if (origin == ORIGIN_RODATA) {
+        if (idx >= rod->len || rod->arr[idx].type != T_OBJ) return false;
+        *x = rod->arr[idx];
+      } else {
+        return false;
+      }
+
+      break;
+    }
+
+    default: return false;
+  }
+
+  return !cur->eof;
+}
+
+// Allocates an object without its contents, the contents
+// may point to objects that don't exist yet
+static Object *read_shape(Cursor *cur) {
+  uint8_t  type   = read_u8(cur);
+  uint64_t length = read_u64(cur);
+
+  // Every element takes at least a byte, lengths past
+  // the end of the snapshot can't be right
+  if (cur->eof || length > (uint64_t)(cur->end - cur->ptr)) return NULL;
+
+  switch (type) {
+    case O_STRING: {
+      ObjectString *str = (ObjectString *)alloc_object(
+        O_STRING, sizeof(ObjectString) + length + sizeof(char));
+
+      str->size = length;
+      return (Object *)str;
+    }
+
+    case O_ARRAY: {
+      ObjectArray *arr = obj_arr_with_size(length);
+      for (size_t i = 0; i < length; i++) arr->vals[i] = VOID_VAL;
+      return (Object *)arr;
+    }
+
+    case O_VECTOR: {
+      ObjectVector *vec = (ObjectVector *)alloc_object(
+        O_VECTOR, sizeof(ObjectVector) + sizeof(double) * length);
+
+      vec->card = length;
+      return (Object *)vec;
+    }
+
+    case O_DICTIONARY: return (Object *)obj_dct_with_cap(length);
+    case O_CLOSURE: return (Object *)obj_clj_from_fct(NULL);
+    case O_HEAPVAL: return (Object *)obj_hpv_promote(VOID_VAL);
+    case O_FFI_FUNCTION: return (Object *)obj_ffi_fun_new(NULL);
+    case O_FFI_POINTER: return (Object *)obj_ffi_ptr_new(0x0, NULL, NULL);
+    default: return NULL;
+  }
+}
+
+static bool read_contents(Cursor *cur, Restore *rst, Object *obj,
+                          uint64_t length) {
+  switch (obj->type) {
+    case O_STRING: {
+      ObjectString * str = OBJ_STR(obj);
+      const uint8_t *at  = take(cur, str->size);
+      if (!at) return false;
+
+      memcpy(str->data, at, str->size);
+      str->data[str->size] = '\0';
+      str->hash            = hash(str->data);
+      return true;
+    }
+
+    case O_ARRAY: {
+      ObjectArray *arr = OBJ_ARR(obj);
+
+      for (size_t i = 0; i < arr->size; i++) {
+        if (!read_value(cur, rst, &arr->vals[i])) return false;
+      }
+
+      return true;
+    }
+
+    case O_VECTOR: {
+      ObjectVector *vec = OBJ_VEC(obj);
+      for (size_t i = 0; i < vec->card; i++) vec->comp[i] = read_dbl(cur);
+      return !cur->eof;
+    }
+
+    case O_DICTIONARY: {
+      for (uint64_t i = 0; i < length; i++) {
+        Value key, value;
+        if (!read_value(cur, rst, &key)) return false;
+        if (!read_value(cur, rst, &value)) return false;
+        obj_dct_insert(OBJ_DCT(obj), key, value);
+      }
+
+      return true;
+    }
+
+    case O_CLOSURE: {
+      Value fct;
+      if (!read_value(cur, rst, &fct) || !IS_OBJ_FCT(fct)) return false;
+      OBJ_CLJ(obj)->fct = OBJ_FCT(fct.as.object);
+      return true;
+    }
+
+    case O_HEAPVAL: {
+      return read_value(cur, rst, &OBJ_HPV(obj)->val);
+    }
+
+    case O_FFI_FUNCTION: {
+      const uint8_t *nul = memchr(cur->ptr, 0x0, cur->end - cur->ptr);
+      if (!nul) return false;
+
+      OBJ_FFI_FUN(obj)->fun = builtin_lookup((const char *)cur->ptr);
+      cur->ptr              = nul + 1;
+      return OBJ_FFI_FUN(obj)->fun != NULL;
+    }
+
+    case O_FFI_POINTER: {
+      OBJ_FFI_PTR(obj)->tag = read_u32(cur);
+      return !cur->eof && OBJ_FFI_PTR(obj)->tag == MOTH_BUILTIN_TAG;
+    }
+
+    default: return false;
+  }
+}
+
+static void restore_vm(Cursor *cur, VM *vm, Program *prog, const char **err) {
+  uint32_t prog_crc = read_u32(cur);
+  uint32_t offset   = read_u32(cur);
+  uint32_t objects  = read_u32(cur);
+  uint32_t globals  = read_u32(cur);
+  uint32_t values   = read_u32(cur);
+
+  if (cur->eof || offset > prog->len || values > MOTHVM_STK_CAP) {
+    SET_ERR("malformed snapshot");
+    return;
+  }
+
+  if (prog_crc != checksum(prog)) {
+    SET_ERR("snapshot was taken of another program");
+    return;
+  }
+
+  // Every shape is 9 bytes
+  if (objects > (size_t)(cur->end - cur->ptr) / 9) {
+    SET_ERR("malformed snapshot");
+    return;
+  }
+
+  Restore   rst     = {.prg = prog, .objs = NULL, .len = 0};
+  uint64_t *lengths = memory(NULL, 0, sizeof(uint64_t) * objects);
+  rst.objs          = memory(NULL, 0, sizeof(Object *) * objects);
+
+  // Objects are registered as they are allocated, the collector
+  // must not run before the globals refer to them
+  gc_reserve(&vm->gc, objects);
+
+  for (; rst.len < objects; rst.len++) {
+    const uint8_t *shape = cur->ptr;
+    Object *       obj   = read_shape(cur);
+    if (!obj) break;
+
+    memcpy(&lengths[rst.len], shape + 1, sizeof(uint64_t));
+    SWAP_IF_BIG_ENDIAN(lengths[rst.len]);
+
+    gc_register(&vm->gc, obj);
+    rst.objs[rst.len] = obj;
+  }
+
+  bool ok = rst.len == objects;
+
+  for (uint32_t i = 0; ok && i < objects; i++) {
+    ok = read_contents(cur, &rst, rst.objs[i], lengths[i]);
+  }
+
+  for (uint32_t i = 0; ok && i < globals; i++) {
+    uint32_t sym = read_u32(cur);
+    Value    val;
+
+    ok = sym < prog->stb.len && read_value(cur, &rst, &val);
+    if (ok) env_set(&vm->env, prog->stb.arr[sym], val);
+  }
+
+  for (uint32_t i = 0; ok && i < values; i++) {
+    Value val;
+    ok = read_value(cur, &rst, &val);
+    if (ok) stk_push(&vm->stk, val);
+  }
+
+  release(lengths, sizeof(uint64_t) * objects);
+  release(rst.objs, sizeof(Object *) * objects);
+
+  if (!ok) {
+    SET_ERR("malformed snapshot");
+    return;
+  }
+
+  vm->prg = prog;
+  vm->ip  = prog->bytes + offset;
+  vm->st  = STATUS_OK;
+}
+
+void read_snapshot(const char *file, VM *vm, Program *prog, const char **err) {
+  SET_ERR(NULL);
+
+  // Snapshots are only read through once, mapping them
+  // saves copying the whole file into a buffer first
+  size_t   len = 0;
+  uint8_t *img = map_image(file, &len);
+
+  if (!img) {
+    SET_ERR("could not find file");
+    return;
+  }
+
+  Cursor cur = {.ptr = img, .end = img + len, .eof = false};
+
+  const uint8_t *magic = take(&cur, strlen(header));
+  uint16_t       ver   = read_u16(&cur);
+  take(&cur, 3);
+  uint32_t crc = read_u32(&cur);
+
+  if (cur.eof || memcmp(magic, header, strlen(header)) != 0) {
+    SET_ERR("not a silk snapshot");
+  } else if (ver > version) {
+    SET_ERR("unsupported silk snapshot version");
+  } else if (crc != crc32c(0, img + HEADER_SIZE, len - HEADER_SIZE)) {
+    SET_ERR("silk snapshot is corrupted");
+  } else {
+    // Programs built in memory haven't been linked yet
+    link_program(prog);
+    restore_vm(&cur, vm, prog, err);
+  }
+
+  unmap_image(img, len);
+}
@@ -30,6 +30,11 @@ void stk_push(Stack* stk, Value val) {
   stk->vtop++;
 }
 
+bool stk_room(Stack* stk, size_t values) {
+  return stk->ftop < stk->farr + MOTHVM_FRM_CAP &&
+         values <= (size_t)(stk->varr + MOTHVM_STK_CAP - stk->vtop);
+}
+
 Frame* stk_frame(Stack* stk) {
   return stk->ftop - 1;
 }
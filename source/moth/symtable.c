@@ -10,6 +10,7 @@ void init_symtable(Symtable* stb, uint32_t init_len) {
   stb->len = init_len;
   stb->cap = init_len;
   stb->arr = init_len ? memory(NULL, 0, sizeof(Symbol) * init_len) : NULL;
+  stb->brw = false;
 }
 
 void symtable_write(Symtable* stb, Symbol sym) {
@@ -28,7 +29,7 @@ void symtable_write(Symtable* stb, Symbol sym) {
 }
 
 void free_symtable(Symtable* stb) {
-  for (uint32_t i = 0; i < stb->len; i++) {
+  for (uint32_t i = 0; i < stb->len && !stb->brw; i++) {
     release(stb->arr[i].str, strlen(stb->arr[i].str) + 1); // null byte
   }
 
@@ -28,9 +28,9 @@ bool falsy(Value v) {
 uint32_t hash(const char *str) {
   uint32_t x = 2166136261u;
 
-  for (size_t i = 0; i < strlen(str); i++) {
+  for (; *str; str++) {
     x *= 16777619u;
-    x ^= str[i];
+    x ^= *str;
   }
 
   return x;
@@ -0,0 +1,588 @@
+#include <moth/verify.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <moth/macros.h>
+#include <moth/mem.h>
+#include <moth/object.h>
+#include <moth/opcode.h>
+#include <moth/stack.h>
+
+#define SET_ERR(to_what)                                                       \
+  if (err) { *err = to_what; }
+
+// Depth of instructions no path has reached yet
+#define UNSEEN INT32_MIN
+
+// A FRM instruction, the subroutine it enters is in the
+// program's instructions & is passed argc arguments
+typedef struct {
+  uint32_t addr;
+  uint32_t argc;
+  int32_t  need; // arguments the subroutine reads
+} Site;
+
+typedef struct {
+  Program *    prg;
+  Site *       sites;
+  size_t       len;
+  size_t       cap;
+  const char **err;
+} Verifier;
+
+// Code reachable from a single entry, depths are counted from
+// the stack top at the entry, negative depths are arguments
+typedef struct {
+  const uint8_t *code;
+  uint32_t       len;
+  bool           top;    // top level code, it can't return
+  bool           wcd;    // code is wordcode
+  uint8_t *      starts; // instruction boundaries
+  int32_t *      depth;  // depth before each instruction
+  uint32_t *     work;   // instructions left to visit
+  uint32_t       todo;
+  int32_t        need; // arguments the code reads
+  int32_t        peak; // most values pushed at once
+} Analysis;
+
+// A decoded instruction, operands in the order they are encoded
+typedef struct {
+  uint8_t  op;
+  uint32_t size; // bytes it takes, prefixes & operands included
+  uint32_t args[3];
+} Instruction;
+
+// Size of each operand in bytecode, the count of operands or -1
+// for unknown instructions. Wordcode has the same operands.
+static int operand_sizes(uint8_t op, int *sizes) {
+  switch (op) {
+    case VM_FIN: // fallthrough
+    case VM_NOP: // fallthrough
+    case VM_GC:  // fallthrough
+    case VM_DBG: // fallthrough
+    case VM_POP: // fallthrough
+    case VM_CLO: // fallthrough
+    case VM_PRO: // fallthrough
+    case VM_RET: // fallthrough
+    case VM_VID: // fallthrough
+    case VM_TRU: // fallthrough
+    case VM_FAL: // fallthrough
+    case VM_PI:  // fallthrough
+    case VM_TAU: // fallthrough
+    case VM_EUL: // fallthrough
+    case VM_NEG: // fallthrough
+    case VM_NOT: // fallthrough
+    case VM_ADD: // fallthrough
+    case VM_SUB: // fallthrough
+    case VM_DIV: // fallthrough
+    case VM_MUL: // fallthrough
+    case VM_RIV: // fallthrough
+    case VM_POW: // fallthrough
+    case VM_MOD: // fallthrough
+    case VM_IDX: // fallthrough
+    case VM_IDA: // fallthrough
+    case VM_MRG: // fallthrough
+    case VM_EQ:  // fallthrough
+    case VM_NEQ: // fallthrough
+    case VM_GT:  // fallthrough
+    case VM_LT:  // fallthrough
+    case VM_GTE: // fallthrough
+    case VM_LTE: // fallthrough
+    case VM_SQT: // fallthrough
+    case VM_FLR: // fallthrough
+    case VM_ABS: // fallthrough
+    case VM_SIN: // fallthrough
+    case VM_COS: // fallthrough
+    case VM_EXP: // fallthrough
+    case VM_LOG: // fallthrough
+    case VM_MIN: // fallthrough
+    case VM_MAX: return 0;
+
+    case VM_CAL: // fallthrough
+    case VM_VEC: // fallthrough
+    case VM_ARR: // fallthrough
+    case VM_DCT: sizes[0] = 1; return 1;
+
+    case VM_PSH: // fallthrough
+    case VM_STR: // fallthrough
+    case VM_JMP: // fallthrough
+    case VM_JPT: // fallthrough
+    case VM_JPF: // fallthrough
+    case VM_JBW: sizes[0] = 2; return 1;
+
+    case VM_DLL: // fallthrough
+    case VM_FFN: // fallthrough
+    case VM_FFT: sizes[0] = 4; return 1;
+
+    case VM_IDK: // fallthrough
+    case VM_IAK: sizes[0] = 4, sizes[1] = 2; return 2;
+    case VM_INV: sizes[0] = 1, sizes[1] = 4, sizes[2] = 2; return 3;
+    case VM_NTV: sizes[0] = 1, sizes[1] = 4; return 2;
+
+    // Instructions with a 1 to 4 byte wide index
+    case VM_VAL:  // fallthrough
+    case VM_VAL2: // fallthrough
+    case VM_VAL3: // fallthrough
+    case VM_VAL4: // fallthrough
+    case VM_SYM:  // fallthrough
+    case VM_SYM2: // fallthrough
+    case VM_SYM3: // fallthrough
+    case VM_SYM4: // fallthrough
+    case VM_DEF:  // fallthrough
+    case VM_DEF2: // fallthrough
+    case VM_DEF3: // fallthrough
+    case VM_DEF4: // fallthrough
+    case VM_ASN:  // fallthrough
+    case VM_ASN2: // fallthrough
+    case VM_ASN3: // fallthrough
+    case VM_ASN4: sizes[0] = (op - VM_VAL) % 4 + 1; return 1;
+
+    // Address followed by the argument count
+    case VM_FRM:  // fallthrough
+    case VM_FRM2: // fallthrough
+    case VM_FRM3: // fallthrough
+    case VM_FRM4: sizes[0] = op - VM_FRM + 1, sizes[1] = 1; return 2;
+
+    // Only ever a prefix, decoded with the word it extends
+    case VM_EXT: // fallthrough
+    default: return -1;
+  }
+}
+
+// Operands are big endian
+static uint32_t operand(const uint8_t *at, int size) {
+  uint32_t x = 0;
+  for (int i = 0; i < size; i++) x = (x << 8) | at[i];
+  return x;
+}
+
+static const char *decode_bytes(const uint8_t *code, uint32_t len,
+                                uint32_t at, Instruction *ins) {
+  int sizes[3];
+  int count = operand_sizes(code[at], sizes);
+  if (count < 0) return "unknown instruction";
+
+  ins->op      = code[at];
+  ins->size    = 1;
+  ins->args[0] = 0;
+
+  for (int i = 0; i < count; i++) {
+    if (len - at - ins->size < (uint32_t)sizes[i]) {
+      return "truncated instruction";
+    }
+
+    ins->args[i] = operand(code + at + ins->size, sizes[i]);
+    ins->size += sizes[i];
+  }
+
+  return NULL;
+}
+
+static const char *decode_words(const uint8_t *code, uint32_t len,
+                                uint32_t at, Instruction *ins) {
+  uint32_t word = LOAD_WORD(code + at);
+  uint32_t ext  = 0;
+  ins->size     = 4;
+
+  // The prefix belongs to the instruction it extends
+  if (WORD_OP(word) == VM_EXT) {
+    if (len - at < 8) return "truncated instruction";
+
+    ext  = WORD_ARG(word) << 24;
+    word = LOAD_WORD(code + at + 4);
+    ins->size += 4;
+  }
+
+  int sizes[3];
+  int count = operand_sizes(WORD_OP(word), sizes);
+
+  // Only the first of the variants of an instruction exists
+  bool variant = VM_VAL <= WORD_OP(word) && WORD_OP(word) <= VM_FRM4 &&
+                 (WORD_OP(word) - VM_VAL) % 4 != 0;
+
+  if (count < 0 || variant) return "unknown instruction";
+
+  ins->op      = WORD_OP(word);
+  ins->args[0] = ext | WORD_ARG(word);
+
+  for (int i = 1; i < count; i++) {
+    if (len - at - ins->size < 4) return "truncated instruction";
+
+    ins->args[i] = LOAD_WORD(code + at + ins->size);
+    ins->size += 4;
+  }
+
+  // Counts & cache ids are as narrow as in bytecode, addresses,
+  // locals & jumps can use the whole operand
+  bool wide = ins->op == VM_PSH || ins->op == VM_STR ||
+              (VM_JMP <= ins->op && ins->op <= VM_JBW) ||
+              ins->op == VM_DLL || ins->op == VM_FFN || ins->op == VM_FFT ||
+              (VM_VAL <= ins->op && ins->op <= VM_FRM4);
+
+  for (int i = 0; i < count; i++) {
+    if (i == 0 && wide) continue;
+    if (sizes[i] < 4 && ins->args[i] >> (8 * sizes[i])) {
+      return "operand is too wide";
+    }
+  }
+
+  return NULL;
+}
+
+static const char *decode(Analysis *ana, uint32_t at, Instruction *ins) {
+  if (ana->wcd) return decode_words(ana->code, ana->len, at, ins);
+  return decode_bytes(ana->code, ana->len, at, ins);
+}
+
+static bool add_site(Verifier *ver, uint32_t addr, uint32_t argc) {
+  if (addr >= ver->prg->len) return false;
+
+  if (ver->len == ver->cap) {
+    size_t old_cap = ver->cap;
+    ver->cap       = GROW_CAP(ver->cap);
+    ver->sites     = memory(
+      ver->sites, sizeof(Site) * old_cap, sizeof(Site) * ver->cap);
+  }
+
+  ver->sites[ver->len++] = (Site){.addr = addr, .argc = argc, .need = 0};
+  return true;
+}
+
+static bool reach(Analysis *ana, uint32_t at, int32_t depth, const char **err) {
+  if (at >= ana->len || !ana->starts[at]) {
+    SET_ERR("jump lands outside of an instruction");
+    return false;
+  }
+
+  if (ana->depth[at] == UNSEEN) {
+    ana->depth[at]          = depth;
+    ana->work[ana->todo++] = at;
+    return true;
+  }
+
+  if (ana->depth[at] != depth) {
+    SET_ERR("paths reach an instruction with different stack depths");
+    return false;
+  }
+
+  return true;
+}
+
+// Checks a single instruction & queues the ones that follow it
+static bool step(Verifier *ver, Analysis *ana, uint32_t at) {
+  const char **err = ver->err;
+  Program *    prg = ver->prg;
+
+  // Every instruction decoded when the boundaries were found
+  Instruction ins;
+  decode(ana, at, &ins);
+
+  uint8_t  op   = ins.op;
+  uint32_t arg  = ins.args[0];
+  uint32_t next = at + ins.size;
+
+  int32_t  depth = ana->depth[at];
+  int32_t  pops  = 0;
+  int32_t  push  = 0;
+  bool     falls = true;
+  bool     jumps = false;
+  uint32_t land  = 0;
+
+  switch (op) {
+    case VM_FIN: falls = false; break;
+
+    case VM_NOP: // fallthrough
+    case VM_GC:  // fallthrough
+    case VM_DBG: break;
+
+    case VM_DLL: push = 1; break;
+    case VM_FFN: pops = 1, push = 2; break;
+    case VM_FFT: pops = 2, push = 2; break;
+
+    case VM_POP: pops = 1; break;
+    case VM_PSH: push = 1; break;
+    case VM_STR: pops = 1, push = 1; break;
+
+    case VM_JMP: falls = false, jumps = true, land = next + arg; break;
+    case VM_JBW: falls = false, jumps = true, land = next - arg; break;
+
+    case VM_JPT: // fallthrough
+    case VM_JPF: {
+      pops = 1, push = 1;
+      jumps = true, land = next + arg;
+      break;
+    }
+
+    case VM_CLO: pops = 1, push = 1; break;
+    case VM_CAL: // fallthrough
+    case VM_NTV: pops = arg + 1, push = 1; break;
+    case VM_PRO: pops = 1, push = 1; break;
+
+    case VM_RET: {
+      if (ana->top) {
+        SET_ERR("return outside of a function");
+        return false;
+      }
+
+      pops = 1, falls = false;
+      break;
+    }
+
+    case VM_VAL:  // fallthrough
+    case VM_VAL2: // fallthrough
+    case VM_VAL3: // fallthrough
+    case VM_VAL4: push = 1; break;
+
+    case VM_SYM:  // fallthrough
+    case VM_SYM2: // fallthrough
+    case VM_SYM3: // fallthrough
+    case VM_SYM4: push = 1; break;
+
+    case VM_DEF:  // fallthrough
+    case VM_DEF2: // fallthrough
+    case VM_DEF3: // fallthrough
+    case VM_DEF4: pops = 1; break;
+
+    case VM_ASN:  // fallthrough
+    case VM_ASN2: // fallthrough
+    case VM_ASN3: // fallthrough
+    case VM_ASN4: pops = 1, push = 1; break;
+
+    case VM_FRM:  // fallthrough
+    case VM_FRM2: // fallthrough
+    case VM_FRM3: // fallthrough
+    case VM_FRM4: {
+      uint32_t addr = ins.args[0];
+      uint32_t argc = ins.args[1];
+
+      if (!add_site(ver, addr, argc)) {
+        SET_ERR("frame enters code outside of the program");
+        return false;
+      }
+
+      pops = argc, push = 1;
+      break;
+    }
+
+    case VM_VID: // fallthrough
+    case VM_TRU: // fallthrough
+    case VM_FAL: // fallthrough
+    case VM_PI:  // fallthrough
+    case VM_TAU: // fallthrough
+    case VM_EUL: // fallthrough
+    case VM_ARR: // fallthrough
+    case VM_DCT: push = 1; break;
+
+    case VM_VEC: pops = arg, push = 1; break;
+
+    case VM_NEG: // fallthrough
+    case VM_NOT: // fallthrough
+    case VM_SQT: // fallthrough
+    case VM_FLR: // fallthrough
+    case VM_ABS: // fallthrough
+    case VM_SIN: // fallthrough
+    case VM_COS: // fallthrough
+    case VM_EXP: // fallthrough
+    case VM_LOG: // fallthrough
+    case VM_IDK: pops = 1, push = 1; break;
+
+    case VM_ADD: // fallthrough
+    case VM_SUB: // fallthrough
+    case VM_DIV: // fallthrough
+    case VM_MUL: // fallthrough
+    case VM_RIV: // fallthrough
+    case VM_POW: // fallthrough
+    case VM_MOD: // fallthrough
+    case VM_IDX: // fallthrough
+    case VM_MRG: // fallthrough
+    case VM_EQ:  // fallthrough
+    case VM_NEQ: // fallthrough
+    case VM_GT:  // fallthrough
+    case VM_LT:  // fallthrough
+    case VM_GTE: // fallthrough
+    case VM_LTE: // fallthrough
+    case VM_MIN: // fallthrough
+    case VM_MAX: // fallthrough
+    case VM_IAK: pops = 2, push = 1; break;
+
+    case VM_IDA: pops = 3, push = 1; break;
+    case VM_INV: pops = arg + 1, push = 1; break;
+
+    // Decoding already turned these away
+    default: SET_ERR("unknown instruction"); return false;
+  }
+
+  // Indices into the read only data & the symbols
+  uint32_t rod = UINT32_MAX;
+  uint32_t sym = UINT32_MAX;
+
+  if (VM_VAL <= op && op <= VM_VAL4) rod = arg;
+  if (VM_SYM <= op && op <= VM_ASN4) sym = arg;
+  if (op == VM_DLL || op == VM_FFN || op == VM_FFT) sym = arg;
+  if (op == VM_IDK || op == VM_IAK) rod = arg;
+  if (op == VM_INV || op == VM_NTV) rod = ins.args[1];
+
+  if (rod != UINT32_MAX && rod >= prg->rod.len) {
+    SET_ERR("instruction reads past the read only data");
+    return false;
+  }
+
+  if (op == VM_NTV && prg->rod.arr[rod].type != T_STR) {
+    SET_ERR("typed call without a signature");
+    return false;
+  }
+
+  if (sym != UINT32_MAX && sym >= prg->stb.len) {
+    SET_ERR("instruction reads past the symbols");
+    return false;
+  }
+
+  // Locals are counted from the frame's base, arguments included
+  if (op == VM_PSH || op == VM_STR) {
+    ana->need = MAX(ana->need, (int32_t)arg + 1 - depth);
+  }
+
+  ana->need = MAX(ana->need, pops - depth);
+  depth     = depth - pops + push;
+  ana->peak = MAX(ana->peak, depth);
+
+  if (jumps && !reach(ana, land, depth, err)) return false;
+
+  if (falls && next >= ana->len) {
+    SET_ERR("instructions run past the end of the code");
+    return false;
+  }
+
+  return !falls || reach(ana, next, depth, err);
+}
+
+static bool analyze(Verifier *ver, Analysis *ana, const uint8_t *code,
+                    uint32_t len, uint32_t entry) {
+  const char **err = ver->err;
+  bool         ok  = true;
+
+  ana->code = code;
+  ana->len  = len;
+  ana->todo = 0;
+  ana->need = 0;
+  ana->peak = 0;
+
+  if (len == 0) {
+    SET_ERR("instructions run past the end of the code");
+    return false;
+  }
+
+  // Words are loaded with aligned reads
+  if (ana->wcd && ((uintptr_t)code % 4 != 0 || len % 4 != 0)) {
+    SET_ERR("instructions are not aligned to words");
+    return false;
+  }
+
+  ana->starts = memory(NULL, 0, sizeof(uint8_t) * len);
+  ana->depth  = memory(NULL, 0, sizeof(int32_t) * len);
+  ana->work   = memory(NULL, 0, sizeof(uint32_t) * len);
+  memset(ana->starts, 0x0, sizeof(uint8_t) * len);
+
+  // Every instruction is decoded, reachable or not
+  for (uint32_t at = 0; ok && at < len;) {
+    Instruction ins;
+    const char *bad = decode(ana, at, &ins);
+
+    if (bad) {
+      SET_ERR(bad);
+      ok = false;
+      break;
+    }
+
+    ana->starts[at] = true;
+    ana->depth[at]  = UNSEEN;
+    at += ins.size;
+  }
+
+  ok = ok && reach(ana, entry, 0, err);
+
+  while (ok && ana->todo > 0) {
+    ok = step(ver, ana, ana->work[--ana->todo]);
+  }
+
+  release(ana->starts, sizeof(uint8_t) * len);
+  release(ana->depth, sizeof(int32_t) * len);
+  release(ana->work, sizeof(uint32_t) * len);
+
+  if (ok && ana->need + ana->peak > MOTHVM_STK_CAP) {
+    SET_ERR("code needs more stack than there is");
+    return false;
+  }
+
+  if (ok) ver->prg->msd = MAX(ver->prg->msd, (uint32_t)ana->peak);
+  return ok;
+}
+
+static bool verify_subroutines(Verifier *ver) {
+  const char **err = ver->err;
+  Analysis     ana = {.top = false, .wcd = ver->prg->wcd};
+
+  // Analyzing a subroutine may find more of them
+  for (size_t i = 0; i < ver->len; i++) {
+    int32_t need = -1;
+
+    for (size_t j = 0; j < i && need < 0; j++) {
+      if (ver->sites[j].addr == ver->sites[i].addr) need = ver->sites[j].need;
+    }
+
+    if (need < 0) {
+      if (!analyze(ver, &ana, ver->prg->bytes, ver->prg->len,
+                   ver->sites[i].addr)) {
+        return false;
+      }
+
+      need = ana.need;
+    }
+
+    ver->sites[i].need = need;
+
+    if (need > (int32_t)ver->sites[i].argc) {
+      SET_ERR("frame has fewer arguments than its code reads");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool verify_program(Program *prog, const char **err) {
+  SET_ERR(NULL);
+
+  Verifier ver = {
+    .prg = prog, .sites = NULL, .len = 0, .cap = 0, .err = err};
+  Analysis ana = {.top = true, .wcd = prog->wcd};
+
+  prog->msd = 0;
+  bool ok   = analyze(&ver, &ana, prog->bytes, prog->len, 0);
+
+  // The top level frame has no arguments
+  if (ok && ana.need > 0) {
+    SET_ERR("instruction reads below the bottom of the stack");
+    ok = false;
+  }
+
+  for (uint32_t i = 0; ok && i < prog->rod.len; i++) {
+    if (!IS_OBJ_FCT(prog->rod.arr[i])) continue;
+
+    ObjectFunction *fct = OBJ_FCT(prog->rod.arr[i].as.object);
+    ana.top             = false;
+    ok                  = analyze(&ver, &ana, fct->bytes, fct->len, 0);
+
+    // Checked once per call instead of once per instruction
+    fct->arity = ana.need;
+    fct->depth = ana.peak;
+  }
+
+  ok = ok && verify_subroutines(&ver);
+
+  release(ver.sites, sizeof(Site) * ver.cap);
+
+  prog->vfd = ok;
+  return ok;
+}
@@ -5,7 +5,9 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <moth/builtins.h>
 #include <moth/env.h>
+#include <moth/ffi.h>
 #include <moth/garbage.h>
 #include <moth/macros.h>
 #include <moth/mem.h>
@@ -14,6 +16,7 @@
 #include <moth/program.h>
 #include <moth/stack.h>
 #include <moth/value.h>
+#include <moth/verify.h>
 
 typedef Value (*unary_op_fct)(VM *, Value);
 static inline Value unary_op(VM *vm, unary_op_fct f) {
@@ -273,12 +276,15 @@ static inline Value index_(VM *vm, Value container, Value index) {
 
   // Handle dictonaries
   if (IS_OBJ_DCT(container)) {
-    if (!obj_dct_has_key(OBJ_DCT(container.as.object), index)) {
+    ObjectDictionary *dct  = OBJ_DCT(container.as.object);
+    size_t            slot = obj_dct_find(dct, index);
+
+    if (slot == dct->cap) {
       SETERR(STATUS_INVIDX);
       return VOID_VAL;
     }
 
-    return obj_dct_get(OBJ_DCT(container.as.object), index);
+    return dct->entries[slot].value;
   }
 
   SETERR(STATUS_INVTYP);
@@ -315,6 +321,64 @@ static inline Value indexasn_(VM *vm, Value index, Value value) {
   return container;
 }
 
+static inline InlineCache *inline_cache_(VM *vm, uint16_t id) {
+  if (id >= vm->prg->icl) reserve_caches(vm->prg, id + 1);
+  return vm->prg->ics + id;
+}
+
+static inline size_t cached_slot_(
+  VM *vm, ObjectDictionary *dct, uint32_t key, InlineCache *cache) {
+  Value name = RODATA(key);
+
+  // Constant strings are interned by the compiler, if the cached
+  // slot still holds the same pointer then the key is still there
+  if (cache->slot < dct->cap) {
+    Value cached = dct->entries[cache->slot].key;
+    if (cached.type == T_STR && cached.as.string == name.as.string) {
+      return cache->slot;
+    }
+  }
+
+  size_t slot = obj_dct_find_hashed(dct, name, vm->prg->rdh[key]);
+  if (slot < dct->cap) cache->slot = slot;
+  return slot;
+}
+
+static inline void index_key_(VM *vm, uint32_t key, uint16_t id) {
+  Value container = POP();
+
+  if (!IS_OBJ_DCT(container)) {
+    PUSH(index_(vm, container, RODATA(key)));
+    return;
+  }
+
+  ObjectDictionary *dct  = OBJ_DCT(container.as.object);
+  size_t            slot = cached_slot_(vm, dct, key, inline_cache_(vm, id));
+
+  if (slot == dct->cap) ERROR(STATUS_INVIDX);
+  PUSH(dct->entries[slot].value);
+}
+
+static inline void indexasn_key_(VM *vm, uint32_t key, uint16_t id) {
+  Value value     = POP();
+  Value container = POP();
+
+  if (!IS_OBJ_DCT(container)) ERROR(STATUS_INVTYP);
+
+  ObjectDictionary *dct   = OBJ_DCT(container.as.object);
+  InlineCache *     cache = inline_cache_(vm, id);
+  size_t            slot  = cached_slot_(vm, dct, key, cache);
+
+  if (slot < dct->cap) {
+    dct->entries[slot].value = value;
+  } else {
+    Value name  = RODATA(key);
+    cache->slot = obj_dct_insert_hashed(dct, name, vm->prg->rdh[key], value);
+  }
+
+  PUSH(container);
+}
+
 static inline Value merge_(VM *vm, Value a, Value b) {
   // Handle arrays
   if (IS_OBJ_ARR(a) && IS_OBJ_ARR(b)) {
@@ -389,6 +453,102 @@ static inline Value less_eq_(VM *vm, Value a, Value b) {
 
 #undef NUM_ORDERING_OP
 
+//                   _   _                                         //
+//                  | | | |                                        //
+//   _ __ ___   __ _| |_| |__                                      //
+//  | '_ ` _ \ / _` | __| '_ \                                     //
+//  | | | | | | (_| | |_| | | |                                    //
+//  |_| |_| |_|\__,_|\__|_| |_|                                    //
+//                                                                 //
+//                                                                 //
+
+#define REAL_UNARY_OP(fn)                                                      \
+  switch (a.type) {                                                            \
+    case T_INT: return REAL_VAL(fn((double)a.as.integer));                     \
+    case T_REAL: return REAL_VAL(fn(a.as.real));                               \
+    default: SETERR(STATUS_INVTYP); return VOID_VAL;                           \
+  }
+
+static inline Value sqrt_(VM *vm, Value a) {
+  REAL_UNARY_OP(sqrt);
+}
+
+static inline Value sin_(VM *vm, Value a) {
+  REAL_UNARY_OP(sin);
+}
+
+static inline Value cos_(VM *vm, Value a) {
+  REAL_UNARY_OP(cos);
+}
+
+static inline Value exp_(VM *vm, Value a) {
+  REAL_UNARY_OP(exp);
+}
+
+static inline Value log_(VM *vm, Value a) {
+  REAL_UNARY_OP(log);
+}
+
+#undef REAL_UNARY_OP
+
+static inline Value floor_(VM *vm, Value a) {
+  double floored;
+
+  switch (a.type) {
+    case T_INT: return a;
+
+    case T_REAL:
+      // NaN, infinities and reals past the range
+      // of an int have no integer to floor to
+      floored = floor(a.as.real);
+
+      if (!(floored >= -0x1p63 && floored < 0x1p63)) {
+        SETERR(STATUS_INVARG);
+        return VOID_VAL;
+      }
+
+      return INT_VAL((int64_t)floored);
+
+    default: SETERR(STATUS_INVTYP); return VOID_VAL;
+  }
+}
+
+static inline Value abs_(VM *vm, Value a) {
+  switch (a.type) {
+    case T_INT:
+      // The smallest int has no positive counterpart
+      if (a.as.integer == INT64_MIN) {
+        SETERR(STATUS_INVARG);
+        return VOID_VAL;
+      }
+
+      return INT_VAL(a.as.integer < 0 ? -a.as.integer : a.as.integer);
+
+    case T_REAL: return REAL_VAL(fabs(a.as.real));
+    default: SETERR(STATUS_INVTYP); return VOID_VAL;
+  }
+}
+
+static inline Value min_(VM *vm, Value a, Value b) {
+  switch (TUP(a.type, b.type)) {
+    case TUP(T_INT, T_INT): return INT_VAL(MIN(a.as.integer, b.as.integer));
+    case TUP(T_REAL, T_REAL): return REAL_VAL(fmin(a.as.real, b.as.real));
+    case TUP(T_INT, T_REAL): return REAL_VAL(fmin(a.as.integer, b.as.real));
+    case TUP(T_REAL, T_INT): return REAL_VAL(fmin(a.as.real, b.as.integer));
+    default: SETERR(STATUS_INVTYP); return VOID_VAL;
+  }
+}
+
+static inline Value max_(VM *vm, Value a, Value b) {
+  switch (TUP(a.type, b.type)) {
+    case TUP(T_INT, T_INT): return INT_VAL(MAX(a.as.integer, b.as.integer));
+    case TUP(T_REAL, T_REAL): return REAL_VAL(fmax(a.as.real, b.as.real));
+    case TUP(T_INT, T_REAL): return REAL_VAL(fmax(a.as.integer, b.as.real));
+    case TUP(T_REAL, T_INT): return REAL_VAL(fmax(a.as.real, b.as.integer));
+    default: SETERR(STATUS_INVTYP); return VOID_VAL;
+  }
+}
+
 //    __                  _   _                                    //
 //   / _|                | | (_)                                   //
 //  | |_ _   _ _ __   ___| |_ _  ___  _ __  ___                    //
@@ -398,8 +558,12 @@ static inline Value less_eq_(VM *vm, Value a, Value b) {
 //                                                                 //
 //                                                                 //
 
-static inline void frame_(VM *vm, uint32_t addr) {
-  stk_invoke(&vm->stk, vm->ip, ARG1);
+static inline void frame_(VM *vm, uint32_t addr, uint8_t argc) {
+  // Subroutines aren't objects, they are checked against
+  // the deepest stack any verified code needs
+  if (!stk_room(&vm->stk, vm->prg->msd)) ERROR(STATUS_STKOVF);
+
+  stk_invoke(&vm->stk, vm->ip, argc);
   vm->ip = vm->prg->bytes + addr;
 }
 
@@ -412,26 +576,81 @@ static inline void closeover_(VM *vm) {
   PUSH(OBJ_VAL(closure));
 }
 
-static inline void call_(VM *vm, uint8_t argc) {
-  Value value = POP();
+static inline VMStatus ffi_status_(FFIResult res) {
+  switch (res) {
+    case FFI_RESULT_OK: return STATUS_OK;
+    case FFI_RESULT_ARITY: return STATUS_INVARG;
+    case FFI_RESULT_TYPES: return STATUS_INVTYP;
+    case FFI_RESULT_TAG: return STATUS_INVTYP;
+    default: return STATUS_FFIERR;
+  }
+}
+
+static inline void ffi_call_(VM *vm, Object *fun, uint8_t argc) {
+  Value *   argv = vm->stk.vtop - argc;
+  Value     ret  = VOID_VAL;
+  FFIResult res;
+
+  if (fun->type == O_FFI_NATIVE) {
+    res = ffi_ntv_call(OBJ_FFI_NTV(fun), argv, argc, &ret);
+  } else {
+    res = OBJ_FFI_FUN(fun)->fun(argv, argc, &ret);
+  }
+
+  // Drop the arguments
+  vm->stk.vtop = argv;
+
+  if (res != FFI_RESULT_OK) ERROR(ffi_status_(res));
+
+  // Objects returned by natives are always fresh
+  if (IS_OBJ(ret)) gc_register(&vm->gc, ret.as.object);
+  PUSH(ret);
+}
+
+static inline void enter_(VM *vm, ObjectFunction *fct, uint8_t argc) {
+  // The verifier knows what the body needs, so these are
+  // the only checks until the function returns
+  if (argc < fct->arity) ERROR(STATUS_INVARG);
+  if (!stk_room(&vm->stk, fct->depth)) ERROR(STATUS_STKOVF);
+
+  stk_invoke(&vm->stk, vm->ip, argc);
+  vm->ip = fct->bytes;
+}
 
+static inline void call_value_(VM *vm, Value value, uint8_t argc) {
   if (IS_OBJ_FCT(value)) {
-    ObjectFunction *fct = OBJ_FCT(value.as.object);
-    stk_invoke(&vm->stk, vm->ip, argc);
-    vm->ip = fct->bytes;
+    enter_(vm, OBJ_FCT(value.as.object), argc);
     return;
   }
 
   if (IS_OBJ_CLJ(value)) {
-    ObjectClosure *clj = OBJ_CLJ(value.as.object);
-    stk_invoke(&vm->stk, vm->ip, argc);
-    vm->ip = clj->fct->bytes;
+    enter_(vm, OBJ_CLJ(value.as.object)->fct, argc);
+    return;
+  }
+
+  if (IS_OBJ_FFI_FCT(value) || IS_OBJ_FFI_NTV(value)) {
+    ffi_call_(vm, value.as.object, argc);
     return;
   }
 
   ERROR(STATUS_NOTFUN);
 }
 
+static inline void call_(VM *vm, uint8_t argc) {
+  call_value_(vm, POP(), argc);
+}
+
+static inline void invoke_(VM *vm, uint8_t argc, uint32_t key, uint16_t id) {
+  Value receiver = POP();
+  if (!IS_OBJ_DCT(receiver)) ERROR(STATUS_INVTYP);
+
+  ObjectDictionary *dct  = OBJ_DCT(receiver.as.object);
+  size_t            slot = cached_slot_(vm, dct, key, inline_cache_(vm, id));
+
+  if (slot == dct->cap) ERROR(STATUS_INVIDX);
+  call_value_(vm, dct->entries[slot].value, argc);
+}
+
 static inline void promote_(VM *vm) {
   Value   promoted = POP();
   Object *obj      = (Object *)obj_hpv_promote(promoted);
@@ -477,6 +696,190 @@ static inline void dictionary_(VM *vm, uint8_t size) {
   PUSH(OBJ_VAL(obj));
 }
 
+//    __  __ _                                                     //
+//   / _|/ _(_)                                                    //
+//  | |_| |_ _                                                     //
+//  |  _|  _| |                                                    //
+//  | | | | | |                                                    //
+//  |_| |_| |_|                                                    //
+//                                                                 //
+//                                                                 //
+
+static inline void dll_(VM *vm, uint32_t sym) {
+  const char *name = vm->prg->stb.arr[sym].str;
+
+  // Builtin libraries are linked into the VM, there
+  // is nothing to open
+  if (builtin_library(name)) {
+    Object *obj = (Object *)obj_ffi_ptr_new(MOTH_BUILTIN_TAG, NULL, NULL);
+    gc_register(&vm->gc, obj);
+    PUSH(OBJ_VAL(obj));
+    return;
+  }
+
+  void *dll = ffi_dll_open(name);
+  if (!dll) ERROR(STATUS_FFIERR);
+
+  // Libraries stay loaded for the lifetime of the
+  // process, so the pointer has no deleter
+  Object *obj = (Object *)obj_ffi_ptr_new(MOTH_FFI_DLL_TAG, dll, NULL);
+  gc_register(&vm->gc, obj);
+  PUSH(OBJ_VAL(obj));
+}
+
+static inline void *dll_symbol_(VM *vm, uint32_t sym, bool *moth) {
+  Value val = TOP();
+
+  if (!IS_OBJ_FFI_PTR(val)) {
+    SETERR(STATUS_INVTYP);
+    return NULL;
+  }
+
+  ObjectFFIPointer *dll = OBJ_FFI_PTR(val.as.object);
+  void *            fn  = NULL;
+
+  switch (dll->tag) {
+    case MOTH_BUILTIN_TAG: {
+      // Resolved when the program was linked
+      *moth = true;
+      fn    = (void *)vm->prg->ntv[sym];
+      break;
+    }
+
+    case MOTH_FFI_DLL_TAG: {
+      *moth = ffi_dll_is_library(dll->ptr);
+      fn    = ffi_dll_symbol(dll->ptr, vm->prg->stb.arr[sym].str);
+      break;
+    }
+
+    default: SETERR(STATUS_INVTYP); return NULL;
+  }
+
+  if (!fn) SETERR(STATUS_FFIERR);
+  return fn;
+}
+
+static inline void ffn_(VM *vm, uint32_t sym) {
+  bool  moth = false;
+  void *fn   = dll_symbol_(vm, sym, &moth);
+  if (!fn) return;
+
+  Object *obj = (Object *)obj_ffi_fun_new((FFIFunction)fn);
+  gc_register(&vm->gc, obj);
+  PUSH(OBJ_VAL(obj));
+}
+
+static inline void fft_(VM *vm, uint32_t sym) {
+  Value       val = POP();
+  const char *sig = string_value(val);
+  if (!sig) ERROR(STATUS_INVTYP);
+
+  bool  moth = false;
+  void *fn   = dll_symbol_(vm, sym, &moth);
+  if (!fn) return;
+
+  // Functions of moth libraries check their own arguments,
+  // the signature is only needed for plain C functions
+  Object *obj = moth ? (Object *)obj_ffi_fun_new((FFIFunction)fn)
+                     : (Object *)obj_ffi_ntv_new((FFINative)fn, sig);
+
+  if (!obj) ERROR(STATUS_FFIERR);
+
+  // Call sites compiled against the same constant pass their
+  // arguments unchecked, pointers are boxed so they never can
+  if (!moth && IS_STR(val) && !strchr(sig + 1, 'p')) {
+    OBJ_FFI_NTV(obj)->src = sig;
+  }
+
+  gc_register(&vm->gc, obj);
+  PUSH(OBJ_VAL(obj));
+}
+
+static inline void native_(VM *vm, uint8_t argc, uint32_t sig) {
+  Value fun = POP();
+
+  if (!IS_OBJ_FFI_NTV(fun)) {
+    call_value_(vm, fun, argc);
+    return;
+  }
+
+  // Constant strings are interned, the same pointer
+  // means the function has the call site's signature
+  ObjectFFINative *ntv = OBJ_FFI_NTV(fun.as.object);
+
+  if (ntv->src != RODATA(sig).as.string || ntv->argc != argc) {
+    call_value_(vm, fun, argc);
+    return;
+  }
+
+  Value *argv  = vm->stk.vtop - argc;
+  Value  ret   = ffi_ntv_call_typed(ntv, argv);
+  vm->stk.vtop = argv;
+
+  // Objects returned by natives are always fresh
+  if (IS_OBJ(ret)) gc_register(&vm->gc, ret.as.object);
+  PUSH(ret);
+}
+
+// Instructions with more than one operand read the others
+// here, in order, bytecode operands first & then wordcode ones
+
+static inline void frame_bytes_(VM *vm, uint32_t addr) {
+  uint8_t argc = ARG1;
+  frame_(vm, addr, argc);
+}
+
+static inline void index_key_bytes_(VM *vm) {
+  uint32_t key = ARG4;
+  uint16_t id  = ARG2;
+  index_key_(vm, key, id);
+}
+
+static inline void indexasn_key_bytes_(VM *vm) {
+  uint32_t key = ARG4;
+  uint16_t id  = ARG2;
+  indexasn_key_(vm, key, id);
+}
+
+static inline void invoke_bytes_(VM *vm) {
+  uint8_t  argc = ARG1;
+  uint32_t key  = ARG4;
+  uint16_t id   = ARG2;
+  invoke_(vm, argc, key, id);
+}
+
+static inline void native_bytes_(VM *vm) {
+  uint8_t  argc = ARG1;
+  uint32_t sig  = ARG4;
+  native_(vm, argc, sig);
+}
+
+static inline void frame_words_(VM *vm, uint32_t addr) {
+  uint8_t argc = WORD();
+  frame_(vm, addr, argc);
+}
+
+static inline void index_key_words_(VM *vm, uint32_t key) {
+  uint16_t id = WORD();
+  index_key_(vm, key, id);
+}
+
+static inline void indexasn_key_words_(VM *vm, uint32_t key) {
+  uint16_t id = WORD();
+  indexasn_key_(vm, key, id);
+}
+
+static inline void invoke_words_(VM *vm, uint8_t argc) {
+  uint32_t key = WORD();
+  uint16_t id  = WORD();
+  invoke_(vm, argc, key, id);
+}
+
+static inline void native_words_(VM *vm, uint8_t argc) {
+  uint32_t sig = WORD();
+  native_(vm, argc, sig);
+}
+
 //                            _   _                                //
 //                           | | (_)                               //
 //    _____  _____  ___ _   _| |_ _  ___  _ __                     //
@@ -498,14 +901,20 @@ void init_vm(VM *vm) {
   init_env(&vm->env);
 
   // initialize garbage collection
-  init_gc(&vm->gc, &vm->stk);
+  init_gc(&vm->gc, &vm->stk, &vm->env);
 }
 
 void vm_run(VM *vm, Program *prog) {
   vm->prg = prog;
   vm->ip  = prog->bytes;
-  vm->st  = STATUS_OK;
 
+  vm_resume(vm);
+}
+
+// Instructions that fail only set the status, the program stops
+// right after them & the stack is left as it was when they failed
+
+static void run_bytes_(VM *vm) {
   do {
 
 #define MOTH_PRINT_ON_EXEC
@@ -520,6 +929,12 @@ void vm_run(VM *vm, Program *prog) {
       CASE(VM_GC, gc_collect(&vm->gc));
       CASE(VM_DBG, BREAKPOINT());
 
+      // Foreign functions
+      CASE(VM_DLL, FUNC(dll_, ARG4));
+      CASE(VM_FFN, FUNC(ffn_, ARG4));
+      CASE(VM_FFT, FUNC(fft_, ARG4));
+      CASE(VM_NTV, FUNC(native_bytes_));
+
       // Stack operations
       CASE(VM_POP, POP());
       CASE(VM_PSH, PUSH(GET_LOCAL(ARG2)));
@@ -562,10 +977,10 @@ void vm_run(VM *vm, Program *prog) {
       CASE(VM_ASN4, ASSIGN_SYMBOL(ARG4));
 
       // Function operations
-      CASE(VM_FRM, FUNC(frame_, ARG1));
-      CASE(VM_FRM2, FUNC(frame_, ARG2));
-      CASE(VM_FRM3, FUNC(frame_, ARG3));
-      CASE(VM_FRM4, FUNC(frame_, ARG4));
+      CASE(VM_FRM, FUNC(frame_bytes_, ARG1));
+      CASE(VM_FRM2, FUNC(frame_bytes_, ARG2));
+      CASE(VM_FRM3, FUNC(frame_bytes_, ARG3));
+      CASE(VM_FRM4, FUNC(frame_bytes_, ARG4));
 
       // Key values
       CASE(VM_VID, PUSH(VOID_VAL));
@@ -599,6 +1014,120 @@ void vm_run(VM *vm, Program *prog) {
       CASE(VM_IDX, BOP(index_));
       CASE(VM_IDA, BOP(indexasn_));
       CASE(VM_MRG, BOP(merge_));
+      CASE(VM_IDK, FUNC(index_key_bytes_));
+      CASE(VM_IAK, FUNC(indexasn_key_bytes_));
+
+      // Binary operations (boolean)
+      CASE(VM_EQ, BOP(equal_));
+      CASE(VM_NEQ, BOP(not_equal_));
+      CASE(VM_GT, BOP(greater_));
+      CASE(VM_LT, BOP(greater_eq_));
+      CASE(VM_GTE, BOP(less_));
+      CASE(VM_LTE, BOP(less_eq_));
+
+      // Math intrinsics
+      CASE(VM_SQT, UOP(sqrt_));
+      CASE(VM_FLR, UOP(floor_));
+      CASE(VM_ABS, UOP(abs_));
+      CASE(VM_SIN, UOP(sin_));
+      CASE(VM_COS, UOP(cos_));
+      CASE(VM_EXP, UOP(exp_));
+      CASE(VM_LOG, UOP(log_));
+      CASE(VM_MIN, BOP(min_));
+      CASE(VM_MAX, BOP(max_));
+
+      // Method calls
+      CASE(VM_INV, FUNC(invoke_bytes_));
+    }
+  } while (vm->st == STATUS_OK);
+}
+
+static void run_words_(VM *vm) {
+  // High byte of the next operand, set by VM_EXT
+  uint32_t ext = 0;
+
+  do {
+
+#ifdef MOTH_PRINT_ON_EXEC
+    PRINT_STRACE
+#endif
+
+    uint32_t word = WORD();
+    uint32_t arg  = ext | WORD_ARG(word);
+    ext           = 0;
+
+    switch (WORD_OP(word)) {
+      // VM conditioning insturctions
+      CASE(VM_FIN, FINISH());
+      CASE(VM_NOP, NOTHING());
+      CASE(VM_GC, gc_collect(&vm->gc));
+      CASE(VM_DBG, BREAKPOINT());
+      CASE(VM_EXT, ext = arg << 24);
+
+      // Foreign functions
+      CASE(VM_DLL, FUNC(dll_, arg));
+      CASE(VM_FFN, FUNC(ffn_, arg));
+      CASE(VM_FFT, FUNC(fft_, arg));
+      CASE(VM_NTV, FUNC(native_words_, arg));
+
+      // Stack operations
+      CASE(VM_POP, POP());
+      CASE(VM_PSH, PUSH(GET_LOCAL(arg)));
+      CASE(VM_STR, SET_LOCAL(arg, TOP()));
+
+      // Jumps
+      CASE(VM_JMP, JUMP(arg));
+      CASE(VM_JPT, JUMP(TRUTHY() * arg));
+      CASE(VM_JPF, JUMP(FALSY() * arg));
+      CASE(VM_JBW, JUMP(-(int64_t)arg));
+
+      // Function operations
+      CASE(VM_CLO, FUNC(closeover_));
+      CASE(VM_CAL, FUNC(call_, arg));
+      CASE(VM_PRO, FUNC(promote_));
+      CASE(VM_RET, FUNC(return_));
+      CASE(VM_FRM, FUNC(frame_words_, arg));
+
+      // Symbols & read only data
+      CASE(VM_VAL, PUSH(RODATA(arg)));
+      CASE(VM_SYM, LOAD_SYMBOL(arg));
+      CASE(VM_DEF, DEFINE_SYMBOL(arg));
+      CASE(VM_ASN, ASSIGN_SYMBOL(arg));
+
+      // Key values
+      CASE(VM_VID, PUSH(VOID_VAL));
+      CASE(VM_TRU, PUSH(BOOL_VAL(true)));
+      CASE(VM_FAL, PUSH(BOOL_VAL(false)));
+
+      // Mathematical constants
+      CASE(VM_PI, PUSH(REAL_VAL(M_PI)));
+      CASE(VM_TAU, PUSH(REAL_VAL(2.0 * M_PI)));
+      CASE(VM_EUL, PUSH(REAL_VAL(M_E)));
+
+      // Create operations
+      CASE(VM_VEC, FUNC(vector_, arg));
+      CASE(VM_ARR, FUNC(array_, arg));
+      CASE(VM_DCT, FUNC(dictionary_, arg));
+
+      // Unary operations
+      CASE(VM_NEG, UOP(negate_));
+      CASE(VM_NOT, UOP(not_));
+
+      // Binary operations (arithmetic)
+      CASE(VM_ADD, BOP(add_));
+      CASE(VM_SUB, BOP(subtract_));
+      CASE(VM_MUL, BOP(multiply_));
+      CASE(VM_DIV, BOP(divide_));
+      CASE(VM_RIV, BOP(rounddiv_));
+      CASE(VM_POW, BOP(power_));
+      CASE(VM_MOD, BOP(modulo_));
+
+      // Indexing operations
+      CASE(VM_IDX, BOP(index_));
+      CASE(VM_IDA, BOP(indexasn_));
+      CASE(VM_MRG, BOP(merge_));
+      CASE(VM_IDK, FUNC(index_key_words_, arg));
+      CASE(VM_IAK, FUNC(indexasn_key_words_, arg));
 
       // Binary operations (boolean)
       CASE(VM_EQ, BOP(equal_));
@@ -607,8 +1136,46 @@ void vm_run(VM *vm, Program *prog) {
       CASE(VM_LT, BOP(greater_eq_));
       CASE(VM_GTE, BOP(less_));
       CASE(VM_LTE, BOP(less_eq_));
+
+      // Math intrinsics
+      CASE(VM_SQT, UOP(sqrt_));
+      CASE(VM_FLR, UOP(floor_));
+      CASE(VM_ABS, UOP(abs_));
+      CASE(VM_SIN, UOP(sin_));
+      CASE(VM_COS, UOP(cos_));
+      CASE(VM_EXP, UOP(exp_));
+      CASE(VM_LOG, UOP(log_));
+      CASE(VM_MIN, BOP(min_));
+      CASE(VM_MAX, BOP(max_));
+
+      // Method calls
+      CASE(VM_INV, FUNC(invoke_words_, arg));
     }
-  } while (true);
+  } while (vm->st == STATUS_OK);
+}
+
+void vm_resume(VM *vm) {
+  // Finished programs have nothing left to run
+  if (vm->ip >= vm->prg->bytes + vm->prg->len) return;
+
+  // Programs built in memory haven't been linked yet, and programs
+  // that grew since they last ran have symbols and values to link
+  link_program(vm->prg);
+
+  // Instructions are verified once, after that they
+  // run without any bounds or stack checks
+  if (!vm->prg->vfd && !verify_program(vm->prg, NULL)) {
+    ERROR(STATUS_INVBYT);
+  }
+
+  vm->st = STATUS_OK;
+
+  // The encoding is fixed for the whole program
+  if (vm->prg->wcd) {
+    run_words_(vm);
+  } else {
+    run_bytes_(vm);
+  }
 }
 
 void free_vm(VM *vm) {
@@ -0,0 +1,160 @@
+#include <silk/language/classify.h>
+
+#include <algorithm>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  #include <immintrin.h>
+  #define CLASSIFY_X86
+#endif
+
+namespace silk {
+
+constexpr auto is_space(unsigned char c) noexcept -> bool {
+  return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t';
+}
+
+constexpr auto is_alnum(unsigned char c) noexcept -> bool {
+  return (unsigned char)(c - '0') <= 9 ||
+         (unsigned char)((c | 0x20) - 'a') <= 'z' - 'a';
+}
+
+static auto whitespace_scalar(const char *it, const char *end) -> const char * {
+  while (it < end && is_space(*it)) it++;
+  return it;
+}
+
+static auto alphanumeric_scalar(const char *it, const char *end)
+  -> const char * {
+  while (it < end && is_alnum(*it)) it++;
+  return it;
+}
+
+#ifdef CLASSIFY_X86
+
+// Blocks are classified at once, a byte is in a range when
+// subtracting the lower bound leaves it at most the width,
+// unsigned comparisons are done with min & equality
+
+static inline auto in_range_sse2(__m128i bytes, char low, char width)
+  -> __m128i {
+  const auto shifted = _mm_sub_epi8(bytes, _mm_set1_epi8(low));
+  const auto bounded = _mm_min_epu8(shifted, _mm_set1_epi8(width));
+  return _mm_cmpeq_epi8(shifted, bounded);
+}
+
+static inline auto space_sse2(__m128i bytes) -> __m128i {
+  const auto blank = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '));
+  return _mm_or_si128(blank, in_range_sse2(bytes, '\t', '\r' - '\t'));
+}
+
+static inline auto alnum_sse2(__m128i bytes) -> __m128i {
+  const auto lower = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+  const auto digit = in_range_sse2(bytes, '0', 9);
+  return _mm_or_si128(digit, in_range_sse2(lower, 'a', 'z' - 'a'));
+}
+
+template <__m128i (*Class)(__m128i), bool (*Scalar)(unsigned char)>
+static auto skip_sse2(const char *it, const char *end) -> const char * {
+  // Runs are often empty, e.g. no space between two tokens
+  if (it == end || !Scalar(*it)) return it;
+
+  for (; end - it >= 16; it += 16) {
+    const auto bytes = _mm_loadu_si128((const __m128i *)it);
+    const auto mask  = (unsigned)_mm_movemask_epi8(Class(bytes));
+    if (mask != 0xffff) return it + __builtin_ctz(~mask);
+  }
+
+  while (it < end && Scalar(*it)) it++;
+  return it;
+}
+
+__attribute__((target("avx2"))) static inline auto
+in_range_avx2(__m256i bytes, char low, char width) -> __m256i {
+  const auto shifted = _mm256_sub_epi8(bytes, _mm256_set1_epi8(low));
+  const auto bounded = _mm256_min_epu8(shifted, _mm256_set1_epi8(width));
+  return _mm256_cmpeq_epi8(shifted, bounded);
+}
+
+__attribute__((target("avx2"))) static inline auto space_avx2(__m256i bytes)
+  -> __m256i {
+  const auto blank = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' '));
+  return _mm256_or_si256(blank, in_range_avx2(bytes, '\t', '\r' - '\t'));
+}
+
+__attribute__((target("avx2"))) static inline auto alnum_avx2(__m256i bytes)
+  -> __m256i {
+  const auto lower = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+  const auto digit = in_range_avx2(bytes, '0', 9);
+  return _mm256_or_si256(digit, in_range_avx2(lower, 'a', 'z' - 'a'));
+}
+
+template <
+  __m256i (*Class)(__m256i),
+  __m128i (*Narrow)(__m128i),
+  bool (*Scalar)(unsigned char)>
+__attribute__((target("avx2"))) static auto
+skip_avx2(const char *it, const char *end) -> const char * {
+  // Runs are often empty, e.g. no space between two tokens
+  if (it == end || !Scalar(*it)) return it;
+
+  // Wide blocks only pay off once the run is longer than a narrow one
+  if (end - it >= 16) {
+    const auto bytes = _mm_loadu_si128((const __m128i *)it);
+    const auto mask  = (unsigned)_mm_movemask_epi8(Narrow(bytes));
+    if (mask != 0xffff) return it + __builtin_ctz(~mask);
+    it += 16;
+  }
+
+  for (; end - it >= 32; it += 32) {
+    const auto bytes = _mm256_loadu_si256((const __m256i *)it);
+    const auto mask  = (unsigned)_mm256_movemask_epi8(Class(bytes));
+    if (mask != 0xffffffff) return it + __builtin_ctz(~mask);
+  }
+
+  while (it < end && Scalar(*it)) it++;
+  return it;
+}
+
+#endif
+
+auto classifiers() -> std::vector<Classifier> {
+  auto all = std::vector<Classifier>{
+    {"scalar", whitespace_scalar, alphanumeric_scalar},
+  };
+
+#ifdef CLASSIFY_X86
+  // SSE2 is part of every x86-64 CPU
+  all.push_back({
+    "sse2",
+    skip_sse2<space_sse2, is_space>,
+    skip_sse2<alnum_sse2, is_alnum>,
+  });
+
+  if (__builtin_cpu_supports("avx2")) {
+    all.push_back({
+      "avx2",
+      skip_avx2<space_avx2, space_sse2, is_space>,
+      skip_avx2<alnum_avx2, alnum_sse2, is_alnum>,
+    });
+  }
+#endif
+
+  return all;
+}
+
+auto classifier() noexcept -> const Classifier & {
+  // Runs in sources are mostly shorter than an AVX2 block, on
+  // benchmarks/scanner.cxx it is slower than SSE2 so it is never picked
+  static const auto fastest = [] {
+    const auto all = classifiers();
+    const auto it  = std::find_if(all.begin(), all.end(), [](auto &c) {
+      return c.name == "sse2";
+    });
+
+    return it != all.end() ? *it : all.front();
+  }();
+
+  return fastest;
+}
+
+} // namespace silk
@@ -0,0 +1,150 @@
+#include <silk/language/intrinsics.h>
+
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <variant>
+
+namespace silk {
+
+static constexpr auto intrinsic_names =
+  std::array<std::pair<std::string_view, Intrinsic>, 9>{{
+    {"sqrt", Intrinsic::SQRT},
+    {"floor", Intrinsic::FLOOR},
+    {"abs", Intrinsic::ABS},
+    {"sin", Intrinsic::SIN},
+    {"cos", Intrinsic::COS},
+    {"exp", Intrinsic::EXP},
+    {"log", Intrinsic::LOG},
+    {"min", Intrinsic::MIN},
+    {"max", Intrinsic::MAX},
+  }};
+
+auto intrinsic_arity(Intrinsic intrinsic) -> std::size_t {
+  switch (intrinsic) {
+    case Intrinsic::MIN: return 2;
+    case Intrinsic::MAX: return 2;
+    default: return 1;
+  }
+}
+
+// Declarations may be wrapped in the comments written next to them
+static auto uncommented(const st::Node &node) -> const st::Node * {
+  auto *inner = &node;
+
+  while (auto comment = std::get_if<st::Comment>(&inner->data)) {
+    if (!comment->child) break;
+    inner = comment->child.get();
+  }
+
+  return inner;
+}
+
+auto Intrinsics::scan(const std::vector<st::NodePtr> &tree) -> void {
+  _visible.clear();
+  _locals.clear();
+  _scopes.clear();
+  _math_module = false;
+
+  for (auto &ptr : tree) {
+    auto *node = uncommented(*ptr);
+
+    if (auto data = std::get_if<st::ModuleDeclaration>(&node->data)) {
+      declare(*data);
+    } else if (auto data = std::get_if<st::ModuleImport>(&node->data)) {
+      import(*data);
+    }
+  }
+
+  // Shadowed after every import, wherever they are declared
+  for (auto &ptr : tree) {
+    auto *node = uncommented(*ptr);
+
+    if (auto data = std::get_if<st::DeclarationFunction>(&node->data)) {
+      shadow(data->name);
+    } else if (auto data = std::get_if<st::StatementVariable>(&node->data)) {
+      shadow(data->name);
+    } else if (auto data = std::get_if<st::StatementConstant>(&node->data)) {
+      shadow(data->name);
+    } else if (auto lib = std::get_if<st::DeclarationExternLibrary>(
+                 &node->data)) {
+      for (auto &child : lib->children) {
+        if (auto fn = std::get_if<st::DeclarationExternFunction>(&child.data)) {
+          shadow(fn->name);
+        }
+      }
+    }
+  }
+}
+
+auto Intrinsics::enter() -> void {
+  _scopes.push_back(_locals.size());
+}
+
+auto Intrinsics::leave() -> void {
+  _locals.resize(_scopes.back());
+  _scopes.pop_back();
+}
+
+auto Intrinsics::bind(std::string_view name) -> void {
+  if (!_scopes.empty()) _locals.push_back(name);
+}
+
+auto Intrinsics::bind(const st::TypedFields &fields) -> void {
+  for (auto &[name, _] : fields) bind(name);
+}
+
+auto Intrinsics::declare(const st::ModuleDeclaration &data) -> void {
+  if (data.path != MODULE) return;
+
+  _math_module = true;
+  _visible.insert(std::begin(intrinsic_names), std::end(intrinsic_names));
+}
+
+auto Intrinsics::import(const st::ModuleImport &data) -> void {
+  if (data.name != MODULE) return;
+
+  for (const auto &[name, intrinsic] : intrinsic_names) {
+    // An import list only brings in the listed names
+    if (!data.imports.empty() &&
+        std::find(data.imports.begin(), data.imports.end(), name) ==
+          data.imports.end()) {
+      continue;
+    }
+
+    _visible.emplace(name, intrinsic);
+  }
+}
+
+auto Intrinsics::shadow(std::string_view name) -> void {
+  // The math module's own functions are the intrinsics
+  if (_math_module) return;
+  _visible.erase(name);
+}
+
+auto Intrinsics::lookup(const st::ExpressionCall &data) const
+  -> std::optional<Intrinsic> {
+  if (!data.callee) return std::nullopt;
+
+  const auto callee = std::get_if<st::ExpressionIdentifier>(&data.callee->data);
+  if (!callee) return std::nullopt;
+
+  const auto found = _visible.find(callee->name);
+  if (found == _visible.end()) return std::nullopt;
+
+  // Parameters and locals shadow even the math module's functions
+  if (std::find(_locals.rbegin(), _locals.rend(), callee->name) !=
+      _locals.rend()) {
+    return std::nullopt;
+  }
+
+  // Wrong number of arguments is a regular call, and
+  // a regular runtime error
+  if (data.children.size() != intrinsic_arity(found->second)) {
+    return std::nullopt;
+  }
+
+  return found->second;
+}
+
+} // namespace silk
@@ -1,9 +1,91 @@
 #include <silk/language/package.h>
 
+#include <algorithm>
 #include <optional>
+#include <unordered_set>
 
 namespace silk {
 
+template <class T, class Map>
+static auto ordered(T &main, Map &imports) -> std::vector<T *> {
+  auto items = std::vector<T *>{&main};
+
+  for (auto &[_, item] : imports) {
+    items.push_back(&item);
+  }
+
+  // Imports are unordered, sorted so every run agrees
+  std::sort(items.begin() + 1, items.end(), [](auto *a, auto *b) {
+    return a->path < b->path;
+  });
+
+  return items;
+}
+
+auto read_source(Source &source) -> std::shared_ptr<const std::string> {
+  if (source.content) return source.content;
+
+  auto &input  = source.source;
+  auto  buffer = std::make_shared<std::string>();
+
+  // Sized up front, files are read with a single call
+  if (input.seekg(0, std::ios::end); input) {
+    buffer->resize((std::size_t)input.tellg());
+    input.seekg(0, std::ios::beg);
+    input.read(buffer->data(), buffer->size());
+    buffer->resize((std::size_t)input.gcount());
+  }
+
+  source.content = std::move(buffer);
+  return source.content;
+}
+
+auto ModuleGraph::add(const std::string &module, const std::string &import)
+  -> void {
+  _imports[module].push_back(import);
+}
+
+auto ModuleGraph::imports(const std::string &module) const
+  -> const std::vector<std::string> & {
+  static const auto none = std::vector<std::string>{};
+
+  const auto it = _imports.find(module);
+  return it != _imports.end() ? it->second : none;
+}
+
+auto ModuleGraph::sort(std::vector<Module *> &modules) const -> void {
+  auto ranks = std::unordered_map<std::string, std::size_t>{};
+  auto seen  = std::unordered_set<std::string>{};
+
+  // Ranked in depth first post order, a module is only ranked
+  // once everything it imports is, unless they import it back
+  const auto visit = [&](const std::string &path, auto &visit) -> void {
+    if (!seen.insert(path).second) return;
+
+    for (auto &import : imports(path)) {
+      visit(import, visit);
+    }
+
+    ranks.emplace(path, ranks.size());
+  };
+
+  for (auto *module : modules) {
+    visit(module->path, visit);
+  }
+
+  std::stable_sort(modules.begin(), modules.end(), [&](auto *a, auto *b) {
+    return ranks.at(a->path) < ranks.at(b->path);
+  });
+}
+
+auto ordered_sources(PackageSource &pkg_src) -> std::vector<Source *> {
+  return ordered(pkg_src.main, pkg_src.sources);
+}
+
+auto ordered_modules(Package &pkg) -> std::vector<Module *> {
+  return ordered(pkg.main, pkg.modules);
+}
+
 auto token_kind_string(TokenKind kind) -> std::string_view {
   switch (kind) {
     case TokenKind::IDENTIFIER: return "identifier";
@@ -1,14 +1,21 @@
 #include <silk/language/scanner.h>
 
+#include <algorithm>
+#include <array>
 #include <cctype>
-#include <sstream>
-#include <unordered_map>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
 
+#include <silk/language/classify.h>
 #include <silk/language/token.h>
 
+#include <moth/file.h>
+
 namespace silk {
 
-const std::unordered_map<std::string_view, TokenKind> Scanner::keywords = {
+constexpr std::pair<std::string_view, TokenKind> keywords[] = {
   {"main", TokenKind::KW_MAIN},
   {"pkg", TokenKind::KW_PKG},
   {"use", TokenKind::KW_USE},
@@ -45,21 +52,128 @@ const std::unordered_map<std::string_view, TokenKind> Scanner::keywords = {
   {"eul", TokenKind::KEY_EUL},
 };
 
+// Keywords are found with a perfect hash of their length and
+// first & last characters, the multipliers are searched for at
+// compile time so that no two keywords share a slot
+
+constexpr auto KEYWORD_SLOTS = std::size_t{128};
+constexpr auto KEYWORD_EMPTY = std::uint8_t{0xff};
+
+struct KeywordHash {
+  std::size_t first;
+  std::size_t last;
+};
+
+constexpr auto keyword_slot(std::string_view word, KeywordHash hash) noexcept
+  -> std::size_t {
+  return (word.size() + (unsigned char)word.front() * hash.first +
+          (unsigned char)word.back() * hash.last) %
+         KEYWORD_SLOTS;
+}
+
+constexpr auto find_keyword_hash() noexcept -> KeywordHash {
+  for (auto first = std::size_t{1}; first < KEYWORD_SLOTS; first++) {
+    for (auto last = std::size_t{1}; last < KEYWORD_SLOTS; last++) {
+      bool used[KEYWORD_SLOTS] = {};
+      bool perfect             = true;
+
+      for (auto &[word, _] : keywords) {
+        auto slot  = keyword_slot(word, {first, last});
+        perfect    = perfect && !used[slot];
+        used[slot] = true;
+      }
+
+      if (perfect) return {first, last};
+    }
+  }
+
+  return {0, 0};
+}
+
+constexpr auto keyword_hash = find_keyword_hash();
+static_assert(keyword_hash.first != 0, "keywords have no perfect hash");
+
+// Index in `keywords` of the keyword hashed to each slot
+constexpr auto keyword_slots = [] {
+  auto slots = std::array<std::uint8_t, KEYWORD_SLOTS>{};
+  for (auto &slot : slots) slot = KEYWORD_EMPTY;
+
+  for (auto i = std::size_t{0}; i < std::size(keywords); i++) {
+    slots[keyword_slot(keywords[i].first, keyword_hash)] = i;
+  }
+
+  return slots;
+}();
+
+constexpr auto find_keyword(std::string_view word) noexcept
+  -> std::optional<TokenKind> {
+  if (word.empty()) return std::nullopt;
+
+  const auto index = keyword_slots[keyword_slot(word, keyword_hash)];
+  if (index == KEYWORD_EMPTY) return std::nullopt;
+
+  const auto &[keyword, kind] = keywords[index];
+  if (keyword != word) return std::nullopt;
+
+  return kind;
+}
+
+Scanner::Scanner(std::istream &input) : Scanner(nullptr, {}) {
+  auto buffer = std::make_shared<std::string>(
+    std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{});
+
+  _source  = *buffer;
+  _storage = std::move(buffer);
+}
+
+auto Scanner::map(const std::string &path) -> std::optional<Scanner> {
+  auto len = std::size_t{0};
+  auto img = map_image(path.c_str(), &len);
+  if (!img) return std::nullopt;
+
+  // The mapping is dropped along with the last copy of the scanner
+  auto storage = std::shared_ptr<const void>{
+    img, [len](const void *img) { unmap_image((uint8_t *)img, len); }};
+
+  return Scanner{std::move(storage), {(const char *)img, len}};
+}
+
 auto Scanner::peek() const noexcept -> int {
-  return _input.peek();
+  if (_current >= _source.size()) return EOF;
+  return (unsigned char)_source[_current];
 }
 
 auto Scanner::advance() noexcept -> int {
-  auto next = _input.get();
+  if (_current >= _source.size()) return EOF;
+  return (unsigned char)_source[_current++];
+}
+
+// Runs of a character class are skipped in blocks
+auto Scanner::skip(Classifier::SkipFN skip_class) noexcept -> void {
+  const auto begin = _source.data();
+  const auto end   = begin + _source.size();
+  _current         = skip_class(begin + _current, end) - begin;
+}
+
+auto Scanner::lexeme() const noexcept -> std::string_view {
+  return _source.substr(_start, _current - _start);
+}
+
+// Lines are counted in bulk when a token is made
+// instead of checking every character for newlines
+auto Scanner::locate() noexcept -> Location {
+  const auto seen = _source.substr(_mark, _current - _mark);
+
+  _location.first += std::count(seen.begin(), seen.end(), '\n');
 
-  if (next == '\n') {
-    _location.first++;
-    _location.second = 0;
-  } else {
-    _location.second++;
+  if (auto nl = seen.rfind('\n'); nl != std::string_view::npos) {
+    _line_start = _mark + nl + 1;
   }
 
-  return next;
+  _location.second = _current - _line_start;
+  _mark            = _current;
+
+  return _location;
 }
 
 auto Scanner::compound(char c, TokenKind m, TokenKind n) noexcept -> Token {
@@ -72,53 +186,43 @@ auto Scanner::compound(char c, TokenKind m, TokenKind n) noexcept -> Token {
 }
 
 auto Scanner::scan_comment() noexcept -> Token {
-  auto c   = EOF;
-  auto oss = std::ostringstream{};
+  const auto rest = _source.substr(_current);
+  const auto end  = std::min(rest.find('\n'), rest.size());
 
-  while ((c = advance()) != EOF && c != '\n') {
-    oss << (char)c;
-  }
+  // The newline ends the comment but is not part of it
+  _current += std::min(end + 1, rest.size());
 
-  return make_token(TokenKind::COMMENT, oss.str());
+  return make_token(TokenKind::COMMENT, rest.substr(0, end));
 }
 
 auto Scanner::scan_char() noexcept -> Token {
-  auto character = (char)advance();
-  return make_token(TokenKind::LITERAL_CHAR, std::string{character});
+  const auto character = _source.substr(_current, 1);
+  advance();
+  return make_token(TokenKind::LITERAL_CHAR, character);
 }
 
 auto Scanner::scan_string() noexcept -> Token {
-  auto c   = EOF;
-  auto oss = std::ostringstream{};
+  const auto end = _source.find('\'', _current);
 
-  oss << '\'';
-
-  while ((c = advance()) != EOF && c != '\'') {
-    oss << (char)c;
-  }
+  // Unterminated strings run until the end of the source
+  _current = end == std::string_view::npos ? _source.size() : end + 1;
 
-  oss << '\'';
-
-  return make_token(TokenKind::LITERAL_STRING, oss.str());
+  return make_token(TokenKind::LITERAL_STRING, lexeme());
 }
 
-auto Scanner::scan_number(int first) noexcept -> Token {
-  auto negative = first == '-';
-  auto dotted   = first == '.';
-
-  auto oss = std::ostringstream{};
-
-  oss << (char)first;
+auto Scanner::scan_number() noexcept -> Token {
+  auto negative = _source[_start] == '-';
+  auto dotted   = _source[_start] == '.';
 
   while (peek() != EOF && std::isdigit(peek())) {
-    oss << (char)advance();
+    advance();
   }
 
   if (!dotted && peek() == '.') {
     dotted = true;
 
     do {
-      oss << (char)advance();
+      advance();
     } while (peek() != EOF && std::isdigit(peek()));
   }
 
@@ -126,38 +230,31 @@ auto Scanner::scan_number(int first) noexcept -> Token {
               : negative ? TokenKind::LITERAL_INT
                          : TokenKind::LITERAL_NAT;
 
-  return make_token(kind, oss.str());
+  return make_token(kind, lexeme());
 }
 
-auto Scanner::scan_identifier(int first) -> std::string {
-  auto oss = std::ostringstream{};
-  oss << (char)first;
-
-  while (peek() != EOF && std::isalnum(peek())) {
-    oss << (char)advance();
-  }
-
-  return oss.str();
+auto Scanner::scan_identifier() noexcept -> std::string_view {
+  skip(classifier().alphanumeric);
+  return lexeme();
 }
 
-auto Scanner::make_token(TokenKind kind) const noexcept -> Token {
-  return make_token(kind, std::string{});
+auto Scanner::make_token(TokenKind kind) noexcept -> Token {
+  return make_token(kind, std::string_view{});
 }
 
-auto Scanner::make_token(TokenKind kind, std::string lexeme) const noexcept
+auto Scanner::make_token(TokenKind kind, std::string_view lexeme) noexcept
   -> Token {
   return Token{
     .kind     = kind,
     .lexeme   = lexeme,
-    .location = _location,
+    .location = locate(),
   };
 }
 
 auto Scanner::scan() noexcept -> Token {
-  while (iswspace(peek())) {
-    advance();
-  }
+  skip(classifier().whitespace);
 
+  _start = _current;
   auto c = advance();
 
   switch (c) {
@@ -204,7 +301,7 @@ auto Scanner::scan() noexcept -> Token {
     }
 
     case '-': {
-      if (std::isdigit(peek())) return scan_number('-');
+      if (std::isdigit(peek())) return scan_number();
 
       switch (peek()) {
         case '-':
@@ -346,7 +443,7 @@ auto Scanner::scan() noexcept -> Token {
     }
 
     case '.': {
-      if (std::isdigit(peek())) return scan_number(c);
+      if (std::isdigit(peek())) return scan_number();
 
       switch (peek()) {
         case '.':
@@ -376,12 +473,12 @@ auto Scanner::scan() noexcept -> Token {
     }
 
     default: {
-      if (std::isdigit(c)) return scan_number(c);
+      if (std::isdigit(c)) return scan_number();
 
-      auto id = scan_identifier(c);
+      auto id = scan_identifier();
 
-      if (keywords.find(id) != keywords.end()) {
-        return make_token(keywords.at(id));
+      if (auto keyword = find_keyword(id); keyword) {
+        return make_token(keyword.value());
       } else {
         return make_token(TokenKind::IDENTIFIER, id);
       }
@@ -4,7 +4,11 @@
 #include <iterator>
 #include <silk/tools/debugger.h>
 #include <silk/tools/repl.h>
+#include <silk/tools/server.h>
+#include <silk/utility/cache.h>
 #include <silk/utility/cli.h>
+#include <silk/utility/profiler.h>
+#include <silk/utility/thread_pool.h>
 
 #include <silk/pipeline/context_builder.h>
 #include <silk/pipeline/json_serializer.h>
@@ -14,23 +18,39 @@
 #include <silk/targets/moth/compiler.h>
 #include <utility>
 
-int main(const int argc, const char **argv) {
-  const auto flags = silk::CLIFlags{argc, argv};
+#include <moth/file.h>
+#include <moth/mem.h>
 
-  if (flags.is_set(silk::CLIFlags::HELP)) {
-    std::cout << silk::CLIFlags::help_string();
-    return 0;
-  }
+template <class Stage>
+auto print_errors(const Stage &stage, std::ostream &out) -> bool {
+  if (!stage.has_errors()) return false;
 
-  if (flags.is_set(silk::CLIFlags::INTERACTIVE)) {
-    auto repl = silk::Repl{};
-    return repl.run(std::cin, std::cout);
+  out << "pipeline errors." << std::endl;
+
+  for (auto &&err : stage.errors()) {
+    err.print(out);
   }
 
+  return true;
+}
+
+/// State kept between the builds of a process, a server
+/// keeps its threads and cached artifacts for every build
+struct Session {
+  std::shared_ptr<silk::ThreadPool> pool;
+  std::optional<silk::CompileCache> cache;
+};
+
+static auto build_package(
+  const silk::CLIFlags                  &flags,
+  Session                               &session,
+  const std::shared_ptr<silk::Profiler> &profiler,
+  std::ostream                          &out,
+  std::ostream                          &err) -> int {
   auto file_paths = flags.files();
 
   if (!file_paths.size()) {
-    silk::print_error(std::cout, "no files");
+    silk::print_error(out, "no files");
     return 1;
   }
 
@@ -42,24 +62,193 @@ int main(const int argc, const char **argv) {
   auto include_paths = std::vector<std::filesystem::path>{};
   std::move(begin(file_paths), end(file_paths), back_inserter(include_paths));
 
-  // Create a compilation pipeline
-  auto pipeline = silk::ContextBuilder{std::move(include_paths)} >>
-                  silk::Parser{} >> silk::TypeChecker{} >> silk::Optimizer{} >>
-                  silk::JsonSerializer{} // >> silk::moth::Compiler{}
-  ;
+  // Shared by the stages, each works on the modules in parallel
+  auto &pool = session.pool;
+
+  if (!pool || pool->jobs() != flags.jobs()) {
+    pool = std::make_shared<silk::ThreadPool>(flags.jobs());
+  }
 
-  std::cout << pipeline.execute({
+  // Gather the sources of the package first, they
+  // make up the key of the compiled package in the cache
+  auto context = silk::ContextBuilder{std::move(include_paths), pool};
+  context.profile(profiler);
+
+  auto sources = context.run({
     .path   = main_path,
     .source = std::ifstream{main_path},
   });
 
-  if (pipeline.has_errors()) {
-    std::cerr << "pipeline errors." << std::endl;
+  if (print_errors(context, err)) return 1;
+
+  // Executables are written next to the main source file
+  const auto compile = flags.is_set(silk::CLIFlags::COMPILE);
+  const auto output  = std::filesystem::path{main_path}.replace_extension(
+    ".silkexe");
+
+  auto *cache = (silk::CompileCache *)nullptr;
+  auto  key   = std::uint64_t{0};
 
-    for (auto &&err : pipeline.errors()) {
-      err.print(std::cerr);
+  if (!flags.is_set(silk::CLIFlags::NO_CACHE)) {
+    if (auto dir = silk::CompileCache::default_directory(); dir) {
+      if (!session.cache) session.cache.emplace(std::move(dir.value()));
+
+      cache = &session.cache.value();
+      key   = silk::CompileCache::key(sources, flags.mask());
     }
   }
 
+  if (auto artifact = cache ? cache->load(key) : std::nullopt; artifact) {
+    if (!compile) {
+      out << artifact.value();
+      return 0;
+    }
+
+    auto file = std::ofstream{output, std::ios::binary};
+    file << artifact.value();
+    return file ? 0 : 1;
+  }
+
+  if (compile) {
+    const auto wordcode = flags.is_set(silk::CLIFlags::WORDCODE);
+
+    auto pipeline = silk::Parser{pool} >> silk::TypeChecker{pool} >>
+                    silk::Optimizer{pool} >> silk::moth::Compiler{wordcode};
+
+    pipeline.profile(profiler);
+
+    auto program = pipeline.run(std::move(sources));
+    auto failure = (const char *)nullptr;
+    auto image   = std::string{};
+
+    // Serialized once, the same image is written and cached
+    if (!print_errors(pipeline, err)) {
+      auto len = std::size_t{0};
+
+      if (auto *bytes = write_memory(&program, &len, &failure); bytes) {
+        image.assign((const char *)bytes, len);
+        release(bytes, len);
+      }
+    }
+
+    free_program(&program);
+
+    if (pipeline.has_errors()) return 1;
+
+    if (failure) {
+      silk::print_error(err, "{}", failure);
+      return 1;
+    }
+
+    auto file = std::ofstream{output, std::ios::binary};
+    file.write(image.data(), image.size());
+
+    if (!file.flush()) {
+      silk::print_error(err, "could not write {}", output.string());
+      return 1;
+    }
+
+    // The executable itself is the cached artifact
+    if (cache) cache->store(key, image);
+
+    return 0;
+  }
+
+  // Unchanged modules of a changed package are reused one by one
+  auto modules = std::shared_ptr<silk::ModuleCache>{};
+
+  if (cache) {
+    modules = std::make_shared<silk::ModuleCache>(*cache, flags.mask());
+  }
+
+  // Create a compilation pipeline
+  auto pipeline = silk::Parser{pool, modules} >> silk::TypeChecker{pool} >>
+                  silk::Optimizer{pool} >>
+                  silk::JsonSerializer{modules} // >> silk::moth::Compiler{}
+  ;
+
+  pipeline.profile(profiler);
+
+  auto artifact = pipeline.run(std::move(sources));
+  out << artifact;
+
+  if (print_errors(pipeline, err)) return 0;
+
+  // Only packages that compiled cleanly are reused
+  if (cache) {
+    cache->store(key, artifact);
+    modules->commit();
+  }
+
   return 0;
 }
+
+static auto build(
+  const silk::CLIFlags &flags,
+  Session              &session,
+  std::ostream         &out,
+  std::ostream         &err) -> int {
+  const auto table = flags.is_set(silk::CLIFlags::TIME_STAGES);
+  const auto json  = flags.is_set(silk::CLIFlags::TIME_JSON);
+
+  if (!table && !json) return build_package(flags, session, nullptr, out, err);
+
+  // Printed with the errors, the output stays what it would be otherwise
+  auto profiler = std::make_shared<silk::Profiler>();
+  auto code     = build_package(flags, session, profiler, out, err);
+
+  if (json) {
+    profiler->print_json(err);
+  } else {
+    profiler->print_table(err);
+  }
+
+  return code;
+}
+
+int main(const int argc, const char **argv) {
+  const auto flags = silk::CLIFlags{argc, argv};
+
+  if (flags.is_set(silk::CLIFlags::HELP)) {
+    std::cout << silk::CLIFlags::help_string();
+    return 0;
+  }
+
+  if (flags.is_set(silk::CLIFlags::INTERACTIVE)) {
+    auto repl = silk::Repl{};
+    return repl.run(std::cin, std::cout);
+  }
+
+  const auto socket  = silk::Server::default_path();
+  auto       session = Session{};
+
+  if (flags.is_set(silk::CLIFlags::SERVER)) {
+    if (!socket) {
+      silk::print_error(std::cerr, "no path for the server socket");
+      return 1;
+    }
+
+    // Artifacts of every build served stay in memory
+    if (!flags.is_set(silk::CLIFlags::NO_CACHE)) {
+      if (auto dir = silk::CompileCache::default_directory(); dir) {
+        session.cache.emplace(std::move(dir.value()));
+        session.cache->keep_resident();
+      }
+    }
+
+    auto server = silk::Server{socket.value()};
+    return server.run([&](auto &request, auto &out, auto &err) {
+      return build(request, session, out, err);
+    });
+  }
+
+  // A running server builds faster, having kept everything warm
+  if (socket) {
+    const auto code = silk::Server::forward(
+      socket.value(), argc, argv, std::cout, std::cerr);
+
+    if (code) return code.value();
+  }
+
+  return build(flags, session, std::cout, std::cerr);
+}
@@ -1,75 +1,141 @@
-#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <optional>
-#include <regex>
-#include <sstream>
+#include <system_error>
 
 #include <silk/pipeline/context_builder.h>
 #include <silk/utility/cli.h>
 
 namespace silk {
 
-const auto ContextBuilder::import_regex = std::regex{
-  R"regex((?:^|\n)[^\S\r\n]*use[^\S\r\n]*'([^\n]*)')regex",
-  std::regex_constants::optimize,
-};
+static auto is_blank(char c) -> bool {
+  return c == ' ' || c == '\t' || c == '\v' || c == '\f';
+}
 
-auto ContextBuilder::resolve_path(std::string import_string)
-  -> std::optional<fs::path> {
-  const auto suffix = import_string + ".silk";
+auto ContextBuilder::find_imports(std::string_view content)
+  -> std::vector<std::string> {
+  auto imports = std::vector<std::string>{};
+
+  // Only lines starting with `use '...'` are imports, so the source
+  // is searched for the keyword instead of being tokenized
+  for (auto pos = content.find("use"); pos != content.npos;
+       pos      = content.find("use", pos + 1)) {
+    auto start = pos;
+    while (start > 0 && is_blank(content[start - 1])) start--;
+    if (start > 0 && content[start - 1] != '\n') continue;
+
+    auto quote = pos + 3;
+    while (quote < content.size() && is_blank(content[quote])) quote++;
+    if (quote == content.size() || content[quote] != '\'') continue;
+
+    // The import ends at the last quote of the line
+    const auto line  = content.substr(quote + 1);
+    const auto rest  = line.substr(0, line.find('\n'));
+    const auto close = rest.rfind('\'');
+    if (close == rest.npos) continue;
+
+    imports.emplace_back(rest.substr(0, close));
+  }
 
-  if (fs::is_regular_file(fs::current_path() / suffix)) {
-    return fs::current_path() / suffix;
+  return imports;
+}
+
+auto ContextBuilder::resolve_path(const std::string &import_string)
+  -> std::optional<fs::path> {
+  // Imports resolve the same from every file, each is looked up once
+  if (auto it = _resolved.find(import_string); it != _resolved.end()) {
+    return it->second;
   }
 
-  for (auto &include_path : include_paths) {
-    const auto path = include_path / suffix;
-    if (fs::is_regular_file(path)) return path;
+  const auto suffix   = import_string + ".silk";
+  auto       resolved = std::optional<fs::path>{};
+
+  for (auto &search_path : _search_paths) {
+    auto ec   = std::error_code{};
+    auto path = search_path / suffix;
+
+    if (fs::is_regular_file(path, ec)) {
+      resolved = std::move(path);
+      break;
+    }
   }
 
-  report(fmt_function(
-    "unable to resolve import '{}', not found in any include path",
-    import_string));
+  if (!resolved) {
+    report(fmt_function(
+      "unable to resolve import '{}', not found in any include path",
+      import_string));
+  }
 
-  return std::nullopt;
+  _resolved.emplace(import_string, resolved);
+  return resolved;
 }
 
-auto ContextBuilder::resolve_imports(
-  std::unordered_map<std::string, Source> &imports, Source &file) -> void {
-  auto content = [&] {
-    auto buf = std::ostringstream{};
-    buf << file.source.rdbuf();
-    return buf.str();
-  }();
-
-  auto beg = std::sregex_iterator{content.begin(), content.end(), import_regex};
-  auto end = std::sregex_iterator{};
+auto ContextBuilder::execute(Source &&main_source) noexcept -> PackageSource {
+  auto ec = std::error_code{};
 
-  std::for_each(beg, end, [&](std::smatch match) {
-    if (const auto resolved = resolve_path(match[1]); resolved) {
-      const auto path = resolved.value();
+  // Paths that are not directories cannot resolve any import,
+  // they are dropped before the first import is looked up
+  _resolved.clear();
+  _search_paths.clear();
 
-      // Import already resolved
-      if (imports.find(path) != imports.end()) return;
+  if (auto cwd = fs::current_path(ec); !ec) {
+    _search_paths.push_back(std::move(cwd));
+  }
 
-      // Recursively resolve imports of new import
-      imports.emplace(path, Source{path, std::ifstream(path)});
-      resolve_imports(imports, imports.at(path));
+  for (auto &include_path : include_paths) {
+    if (fs::is_directory(include_path, ec)) {
+      _search_paths.push_back(include_path);
     }
-  });
-
-  // Reset file to start
-  file.source.seekg(0);
-}
+  }
 
-auto ContextBuilder::execute(Source &&main_source) noexcept -> PackageSource {
   auto imported_sources = std::unordered_map<std::string, Source>{};
-  resolve_imports(imported_sources, main_source);
+  auto graph            = ModuleGraph{};
+  auto frontier         = std::vector<Source *>{&main_source};
+
+  // Breadth first, the files found on one level are read and
+  // searched for imports in parallel. The buffers are kept in
+  // the sources so the parser does not read them again.
+  while (!frontier.empty()) {
+    auto found = std::vector<std::vector<std::string>>(frontier.size());
+
+    parallel(frontier.size(), [&](std::size_t i) {
+      auto &source = *frontier[i];
+      auto  span   = measure(source.path);
+      if (!source.source.is_open()) source.source.open(source.path);
+
+      const auto content = read_source(source);
+      found[i]           = find_imports(*content);
+      span.count("bytes", content->size());
+    });
+
+    // Resolved in the order of the files, so errors are too
+    auto next = std::vector<Source *>{};
+
+    for (auto i = std::size_t{0}; i < frontier.size(); i++) {
+      for (auto &import_string : found[i]) {
+        const auto resolved = resolve_path(import_string);
+        if (!resolved) continue;
+
+        auto path = resolved->string();
+        graph.add(frontier[i]->path, path);
+
+        // Import already resolved
+        if (imported_sources.count(path)) continue;
+
+        // Opened along with the other files of the next level
+        auto source = Source{path, std::ifstream{}};
+        auto [it, _] = imported_sources.emplace(path, std::move(source));
+        next.push_back(&it->second);
+      }
+    }
+
+    frontier = std::move(next);
+  }
 
   return {
     .main    = std::move(main_source),
     .sources = std::move(imported_sources),
+    .graph   = std::move(graph),
   };
 }
 
@@ -66,7 +66,15 @@ void JsonSerializer::serialize(std::nullptr_t) {
   _output << "null";
 }
 
-void JsonSerializer::serialize(std::unique_ptr<st::Node> &node) {
+void JsonSerializer::serialize(st::Typing &typing) {
+  if (typing) {
+    serialize(typing.name);
+  } else {
+    serialize(nullptr);
+  }
+}
+
+void JsonSerializer::serialize(st::NodePtr &node) {
   if (node) {
     handle_node(*node);
   } else {
@@ -545,23 +553,56 @@ void JsonSerializer::handle(st::Node &, st::ExpressionLambda &data) {
   obj_end();
 }
 
+auto JsonSerializer::fragment(Module &mod) -> std::string {
+  auto output = std::stringstream{};
+  output << std::fixed;
+
+  std::swap(output, _output);
+  serialize(mod);
+  std::swap(output, _output);
+
+  return output.str();
+}
+
 auto JsonSerializer::execute(Package &&pkg) noexcept -> std::string {
   _output.clear();
   _output << std::fixed;
 
-  auto modules = std::vector<std::reference_wrapper<Module>>{};
-  modules.reserve(pkg.modules.size());
+  auto modules = ordered_modules(pkg);
+  auto outputs = std::vector<std::string>{};
+  outputs.reserve(modules.size());
+
+  // Modules reused from an earlier build are copied as they are,
+  // the others are kept for the next build to reuse
+  for (auto *mod : modules) {
+    auto span = measure(mod->path);
+
+    if (mod->artifact) {
+      outputs.push_back(*mod->artifact);
+      span.count("reused", 1);
+      continue;
+    }
+
+    const auto visited = visits();
+    outputs.push_back(fragment(*mod));
 
-  std::transform(
-    std::begin(pkg.modules),
-    std::end(pkg.modules),
-    std::back_inserter(modules),
-    [](auto &entry) -> Module & { return entry.second; });
+    span.count("nodes", visits() - visited);
+    span.count("bytes", outputs.back().size());
+    if (_modules) _modules->stage(*mod, outputs.back());
+  }
 
   obj_beg();
   keyval("type", "package");
-  keyval("main", pkg.main);
-  keyval("modules", modules);
+  _output << std::quoted("main") << ':' << outputs[0] << ',';
+  _output << std::quoted("modules") << ':';
+  arr_beg();
+
+  for (auto i = std::size_t{1}; i < outputs.size(); i++) {
+    _output << outputs[i] << ',';
+  }
+
+  arr_end();
+  _output << ',';
   obj_end();
 
   return _output.str();
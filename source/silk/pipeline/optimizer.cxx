@@ -1,6 +1,8 @@
 #include <silk/pipeline/optimizer.h>
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <optional>
 #include <variant>
 
@@ -8,7 +10,7 @@
 
 namespace silk {
 
-auto Optimizer::is_const_expr(std::unique_ptr<st::Node> &node) const -> bool {
+auto Optimizer::is_const_expr(st::NodePtr &node) const -> bool {
   return st::node_contains<
     st::ExpressionBool,
     st::ExpressionNat,
@@ -55,6 +57,98 @@ auto Optimizer::real_value(st::Node &node) const -> std::optional<double> {
   return std::nullopt;
 }
 
+auto Optimizer::fold_intrinsic(
+  st::Node &node, Intrinsic intrinsic, std::vector<st::Node> &args) -> void {
+  auto ints  = std::vector<std::int64_t>{};
+  auto reals = std::vector<double>{};
+
+  // Only calls with literal arguments can be folded
+  for (auto &arg : args) {
+    if (auto v = nat_value(arg); v) {
+      ints.push_back(v.value());
+      reals.push_back(v.value());
+    } else if (auto v = int_value(arg); v) {
+      ints.push_back(v.value());
+      reals.push_back(v.value());
+    } else if (auto v = real_value(arg); v) {
+      reals.push_back(v.value());
+    } else {
+      return;
+    }
+  }
+
+  // Integer arguments give integer results where the VM does
+  const auto integral = ints.size() == args.size();
+
+  switch (intrinsic) {
+    case Intrinsic::SQRT:
+      node.data = st::ExpressionReal{std::sqrt(reals[0])};
+      return;
+
+    case Intrinsic::SIN:
+      node.data = st::ExpressionReal{std::sin(reals[0])};
+      return;
+
+    case Intrinsic::COS:
+      node.data = st::ExpressionReal{std::cos(reals[0])};
+      return;
+
+    case Intrinsic::EXP:
+      node.data = st::ExpressionReal{std::exp(reals[0])};
+      return;
+
+    case Intrinsic::LOG:
+      node.data = st::ExpressionReal{std::log(reals[0])};
+      return;
+
+    case Intrinsic::FLOOR: {
+      if (integral) {
+        node.data = st::ExpressionInt{ints[0]};
+        return;
+      }
+
+      // Left to fail at runtime, like the VM does, when there
+      // is no integer to floor to
+      const auto floored = std::floor(reals[0]);
+      if (!(floored >= -0x1p63 && floored < 0x1p63)) return;
+
+      node.data = st::ExpressionInt{static_cast<std::int64_t>(floored)};
+      return;
+    }
+
+    case Intrinsic::ABS: {
+      if (integral) {
+        // Left to fail at runtime, the smallest integer
+        // has no positive counterpart
+        if (ints[0] == std::numeric_limits<std::int64_t>::min()) return;
+
+        node.data = st::ExpressionInt{ints[0] < 0 ? -ints[0] : ints[0]};
+      } else {
+        node.data = st::ExpressionReal{std::fabs(reals[0])};
+      }
+      return;
+    }
+
+    case Intrinsic::MIN: {
+      if (integral) {
+        node.data = st::ExpressionInt{std::min(ints[0], ints[1])};
+      } else {
+        node.data = st::ExpressionReal{std::fmin(reals[0], reals[1])};
+      }
+      return;
+    }
+
+    case Intrinsic::MAX: {
+      if (integral) {
+        node.data = st::ExpressionInt{std::max(ints[0], ints[1])};
+      } else {
+        node.data = st::ExpressionReal{std::fmax(reals[0], reals[1])};
+      }
+      return;
+    }
+  }
+}
+
 auto Optimizer::handle(st::Node &, st::Comment &) -> void {
   // TODO
 }
@@ -72,6 +166,7 @@ auto Optimizer::handle(st::Node &, st::ModuleImport &) -> void {
 }
 
 auto Optimizer::handle(st::Node &, st::DeclarationFunction &data) -> void {
+  _intrinsics.bind(data.name);
   handle_node(data.child);
 }
 
@@ -104,7 +199,9 @@ auto Optimizer::handle(st::Node &, st::StatementExpression &data) -> void {
 }
 
 auto Optimizer::handle(st::Node &, st::StatementBlock &data) -> void {
+  _intrinsics.enter();
   handle_nodes(data.children);
+  _intrinsics.leave();
 }
 
 auto Optimizer::handle(st::Node &, st::StatementCircuit &data) -> void {
@@ -117,10 +214,12 @@ auto Optimizer::handle(st::Node &, st::StatementCircuit &data) -> void {
 
 auto Optimizer::handle(st::Node &, st::StatementVariable &data) -> void {
   handle_node(data.child);
+  _intrinsics.bind(data.name);
 }
 
 auto Optimizer::handle(st::Node &node, st::StatementConstant &data) -> void {
   handle_node(data.child);
+  _intrinsics.bind(data.name);
 
   if (!is_const_expr(data.child)) {
     report("expression is not constant", node.location);
@@ -156,15 +255,21 @@ auto Optimizer::handle(st::Node &, st::StatementLoop &data) -> void {
 }
 
 auto Optimizer::handle(st::Node &, st::StatementFor &data) -> void {
+  _intrinsics.enter();
   handle_node(data.initial);
   handle_node(data.condition);
   handle_node(data.increment);
   handle_node(data.child);
+  _intrinsics.leave();
 }
 
 auto Optimizer::handle(st::Node &, st::StatementForeach &data) -> void {
   handle_node(data.collection);
+
+  _intrinsics.enter();
+  _intrinsics.bind(data.iterator);
   handle_node(data.child);
+  _intrinsics.leave();
 }
 
 auto Optimizer::handle(st::Node &, st::StatementMatch &) -> void {
@@ -311,30 +416,44 @@ auto Optimizer::handle(st::Node &, st::ExpressionAssignment &data) -> void {
   handle_node(data.child);
 }
 
-auto Optimizer::handle(st::Node &, st::ExpressionCall &data) -> void {
+auto Optimizer::handle(st::Node &node, st::ExpressionCall &data) -> void {
   handle_node(data.callee);
 
   for (auto &arg : data.children) {
     handle_node(arg);
   }
+
+  if (auto intrinsic = _intrinsics.lookup(data); intrinsic) {
+    fold_intrinsic(node, intrinsic.value(), data.children);
+  }
 }
 
 auto Optimizer::handle(st::Node &, st::ExpressionLambda &data) -> void {
+  _intrinsics.enter();
+  _intrinsics.bind(data.parameters);
   handle_node(data.child);
+  _intrinsics.leave();
 }
 
 auto Optimizer::optimize(Module &mod) noexcept -> void {
+  // Find the intrinsics visible in the module before folding
+  // any calls, functions can be declared after their use
+  _intrinsics.scan(mod.tree);
+
   for (auto &node : mod.tree) {
     handle_node(node);
   }
 }
 
 auto Optimizer::execute(Package &&pkg) noexcept -> Package {
-  optimize(pkg.main);
-
-  for (auto &[_, mod] : pkg.modules) {
-    optimize(mod);
-  }
+  const auto modules = ordered_modules(pkg);
+
+  // Intrinsics are found per module, so every module gets an optimizer
+  for_each_parallel(modules.size(), [&](Optimizer &optimizer, std::size_t i) {
+    auto span = measure(modules[i]->path);
+    optimizer.optimize(*modules[i]);
+    span.count("nodes", optimizer.visits());
+  });
 
   return std::move(pkg);
 }
@@ -15,327 +15,337 @@
 
 namespace silk {
 
-const std::unordered_map<TokenKind, Parser::Rule> Parser::rules = {
-  // GROUPINGS --------------------------------
+// Built at compile time, so looking up a rule is a single index
+constexpr Parser::Rules Parser::rules = [] {
+  const std::pair<TokenKind, Rule> entries[] = {
+    // GROUPINGS --------------------------------
 
-  {
-    TokenKind::SYM_SQ_OPEN,
     {
-      .prefix = &Parser::expression_array,
+      TokenKind::SYM_SQ_OPEN,
+      {
+        .prefix = &Parser::expression_array,
+      },
     },
-  },
 
-  {
-    TokenKind::SYM_RD_OPEN,
     {
-      .prefix     = &Parser::expression_tuple,
-      .infix      = &Parser::expression_call,
-      .precedence = Precedence::CALL,
+      TokenKind::SYM_RD_OPEN,
+      {
+        .prefix     = &Parser::expression_tuple,
+        .infix      = &Parser::expression_call,
+        .precedence = Precedence::CALL,
+      },
     },
-  },
 
-  {
-    TokenKind::SYM_HASH_BRACE,
     {
-      .prefix = &Parser::expression_dictionary,
+      TokenKind::SYM_HASH_BRACE,
+      {
+        .prefix = &Parser::expression_dictionary,
+      },
     },
-  },
 
-  // UNARY OPS ---------------------------------
+    // UNARY OPS ---------------------------------
 
-  {
-    TokenKind::KW_NOT,
     {
-      .prefix = &Parser::expression_unary,
+      TokenKind::KW_NOT,
+      {
+        .prefix = &Parser::expression_unary,
+      },
     },
-  },
 
-  // BINARY OPS ---------------------------------
+    // BINARY OPS ---------------------------------
 
-  {
-    TokenKind::SYM_EQUAL_EQUAL,
     {
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::EQUALITY,
+      TokenKind::SYM_EQUAL_EQUAL,
+      {
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::EQUALITY,
+      },
     },
-  },
-  {
-    TokenKind::SYM_BANG_EQUAL,
     {
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::EQUALITY,
+      TokenKind::SYM_BANG_EQUAL,
+      {
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::EQUALITY,
+      },
     },
-  },
-  {
-    TokenKind::SYM_GT,
     {
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::COMPARISON,
+      TokenKind::SYM_GT,
+      {
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::COMPARISON,
+      },
     },
-  },
-  {
-    TokenKind::SYM_GT_EQUAL,
     {
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::COMPARISON,
+      TokenKind::SYM_GT_EQUAL,
+      {
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::COMPARISON,
+      },
     },
-  },
-  {
-    TokenKind::SYM_LT,
     {
-      .prefix     = &Parser::expression_vector,
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::COMPARISON,
+      TokenKind::SYM_LT,
+      {
+        .prefix     = &Parser::expression_vector,
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::COMPARISON,
+      },
     },
-  },
-  {
-    TokenKind::SYM_LT_EQUAL,
     {
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::COMPARISON,
+      TokenKind::SYM_LT_EQUAL,
+      {
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::COMPARISON,
+      },
     },
-  },
-  {
-    TokenKind::KW_AND,
     {
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::AND,
+      TokenKind::KW_AND,
+      {
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::AND,
+      },
     },
-  },
-  {
-    TokenKind::KW_OR,
     {
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::OR,
+      TokenKind::KW_OR,
+      {
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::OR,
+      },
     },
-  },
-  {
-    TokenKind::SYM_MINUS,
     {
-      .prefix     = &Parser::expression_unary,
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::TERM,
+      TokenKind::SYM_MINUS,
+      {
+        .prefix     = &Parser::expression_unary,
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::TERM,
+      },
     },
-  },
-  {
-    TokenKind::SYM_PLUS,
     {
-      .prefix     = &Parser::expression_unary,
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::TERM,
+      TokenKind::SYM_PLUS,
+      {
+        .prefix     = &Parser::expression_unary,
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::TERM,
+      },
     },
-  },
-  {
-    TokenKind::SYM_STAR,
     {
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::FACTOR,
+      TokenKind::SYM_STAR,
+      {
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::FACTOR,
+      },
     },
-  },
-  {
-    TokenKind::SYM_STAR_STAR,
     {
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::POWER,
+      TokenKind::SYM_STAR_STAR,
+      {
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::POWER,
+      },
     },
-  },
-  {
-    TokenKind::SYM_SLASH,
     {
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::FACTOR,
+      TokenKind::SYM_SLASH,
+      {
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::FACTOR,
+      },
     },
-  },
 
-  {
-    TokenKind::SYM_SLASH_SLASH,
     {
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::FACTOR,
+      TokenKind::SYM_SLASH_SLASH,
+      {
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::FACTOR,
+      },
     },
-  },
-  {
-    TokenKind::SYM_PERC,
     {
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::FACTOR,
+      TokenKind::SYM_PERC,
+      {
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::FACTOR,
+      },
     },
-  },
 
-  {
-    TokenKind::SYM_EQUAL,
     {
-      .infix      = &Parser::expression_assignment,
-      .precedence = Precedence::ASSIGNMENT,
+      TokenKind::SYM_EQUAL,
+      {
+        .infix      = &Parser::expression_assignment,
+        .precedence = Precedence::ASSIGNMENT,
+      },
     },
-  },
-  {
-    TokenKind::SYM_PLUS_EQUAL,
     {
-      .infix      = &Parser::expression_assignment,
-      .precedence = Precedence::ASSIGNMENT,
+      TokenKind::SYM_PLUS_EQUAL,
+      {
+        .infix      = &Parser::expression_assignment,
+        .precedence = Precedence::ASSIGNMENT,
+      },
     },
-  },
-  {
-    TokenKind::SYM_MINUS_EQUAL,
     {
-      .infix      = &Parser::expression_assignment,
-      .precedence = Precedence::ASSIGNMENT,
+      TokenKind::SYM_MINUS_EQUAL,
+      {
+        .infix      = &Parser::expression_assignment,
+        .precedence = Precedence::ASSIGNMENT,
+      },
     },
-  },
-  {
-    TokenKind::SYM_STAR_EQUAL,
     {
-      .infix      = &Parser::expression_assignment,
-      .precedence = Precedence::ASSIGNMENT,
+      TokenKind::SYM_STAR_EQUAL,
+      {
+        .infix      = &Parser::expression_assignment,
+        .precedence = Precedence::ASSIGNMENT,
+      },
     },
-  },
-  {
-    TokenKind::SYM_STAR_STAR_EQUAL,
     {
-      .infix      = &Parser::expression_assignment,
-      .precedence = Precedence::ASSIGNMENT,
+      TokenKind::SYM_STAR_STAR_EQUAL,
+      {
+        .infix      = &Parser::expression_assignment,
+        .precedence = Precedence::ASSIGNMENT,
+      },
     },
-  },
-  {
-    TokenKind::SYM_SLASH_EQUAL,
     {
-      .infix      = &Parser::expression_assignment,
-      .precedence = Precedence::ASSIGNMENT,
+      TokenKind::SYM_SLASH_EQUAL,
+      {
+        .infix      = &Parser::expression_assignment,
+        .precedence = Precedence::ASSIGNMENT,
+      },
     },
-  },
-  {
-    TokenKind::SYM_SLASH_SLASH_EQUAL,
     {
-      .infix      = &Parser::expression_assignment,
-      .precedence = Precedence::ASSIGNMENT,
+      TokenKind::SYM_SLASH_SLASH_EQUAL,
+      {
+        .infix      = &Parser::expression_assignment,
+        .precedence = Precedence::ASSIGNMENT,
+      },
     },
-  },
 
-  {
-    TokenKind::SYM_DOT,
     {
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::CALL,
+      TokenKind::SYM_DOT,
+      {
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::CALL,
+      },
     },
-  },
 
-  {
-    TokenKind::SYM_PIPE,
     {
-      .infix      = &Parser::expression_binary,
-      .precedence = Precedence::POWER,
+      TokenKind::SYM_PIPE,
+      {
+        .infix      = &Parser::expression_binary,
+        .precedence = Precedence::POWER,
+      },
     },
-  },
 
-  {
-    TokenKind::SYM_DOT_DOT,
     {
-      .infix      = &Parser::expression_range,
-      .precedence = Precedence::ASSIGNMENT,
+      TokenKind::SYM_DOT_DOT,
+      {
+        .infix      = &Parser::expression_range,
+        .precedence = Precedence::ASSIGNMENT,
+      },
     },
-  },
 
-  // LITERALS ------------------------------------
+    // LITERALS ------------------------------------
 
-  {
-    TokenKind::IDENTIFIER,
     {
-      .prefix = &Parser::expression_identifier,
+      TokenKind::IDENTIFIER,
+      {
+        .prefix = &Parser::expression_identifier,
+      },
     },
-  },
 
-  {
-    TokenKind::LITERAL_NAT,
     {
-      .prefix = &Parser::expression_literal,
+      TokenKind::LITERAL_NAT,
+      {
+        .prefix = &Parser::expression_literal,
+      },
     },
-  },
 
-  {
-    TokenKind::LITERAL_INT,
     {
-      .prefix = &Parser::expression_literal,
+      TokenKind::LITERAL_INT,
+      {
+        .prefix = &Parser::expression_literal,
+      },
     },
-  },
 
-  {
-    TokenKind::LITERAL_REAL,
     {
-      .prefix = &Parser::expression_literal,
+      TokenKind::LITERAL_REAL,
+      {
+        .prefix = &Parser::expression_literal,
+      },
     },
-  },
 
-  {
-    TokenKind::LITERAL_CHAR,
     {
-      .prefix = &Parser::expression_char,
+      TokenKind::LITERAL_CHAR,
+      {
+        .prefix = &Parser::expression_char,
+      },
     },
-  },
 
-  {
-    TokenKind::LITERAL_STRING,
     {
-      .prefix = &Parser::expression_string,
+      TokenKind::LITERAL_STRING,
+      {
+        .prefix = &Parser::expression_string,
+      },
     },
-  },
 
-  {
-    TokenKind::BOOL_TRUE,
     {
-      .prefix = &Parser::expression_literal,
+      TokenKind::BOOL_TRUE,
+      {
+        .prefix = &Parser::expression_literal,
+      },
     },
-  },
 
-  {
-    TokenKind::BOOL_FALSE,
     {
-      .prefix = &Parser::expression_literal,
+      TokenKind::BOOL_FALSE,
+      {
+        .prefix = &Parser::expression_literal,
+      },
     },
-  },
 
-  {
-    TokenKind::KEY_VOID,
     {
-      .prefix = &Parser::expression_void,
+      TokenKind::KEY_VOID,
+      {
+        .prefix = &Parser::expression_void,
+      },
     },
-  },
 
-  {
-    TokenKind::KW_RETURN,
     {
-      .prefix = &Parser::expression_continuation,
+      TokenKind::KW_RETURN,
+      {
+        .prefix = &Parser::expression_continuation,
+      },
     },
-  },
 
-  {
-    TokenKind::KEY_PI,
     {
-      .prefix = &Parser::expression_literal,
+      TokenKind::KEY_PI,
+      {
+        .prefix = &Parser::expression_literal,
+      },
     },
-  },
 
-  {
-    TokenKind::KEY_TAU,
     {
-      .prefix = &Parser::expression_literal,
+      TokenKind::KEY_TAU,
+      {
+        .prefix = &Parser::expression_literal,
+      },
     },
-  },
 
-  {
-    TokenKind::KEY_EUL,
     {
-      .prefix = &Parser::expression_literal,
+      TokenKind::KEY_EUL,
+      {
+        .prefix = &Parser::expression_literal,
+      },
     },
-  },
 
-  {
-    TokenKind::KW_FUN,
     {
-      .prefix = &Parser::expression_lambda,
+      TokenKind::KW_FUN,
+      {
+        .prefix = &Parser::expression_lambda,
+      },
     },
-  },
-};
+  };
+
+  auto table = Rules{};
+  for (auto &[kind, rule] : entries) {
+    table[static_cast<std::size_t>(kind)] = rule;
+  }
+
+  return table;
+}();
 
 inline auto Parser::eof() const -> bool {
   return peek().kind == TokenKind::TOK_END;
@@ -386,8 +396,9 @@ inline auto Parser::must_consume(TokenKind kind, std::string_view msg) -> void {
 
 auto Parser::get_rule(const Token &tok) const
   -> std::optional<std::reference_wrapper<const Rule>> {
-  if (rules.find(tok.kind) == rules.end()) return {};
-  return rules.at(tok.kind);
+  auto &rule = rules[static_cast<std::size_t>(tok.kind)];
+  if (!rule.prefix && !rule.infix && !rule.postfix) return {};
+  return rule;
 }
 
 auto Parser::higher(Precedence prec) const -> Precedence {
@@ -400,7 +411,7 @@ auto Parser::lower(Precedence prec) const -> Precedence {
   return static_cast<Precedence>(static_cast<int>(prec) - 1);
 }
 
-auto Parser::precendece(Precedence prec) -> std::unique_ptr<st::Node> {
+auto Parser::precendece(Precedence prec) -> st::NodePtr {
   auto rule = get_rule(peek());
 
   if (!rule) throw report("rule not found", peek().location);
@@ -419,31 +430,30 @@ auto Parser::precendece(Precedence prec) -> std::unique_ptr<st::Node> {
 
 auto Parser::parse_identifier() -> std::string {
   must_match(TokenKind::IDENTIFIER, "expected a name");
-  return advance().lexeme;
+  return std::string{advance().lexeme};
 }
 
 auto Parser::parse_package() -> std::string {
   must_match(TokenKind::LITERAL_STRING, "expected a package name");
-  auto &pkg_str = advance().lexeme;
+  auto pkg_str = advance().lexeme;
 
   if (pkg_str.size() <= 2) {
     throw report("invalid package string", previous().location);
   }
 
   // remove quotes from raw string
-  return pkg_str.substr(1, pkg_str.size() - 2);
+  return std::string{pkg_str.substr(1, pkg_str.size() - 2)};
 }
 
 auto Parser::parse_typing() -> st::Typing {
-  // TODO
+  // TODO: composite types
   if (!consume(TokenKind::SYM_COLON_COLON)) {
     // no typing
     return nullptr;
   }
 
   // typing!
-  parse_identifier();
-  return nullptr;
+  return parse_identifier();
 }
 
 auto Parser::parse_typed_fields(TokenKind end, TokenKind delim)
@@ -490,13 +500,13 @@ auto Parser::parse_nameless_function_header()
   return {std::move(params), std::move(return_type)};
 }
 
-auto Parser::parse_function_body() -> std::unique_ptr<st::Node> {
+auto Parser::parse_function_body() -> st::NodePtr {
   return consume(TokenKind::SYM_FATARROW)
            ? make_node<st::StatementReturn>(nullptr, expression())
            : statement_block();
 }
 
-auto Parser::declaration() -> std::unique_ptr<st::Node> {
+auto Parser::declaration() -> st::NodePtr {
   switch (peek().kind) {
     case TokenKind::KW_MAIN: return declaration_main();
     case TokenKind::KW_PKG: return declaration_package();
@@ -510,20 +520,20 @@ auto Parser::declaration() -> std::unique_ptr<st::Node> {
   }
 }
 
-auto Parser::declaration_main() -> std::unique_ptr<st::Node> {
+auto Parser::declaration_main() -> st::NodePtr {
   must_consume(TokenKind::KW_MAIN, "main package declaration");
   must_consume(TokenKind::SYM_SEMICOLON, "expected `;`");
   return make_node<st::ModuleMain>();
 }
 
-auto Parser::declaration_package() -> std::unique_ptr<st::Node> {
+auto Parser::declaration_package() -> st::NodePtr {
   must_consume(TokenKind::KW_PKG, "package declaration");
   auto package = parse_package();
   must_consume(TokenKind::SYM_SEMICOLON, "expected `;`");
   return make_node<st::ModuleDeclaration>(package);
 }
 
-auto Parser::declaration_import() -> std::unique_ptr<st::Node> {
+auto Parser::declaration_import() -> st::NodePtr {
   must_consume(TokenKind::KW_USE, "package import");
 
   auto package = parse_package();
@@ -539,7 +549,7 @@ auto Parser::declaration_import() -> std::unique_ptr<st::Node> {
   return make_node<st::ModuleImport>(package, std::move(imports));
 }
 
-auto Parser::declaration_function() -> std::unique_ptr<st::Node> {
+auto Parser::declaration_function() -> st::NodePtr {
   auto [name, params, return_type] = parse_named_function_header();
   auto body                        = parse_function_body();
 
@@ -549,7 +559,7 @@ auto Parser::declaration_function() -> std::unique_ptr<st::Node> {
   return make_node<st::DeclarationFunction>(std::move(name), std::move(lambda));
 }
 
-auto Parser::declaration_enum() -> std::unique_ptr<st::Node> {
+auto Parser::declaration_enum() -> st::NodePtr {
   must_consume(TokenKind::KW_ENUM, "enum declaration");
   auto name = parse_identifier();
 
@@ -560,7 +570,7 @@ auto Parser::declaration_enum() -> std::unique_ptr<st::Node> {
   return make_node<st::DeclarationEnum>(std::move(name), std::move(variants));
 }
 
-auto Parser::declaration_object() -> std::unique_ptr<st::Node> {
+auto Parser::declaration_object() -> st::NodePtr {
   must_consume(TokenKind::KW_OBJ, "object declaration");
   auto name  = parse_identifier();
   auto super = parse_typing();
@@ -576,7 +586,7 @@ auto Parser::declaration_object() -> std::unique_ptr<st::Node> {
   );
 }
 
-auto Parser::declaration_library() -> std::unique_ptr<st::Node> {
+auto Parser::declaration_library() -> st::NodePtr {
   must_consume(TokenKind::KW_DLL, "external library declaration");
 
   auto library   = parse_package();
@@ -598,7 +608,7 @@ auto Parser::declaration_library() -> std::unique_ptr<st::Node> {
     std::move(library), std::move(functions));
 }
 
-auto Parser::declaration_macro() -> std::unique_ptr<st::Node> {
+auto Parser::declaration_macro() -> st::NodePtr {
   must_consume(TokenKind::KW_MACRO, "macro declaration");
   auto name = parse_identifier();
 
@@ -608,7 +618,7 @@ auto Parser::declaration_macro() -> std::unique_ptr<st::Node> {
   return make_node<st::DeclarationMacro>(std::move(name));
 }
 
-auto Parser::statement() -> std::unique_ptr<st::Node> {
+auto Parser::statement() -> st::NodePtr {
   switch (peek().kind) {
     case TokenKind::SYM_SEMICOLON: return statement_empty();
 
@@ -635,18 +645,18 @@ auto Parser::statement() -> std::unique_ptr<st::Node> {
   }
 }
 
-auto Parser::statement_empty() -> std::unique_ptr<st::Node> {
+auto Parser::statement_empty() -> st::NodePtr {
   must_consume(TokenKind::SYM_SEMICOLON, "expected `;`");
   return make_node<st::StatementEmpty>();
 }
 
-auto Parser::statement_expression() -> std::unique_ptr<st::Node> {
+auto Parser::statement_expression() -> st::NodePtr {
   auto stmt = make_node<st::StatementExpression>(expression());
   must_consume(TokenKind::SYM_SEMICOLON, "expected `;`");
   return stmt;
 }
 
-auto Parser::statement_block() -> std::unique_ptr<st::Node> {
+auto Parser::statement_block() -> st::NodePtr {
   must_consume(TokenKind::SYM_BR_OPEN, "expected `{`");
 
   auto body = std::vector<st::Node>{};
@@ -657,10 +667,10 @@ auto Parser::statement_block() -> std::unique_ptr<st::Node> {
   return make_node<st::StatementBlock>(std::move(body));
 }
 
-auto Parser::statement_circuit() -> std::unique_ptr<st::Node> {
+auto Parser::statement_circuit() -> st::NodePtr {
   must_consume(TokenKind::SYM_DOLLAR_BRACE, "expected `${`");
 
-  auto default_switch = static_cast<std::unique_ptr<st::Node>>(nullptr);
+  auto default_switch = static_cast<st::NodePtr>(nullptr);
   auto body           = std::vector<std::pair<std::string, st::Node>>{};
 
   while (!consume(TokenKind::SYM_BR_CLOSE)) {
@@ -679,7 +689,7 @@ auto Parser::statement_circuit() -> std::unique_ptr<st::Node> {
     std::move(default_switch), std::move(body));
 }
 
-auto Parser::statement_variable() -> std::unique_ptr<st::Node> {
+auto Parser::statement_variable() -> st::NodePtr {
   if (!match(TokenKind::KW_LET, TokenKind::KW_DEF)) {
     throw report("variable declaration", peek().location);
   }
@@ -697,7 +707,7 @@ auto Parser::statement_variable() -> std::unique_ptr<st::Node> {
     std::move(name), std::move(typing), std::move(init), kind);
 }
 
-auto Parser::statement_constant() -> std::unique_ptr<st::Node> {
+auto Parser::statement_constant() -> st::NodePtr {
   must_consume(TokenKind::KW_CONST, "expected `const`");
 
   auto name   = parse_identifier();
@@ -712,17 +722,17 @@ auto Parser::statement_constant() -> std::unique_ptr<st::Node> {
     std::move(name), std::move(typing), std::move(init));
 }
 
-auto Parser::statement_return() -> std::unique_ptr<st::Node> {
+auto Parser::statement_return() -> st::NodePtr {
   must_consume(TokenKind::KW_RETURN, "expected `return`");
 
-  auto cont = static_cast<std::unique_ptr<st::Node>>(nullptr);
+  auto cont = static_cast<st::NodePtr>(nullptr);
 
   if (consume(TokenKind::SYM_SQ_OPEN)) {
     cont = expression();
     must_consume(TokenKind::SYM_SQ_CLOSE, "expected `]`");
   }
 
-  auto value = static_cast<std::unique_ptr<st::Node>>(nullptr);
+  auto value = static_cast<st::NodePtr>(nullptr);
 
   if (!match(TokenKind::SYM_SEMICOLON)) value = expression();
   must_consume(TokenKind::SYM_SEMICOLON, "expected `;`");
@@ -730,14 +740,14 @@ auto Parser::statement_return() -> std::unique_ptr<st::Node> {
   return make_node<st::StatementReturn>(std::move(cont), std::move(value));
 }
 
-auto Parser::statement_switch() -> std::unique_ptr<st::Node> {
+auto Parser::statement_switch() -> st::NodePtr {
   must_consume(TokenKind::KW_SWITCH, "expected `switch`");
   auto label = parse_identifier();
   must_consume(TokenKind::SYM_SEMICOLON, "expected `;`");
   return make_node<st::StatementSwitch>(std::move(label));
 }
 
-auto Parser::statement_itercontrol() -> std::unique_ptr<st::Node> {
+auto Parser::statement_itercontrol() -> st::NodePtr {
   if (!match(TokenKind::KW_BREAK, TokenKind::KW_CONTINUE)) {
     throw report("expected `break` or `continue`", peek().location);
   }
@@ -748,7 +758,7 @@ auto Parser::statement_itercontrol() -> std::unique_ptr<st::Node> {
   return make_node<st::StatementIterationControl>(kind);
 }
 
-auto Parser::statement_if() -> std::unique_ptr<st::Node> {
+auto Parser::statement_if() -> st::NodePtr {
   must_consume(TokenKind::KW_IF, "expected `if`");
   must_consume(TokenKind::SYM_RD_OPEN, "expected `(`");
 
@@ -763,7 +773,7 @@ auto Parser::statement_if() -> std::unique_ptr<st::Node> {
     std::move(cond), std::move(conseq), std::move(altern));
 }
 
-auto Parser::statement_while() -> std::unique_ptr<st::Node> {
+auto Parser::statement_while() -> st::NodePtr {
   must_consume(TokenKind::KW_WHILE, "expected `while`");
 
   must_consume(TokenKind::SYM_RD_OPEN, "expected `(`");
@@ -773,12 +783,12 @@ auto Parser::statement_while() -> std::unique_ptr<st::Node> {
   return make_node<st::StatementWhile>(std::move(cond), statement());
 }
 
-auto Parser::statement_loop() -> std::unique_ptr<st::Node> {
+auto Parser::statement_loop() -> st::NodePtr {
   must_consume(TokenKind::KW_LOOP, "expected `loop`");
   return make_node<st::StatementLoop>(statement());
 }
 
-auto Parser::statement_for() -> std::unique_ptr<st::Node> {
+auto Parser::statement_for() -> st::NodePtr {
   must_consume(TokenKind::KW_FOR, "expected `for`");
 
   must_consume(TokenKind::SYM_RD_OPEN, "expected `(`");
@@ -796,7 +806,7 @@ auto Parser::statement_for() -> std::unique_ptr<st::Node> {
     std::move(init), std::move(cond), std::move(incr), std::move(body));
 }
 
-auto Parser::statement_foreach() -> std::unique_ptr<st::Node> {
+auto Parser::statement_foreach() -> st::NodePtr {
   must_consume(TokenKind::KW_FOREACH, "expected `foreach`");
   must_consume(TokenKind::SYM_RD_OPEN, "expected `(`");
 
@@ -817,7 +827,7 @@ auto Parser::statement_foreach() -> std::unique_ptr<st::Node> {
     iter_kind, std::move(iter), std::move(collec), std::move(body));
 }
 
-auto Parser::statement_match() -> std::unique_ptr<st::Node> {
+auto Parser::statement_match() -> st::NodePtr {
   must_consume(TokenKind::KW_MATCH, "match block");
 
   must_consume(TokenKind::SYM_RD_OPEN, "open matched expression");
@@ -830,29 +840,29 @@ auto Parser::statement_match() -> std::unique_ptr<st::Node> {
   return make_node<st::StatementMatch>();
 }
 
-auto Parser::expression() -> std::unique_ptr<st::Node> {
+auto Parser::expression() -> st::NodePtr {
   if (eof()) { throw report("expected expression", previous().location); }
 
   return precendece(Precedence::ASSIGNMENT);
 }
 
-auto Parser::expression_identifier() -> std::unique_ptr<st::Node> {
+auto Parser::expression_identifier() -> st::NodePtr {
   must_consume(TokenKind::IDENTIFIER, "expected identifier");
-  const auto name = previous().lexeme;
+  auto name = std::string{previous().lexeme};
   return make_node<st::ExpressionIdentifier>(std::move(name));
 }
 
-auto Parser::expression_void() -> std::unique_ptr<st::Node> {
+auto Parser::expression_void() -> st::NodePtr {
   must_consume(TokenKind::KEY_VOID, "expected `void`");
   return make_node<st::ExpressionVoid>();
 }
 
-auto Parser::expression_continuation() -> std::unique_ptr<st::Node> {
+auto Parser::expression_continuation() -> st::NodePtr {
   must_consume(TokenKind::KW_RETURN, "expected `return`");
   return make_node<st::ExpressionContinuation>();
 }
 
-auto Parser::expression_literal() -> std::unique_ptr<st::Node> {
+auto Parser::expression_literal() -> st::NodePtr {
   switch (advance().kind) {
     case TokenKind::BOOL_TRUE: return make_node<st::ExpressionBool>(true);
     case TokenKind::BOOL_FALSE: return make_node<st::ExpressionBool>(false);
@@ -870,23 +880,25 @@ auto Parser::expression_literal() -> std::unique_ptr<st::Node> {
         st::ExpressionRealKeyword::Kind::EULER);
 
     case TokenKind::LITERAL_NAT:
-      return make_node<st::ExpressionNat>(std::stoull(previous().lexeme));
+      return make_node<st::ExpressionNat>(std::stoull(std::string{previous().lexeme}));
 
     case TokenKind::LITERAL_INT:
-      return make_node<st::ExpressionInt>(std::stoll(previous().lexeme));
+      return make_node<st::ExpressionInt>(std::stoll(std::string{previous().lexeme}));
 
     case TokenKind::LITERAL_REAL:
-      return make_node<st::ExpressionReal>(std::stod(previous().lexeme));
+      return make_node<st::ExpressionReal>(std::stod(std::string{previous().lexeme}));
 
     default: throw report("expected literal", previous().location);
   }
 }
 
-auto Parser::expression_char() -> std::unique_ptr<st::Node> {
+auto Parser::expression_char() -> st::NodePtr {
   must_consume(TokenKind::LITERAL_CHAR, "expected character");
 
   auto converter   = std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>>{};
-  auto wide_lexeme = converter.from_bytes(previous().lexeme);
+  auto lexeme      = previous().lexeme;
+  auto wide_lexeme = converter.from_bytes(
+    lexeme.data(), lexeme.data() + lexeme.size());
 
   if (wide_lexeme.size() != 1) {
     throw report("invalid character literal", previous().location);
@@ -895,10 +907,10 @@ auto Parser::expression_char() -> std::unique_ptr<st::Node> {
   return make_node<st::ExpressionChar>(wide_lexeme.at(0));
 }
 
-auto Parser::expression_string() -> std::unique_ptr<st::Node> {
+auto Parser::expression_string() -> st::NodePtr {
   must_consume(TokenKind::LITERAL_STRING, "expected string");
 
-  auto &raw_value = previous().lexeme;
+  auto raw_value = std::string{previous().lexeme};
 
   if (raw_value.size() < 2) {
     throw report("invalid string", previous().location);
@@ -912,7 +924,7 @@ auto Parser::expression_string() -> std::unique_ptr<st::Node> {
   return make_node<st::ExpressionString>(raw_value, parsed);
 }
 
-auto Parser::expression_unary() -> std::unique_ptr<st::Node> {
+auto Parser::expression_unary() -> st::NodePtr {
   if (!match(TokenKind::KW_NOT, TokenKind::SYM_MINUS)) {
     throw report("expected `not` or `-`", peek().location);
   }
@@ -922,8 +934,7 @@ auto Parser::expression_unary() -> std::unique_ptr<st::Node> {
   return make_node<st::ExpressionUnaryOp>(std::move(operand), kind);
 }
 
-auto Parser::expression_binary(std::unique_ptr<st::Node> &&left)
-  -> std::unique_ptr<st::Node> {
+auto Parser::expression_binary(st::NodePtr &&left) -> st::NodePtr {
   auto tok   = advance();
   auto kind  = static_cast<st::ExpressionBinaryOp::Kind>(tok.kind);
   auto rule  = get_rule(tok);
@@ -933,7 +944,7 @@ auto Parser::expression_binary(std::unique_ptr<st::Node> &&left)
     std::move(left), std::move(right), kind);
 }
 
-auto Parser::expression_tuple() -> std::unique_ptr<st::Node> {
+auto Parser::expression_tuple() -> st::NodePtr {
   auto contents = std::vector<st::Node>{};
 
   must_consume(TokenKind::SYM_RD_OPEN, "expected `(`");
@@ -947,20 +958,19 @@ auto Parser::expression_tuple() -> std::unique_ptr<st::Node> {
   }
 
   if (contents.size() == 1) {
-    return std::make_unique<st::Node>(std::move(contents.back()));
+    return _arena->make(std::move(contents.back()));
   } else {
     return make_node<st::ExpressionTuple>(std::move(contents));
   }
 }
 
-auto Parser::expression_range(std::unique_ptr<st::Node> &&left)
-  -> std::unique_ptr<st::Node> {
+auto Parser::expression_range(st::NodePtr &&left) -> st::NodePtr {
   must_consume(TokenKind::SYM_DOT_DOT, "expected `..`");
   auto right = expression();
   return make_node<st::ExpressionRange>(std::move(left), std::move(right));
 }
 
-auto Parser::expression_vector() -> std::unique_ptr<st::Node> {
+auto Parser::expression_vector() -> st::NodePtr {
   auto contents = std::vector<st::Node>{};
 
   must_consume(TokenKind::SYM_LT, "expected `<`");
@@ -976,7 +986,7 @@ auto Parser::expression_vector() -> std::unique_ptr<st::Node> {
   return make_node<st::ExpressionVector>(std::move(contents));
 }
 
-auto Parser::expression_array() -> std::unique_ptr<st::Node> {
+auto Parser::expression_array() -> st::NodePtr {
   auto contents = std::vector<st::Node>{};
 
   must_consume(TokenKind::SYM_SQ_OPEN, "expected `[`");
@@ -992,7 +1002,7 @@ auto Parser::expression_array() -> std::unique_ptr<st::Node> {
   return make_node<st::ExpressionArray>(std::move(contents));
 }
 
-auto Parser::expression_dictionary() -> std::unique_ptr<st::Node> {
+auto Parser::expression_dictionary() -> st::NodePtr {
   auto contents = std::vector<std::pair<st::Node, st::Node>>{};
 
   must_consume(TokenKind::SYM_HASH_BRACE, "expected `#{`");
@@ -1014,8 +1024,7 @@ auto Parser::expression_dictionary() -> std::unique_ptr<st::Node> {
   return make_node<st::ExpressionDictionary>(std::move(contents));
 }
 
-auto Parser::expression_assignment(std::unique_ptr<st::Node> &&target)
-  -> std::unique_ptr<st::Node> {
+auto Parser::expression_assignment(st::NodePtr &&target) -> st::NodePtr {
   if (!match(
         TokenKind::SYM_EQUAL,
         TokenKind::SYM_PLUS_EQUAL,
@@ -1033,8 +1042,7 @@ auto Parser::expression_assignment(std::unique_ptr<st::Node> &&target)
     std::move(target), expression(), kind);
 }
 
-auto Parser::expression_call(std::unique_ptr<st::Node> &&target)
-  -> std::unique_ptr<st::Node> {
+auto Parser::expression_call(st::NodePtr &&target) -> st::NodePtr {
   auto args = std::vector<st::Node>{};
 
   must_consume(TokenKind::SYM_RD_OPEN, "expected `(`");
@@ -1050,17 +1058,29 @@ auto Parser::expression_call(std::unique_ptr<st::Node> &&target)
   return make_node<st::ExpressionCall>(std::move(target), std::move(args));
 }
 
-auto Parser::expression_lambda() -> std::unique_ptr<st::Node> {
+auto Parser::expression_lambda() -> st::NodePtr {
   auto [params, return_type] = parse_nameless_function_header();
   auto body                  = parse_function_body();
   return make_node<st::ExpressionLambda>(std::move(params), std::move(body));
 }
 
 auto Parser::parse(Source &&source) noexcept -> Module {
-  _scanner.emplace(source.source);
+  // Every node of the module is allocated from its arena
+  _arena = std::make_unique<st::Arena>();
+
+  // Buffers read ahead are scanned as they are, other files are
+  // scanned in place and streams are read into memory
+  if (source.content) {
+    _scanner.emplace(source.content);
+  } else if (auto mapped = Scanner::map(source.path); mapped) {
+    _scanner.emplace(std::move(mapped.value()));
+  } else {
+    _scanner.emplace(source.source);
+  }
+
   _tokens = std::vector<Token>{_scanner->scan()};
 
-  auto tree = std::vector<std::unique_ptr<st::Node>>{};
+  auto tree = std::vector<st::NodePtr>{};
 
   while (!eof()) {
     try {
@@ -1073,22 +1093,113 @@ auto Parser::parse(Source &&source) noexcept -> Module {
   }
 
   return Module{
-    .path = std::move(source.path),
-    .tree = std::move(tree),
+    .path  = std::move(source.path),
+    .arena = std::move(_arena),
+    .tree  = std::move(tree),
   };
 }
 
+auto Parser::parse_all(
+  const Sources                  &sources,
+  const std::vector<std::size_t> &indices,
+  Parsed                         &modules) -> void {
+  // Sources are independent, each is parsed by a parser of its own
+  for_each_parallel(indices.size(), [&](Parser &parser, std::size_t i) {
+    auto &source = *sources[indices[i]];
+    auto  span   = measure(source.path);
+    auto &mod    = modules[indices[i]].emplace(parser.parse(std::move(source)));
+
+    span.count("tokens", parser._tokens.size());
+    span.count("nodes", mod.arena->size());
+  });
+}
+
+auto Parser::reuse(
+  const ModuleGraph &graph,
+  const Sources     &sources,
+  Parsed            &modules,
+  Fingerprints      &stamps) -> std::vector<std::size_t> {
+  auto paths   = std::vector<std::string>{}; //< Parsing moves them away
+  auto indices = std::unordered_map<std::string, std::size_t>{};
+  auto changed = std::vector<std::size_t>{};
+  auto stale   = std::vector<std::size_t>{};
+
+  for (auto i = std::size_t{0}; i < sources.size(); i++) {
+    stamps[i].source = ModuleCache::fingerprint(*sources[i]);
+    paths.push_back(sources[i]->path);
+    indices.emplace(paths[i], i);
+
+    if (auto interface = _modules->interface(stamps[i].source); interface) {
+      stamps[i].interface = interface.value();
+    } else {
+      changed.push_back(i);
+    }
+  }
+
+  // Sources not built before are parsed first, the modules
+  // importing them are keyed by the interfaces they declare
+  parse_all(sources, changed, modules);
+
+  for (const auto i : changed) {
+    stamps[i].interface = ModuleCache::interface(*modules[i]);
+  }
+
+  for (auto i = std::size_t{0}; i < sources.size(); i++) {
+    auto imports = std::vector<std::uint64_t>{};
+
+    for (auto &import : graph.imports(paths[i])) {
+      if (auto it = indices.find(import); it != indices.end()) {
+        imports.push_back(stamps[it->second].interface);
+      }
+    }
+
+    stamps[i].key = _modules->key(paths[i], stamps[i].source, imports);
+    if (modules[i]) continue;
+
+    if (auto artifact = _modules->load(stamps[i].key); artifact) {
+      modules[i].emplace(Module{
+        .path        = std::move(paths[i]),
+        .arena       = nullptr,
+        .tree        = {},
+        .fingerprint = {},
+        .artifact    = std::move(artifact),
+      });
+    } else {
+      stale.push_back(i);
+    }
+  }
+
+  return stale;
+}
+
 auto Parser::execute(PackageSource &&pkg_src) noexcept -> Package {
-  auto main_mod = parse(std::move(pkg_src.main));
-  auto imports  = std::unordered_map<std::string, Module>{};
+  const auto sources = ordered_sources(pkg_src);
+  auto       modules = Parsed(sources.size());
+  auto       stamps  = Fingerprints(sources.size());
+  auto       stale   = std::vector<std::size_t>{};
+
+  if (_modules) {
+    stale = reuse(pkg_src.graph, sources, modules, stamps);
+  } else {
+    for (auto i = std::size_t{0}; i < sources.size(); i++) stale.push_back(i);
+  }
+
+  parse_all(sources, stale, modules);
+
+  auto imports = std::unordered_map<std::string, Module>{};
+
+  for (auto i = std::size_t{0}; i < modules.size(); i++) {
+    modules[i]->fingerprint = stamps[i];
+    if (i == 0) continue;
 
-  for (auto &[path, src] : pkg_src.sources) {
-    imports.emplace(path, parse(std::move(src)));
+    auto path = modules[i]->path;
+    imports.emplace(std::move(path), std::move(modules[i].value()));
   }
 
   return {
-    .main    = std::move(main_mod),
+    .main    = std::move(modules[0].value()),
     .modules = std::move(imports),
+    .graph   = std::move(pkg_src.graph),
   };
 }
 
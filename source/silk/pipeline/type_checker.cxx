@@ -193,11 +193,13 @@ auto TypeChecker::type_check(Module &) noexcept {
 }
 
 auto TypeChecker::execute(Package &&pkg) noexcept -> Package {
-  type_check(pkg.main);
+  const auto modules = ordered_modules(pkg);
 
-  for (auto &[_, mod] : pkg.modules) {
-    type_check(mod);
-  }
+  for_each_parallel(modules.size(), [&](TypeChecker &checker, std::size_t i) {
+    auto span = measure(modules[i]->path);
+    checker.type_check(*modules[i]);
+    span.count("nodes", checker.visits());
+  });
 
   return std::move(pkg);
 }
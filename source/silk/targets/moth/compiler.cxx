@@ -6,6 +6,7 @@
 #include <cstring>
 #include <limits>
 
+#include <moth/ffi.h>
 #include <moth/file.h>
 #include <moth/macros.h>
 #include <moth/mem.h>
@@ -36,9 +37,13 @@ const std::unordered_map<std::string_view, std::string_view> Compiler::modules =
       "bytes",
 #include <stdsilk/bytes.silk>
     },
+    {
+      "math",
+#include <stdsilk/math.silk>
+    },
 };
 
-auto Compiler::emit(std::uint8_t byte) -> void {
+auto Compiler::emit_byte(std::uint8_t byte) -> void {
   if (_targets.empty()) {
     write_byte(&_program, byte);
   } else {
@@ -46,11 +51,47 @@ auto Compiler::emit(std::uint8_t byte) -> void {
   }
 }
 
+auto Compiler::emit_word(std::uint32_t word) -> void {
+  // Little endian, whatever the host is
+  for (auto i = 0; i < 4; i++) {
+    emit_byte((word >> (8 * i)) & 0xff);
+  }
+}
+
+auto Compiler::emit(std::uint8_t op) -> void {
+  if (_wordcode) {
+    emit_word(op);
+  } else {
+    emit_byte(op);
+  }
+}
+
+auto Compiler::emit(std::uint8_t op, std::uint32_t arg, std::size_t size)
+  -> void {
+  if (!_wordcode) {
+    emit_byte(op);
+    emit_varbyte_arg(arg, size);
+    return;
+  }
+
+  // The high byte goes in a prefix if the word has no room
+  if (arg > WORD_OPERAND_MAX) emit_word(VM_EXT | (arg >> 24) << 8);
+  emit_word(op | (arg & WORD_OPERAND_MAX) << 8);
+}
+
+auto Compiler::emit_operand(std::uint32_t arg, std::size_t size) -> void {
+  if (_wordcode) {
+    emit_word(arg);
+  } else {
+    emit_varbyte_arg(arg, size);
+  }
+}
+
 auto Compiler::emit_varbyte_arg(std::uint32_t arg, std::size_t size) -> void {
   if constexpr (IS_BIG_ENDIAN) arg = SWAP_BYTES(arg);
 
   for (int i = size - 1; i >= 0; i--) {
-    emit((arg >> (8 * i)) & 0xff);
+    emit_byte((arg >> (8 * i)) & 0xff);
   }
 }
 
@@ -58,21 +99,26 @@ auto Compiler::emit_varbyte_op_arg(std::uint8_t base_op, std::uint32_t id)
   -> void {
   constexpr auto BYTE_MAX = std::numeric_limits<std::uint8_t>::max();
 
-  if (id <= BYTE_MAX) {
-    emit(base_op + 0);
-    emit(id & 0xff);
+  // Wordcode only has the first variant
+  if (_wordcode) {
+    emit(base_op, id, 4);
+  } else if (id <= BYTE_MAX) {
+    emit(base_op + 0, id, 1);
   } else if (id <= BYTE_MAX * 2) {
-    emit(base_op + 1);
-    emit_varbyte_arg(id, 2);
+    emit(base_op + 1, id, 2);
   } else if (id <= BYTE_MAX * 3) {
-    emit(base_op + 2);
-    emit_varbyte_arg(id, 3);
+    emit(base_op + 2, id, 3);
   } else {
-    emit(base_op + 3);
-    emit_varbyte_arg(id, 4);
+    emit(base_op + 3, id, 4);
   }
 }
 
+auto Compiler::emit_cached_key(std::uint8_t op, std::string_view key)
+  -> void {
+  emit(op, encode_string(key), 4);
+  emit_operand(encode_inline_cache(), 2);
+}
+
 auto Compiler::get_offset() -> std::uint32_t {
   if (_targets.empty()) {
     return _program.len;
@@ -90,6 +136,8 @@ auto Compiler::get_buffer() -> std::uint8_t * {
 }
 
 auto Compiler::push_scope() -> void {
+  _intrinsics.enter();
+
   if (_targets.empty()) {
     _main_locals.depth++;
   } else {
@@ -114,6 +162,8 @@ auto Compiler::pop_scope() -> void {
     locals.definitions.pop_back();
     emit(VM_POP);
   }
+
+  _intrinsics.leave();
 }
 
 auto Compiler::load_constant(std::uint64_t value) -> void {
@@ -193,28 +243,8 @@ auto Compiler::load_constant(wchar_t value) -> void {
 }
 
 auto Compiler::load_constant(std::string_view str) -> void {
-  // Check if the string is already in the read-only data
-  if (_strings.find(str) != _strings.end()) {
-    load_rodata(_strings[str]);
-    return;
-  }
-
-  // Copy the string into a VM allocated buffer
-  auto c_str = (char *)memory(NULL, 0x0, sizeof(char) * str.size() + 1);
-  memcpy(c_str, str.data(), str.size());
-  c_str[str.size()] = '\0';
-
-  // Make it a VM Value
-  Value value;
-  value.type      = T_STR;
-  value.as.string = c_str;
-
-  // Add the value to the read-only data
-  auto value_id = encode_rodata(value);
-  _strings[str] = value_id;
-  load_rodata(value_id);
+  load_rodata(encode_string(str));
 }
-
 auto Compiler::load_identifier_val(const st::Node &node, std::string_view name)
   -> void {
   // ! URGENT: This function needs implementation
@@ -262,6 +292,7 @@ auto Compiler::define_stack_var(std::string_view name, bool immut) -> bool {
 
   if (locals.depth == -1) return false;
 
+  _intrinsics.bind(name);
   locals.definitions.push_back({name, locals.depth, immut});
   return true;
 }
@@ -280,19 +311,44 @@ auto Compiler::get_stack_var(std::string_view name)
 }
 
 auto Compiler::load_stack_var(std::uint16_t slot) -> void {
-  emit(VM_PSH);
-  emit_varbyte_arg(slot, 2);
+  emit(VM_PSH, slot, 2);
 }
 
 auto Compiler::store_stack_var(std::uint16_t slot) -> void {
-  emit(VM_STR);
-  emit_varbyte_arg(slot, 2);
+  emit(VM_STR, slot, 2);
 }
 
 auto Compiler::encode_rodata(Value value) -> std::uint32_t {
   return write_rodata(&_program, value);
 }
 
+auto Compiler::encode_string(std::string_view str) -> std::uint32_t {
+  // Check if the string is already in the read-only data, the
+  // VM relies on equal constant strings sharing their buffer
+  if (_strings.find(str) != _strings.end()) { return _strings[str]; }
+
+  // Copy the string into a VM allocated buffer
+  auto c_str = (char *)memory(NULL, 0x0, sizeof(char) * str.size() + 1);
+  memcpy(c_str, str.data(), str.size());
+  c_str[str.size()] = '\0';
+
+  // Make it a VM Value
+  Value value;
+  value.type      = T_STR;
+  value.as.string = c_str;
+
+  // Add the value to the read-only data
+  auto value_id = encode_rodata(value);
+  _strings[str] = value_id;
+  return value_id;
+}
+
+auto Compiler::encode_inline_cache() -> std::uint16_t {
+  // Sites sharing a cache after wrapping around
+  // only cost misses, caches are always checked
+  return _inline_caches++;
+}
+
 auto Compiler::load_rodata(std::uint32_t id) -> void {
   emit_varbyte_op_arg(VM_VAL, id);
 }
@@ -329,34 +385,91 @@ auto Compiler::assign_symbol(std::uint32_t id) -> void {
   emit_varbyte_op_arg(VM_ASN, id);
 }
 
-auto Compiler::jmp_insert(std::uint8_t jmp_type) -> std::uint32_t {
-  // Emit the jmp byte
-  emit(jmp_type);
+auto Compiler::extern_signature(const st::DeclarationExternFunction &data)
+  -> std::optional<std::string> {
+  // Map a typing onto its FFI signature character,
+  // see `ObjectFFINative` in moth/ffi.h
+  const auto ffi_type = [](const st::Typing &typing) -> char {
+    if (typing.name == "int") return 'i';
+    if (typing.name == "real") return 'r';
+    if (typing.name == "str") return 's';
+    if (typing.name == "ffiptr") return 'p';
+    return '\0';
+  };
+
+  if (data.params.size() > MOTH_FFI_MAX_TYPED_ARGS) return std::nullopt;
 
-  // ... and a bit of padding for later
-  emit(0x0);
-  emit(0x0);
+  auto sig = std::string{};
+
+  if (!data.return_type || data.return_type.name == "void") {
+    sig.push_back('v');
+  } else if (auto type = ffi_type(data.return_type)) {
+    sig.push_back(type);
+  } else {
+    return std::nullopt;
+  }
+
+  for (const auto &[_, typing] : data.params) {
+    auto type = ffi_type(typing);
+    if (!type) return std::nullopt;
+    sig.push_back(type);
+  }
+
+  return sig;
+}
+
+auto Compiler::intrinsic_op(Intrinsic intrinsic) -> std::uint8_t {
+  switch (intrinsic) {
+    case Intrinsic::SQRT: return VM_SQT;
+    case Intrinsic::FLOOR: return VM_FLR;
+    case Intrinsic::ABS: return VM_ABS;
+    case Intrinsic::SIN: return VM_SIN;
+    case Intrinsic::COS: return VM_COS;
+    case Intrinsic::EXP: return VM_EXP;
+    case Intrinsic::LOG: return VM_LOG;
+    case Intrinsic::MIN: return VM_MIN;
+    case Intrinsic::MAX: return VM_MAX;
+  }
+
+  return VM_NOP;
+}
+
+auto Compiler::jmp_insert(std::uint8_t jmp_type) -> std::uint32_t {
+  // Emit the jmp with an offset of 0 for later
+  emit(jmp_type, 0x0, 2);
 
   // Return the current position in the bytecode
   // buffer for patching the jump later
   return get_offset();
 }
 
+auto Compiler::jmp_patch(std::uint32_t insc, std::uint32_t jmp_size)
+  -> void {
+  auto buffer = get_buffer();
+
+  // Patch our jump offset back into the operand we left
+  // earlier in `Compiler::jmp_insert`, in wordcode the
+  // operand is the top 3 bytes of the word
+  if (_wordcode) {
+    jmp_size &= WORD_OPERAND_MAX;
+    buffer[insc - 1] = (jmp_size >> 16) & 0xff;
+    buffer[insc - 2] = (jmp_size >> 8) & 0xff;
+    buffer[insc - 3] = (jmp_size >> 0) & 0xff;
+  } else {
+    buffer[insc - 1] = (jmp_size >> 0) & 0xff;
+    buffer[insc - 2] = (jmp_size >> 8) & 0xff;
+  }
+}
+
 auto Compiler::jmp_finish(std::uint32_t insc) -> void {
   // Calculate the difference between the jump and
   // current instruction
-  std::uint16_t jmp_size = get_offset() - insc;
+  auto jmp_size = get_offset() - insc;
 
   // If we don't jump we can keep those 0's as padding
   if (jmp_size == 0) return;
 
-  // Make sure our jump size is little endian
-  if constexpr (IS_BIG_ENDIAN) jmp_size = SWAP_BYTES(jmp_size);
-
-  // Patch our jump offset back into the padding we left earlier
-  // in `Compiler::jmp_insert`
-  get_buffer()[insc - 1] = (jmp_size >> 0) & 0xff;
-  get_buffer()[insc - 2] = (jmp_size >> 8) & 0xff;
+  jmp_patch(insc, jmp_size);
 }
 
 auto Compiler::logical_or(st::Node &left, st::Node &right) -> void {
@@ -403,7 +516,8 @@ auto Compiler::handle(st::Node &, st::ModuleDeclaration &) -> void {
 auto Compiler::handle(st::Node &, st::ModuleImport &) -> void {
 }
 
-auto Compiler::handle(st::Node &, st::DeclarationFunction &) -> void {
+auto Compiler::handle(st::Node &, st::DeclarationFunction &data) -> void {
+  _intrinsics.bind(data.name);
 }
 
 auto Compiler::handle(st::Node &, st::DeclarationEnum &) -> void {
@@ -412,10 +526,36 @@ auto Compiler::handle(st::Node &, st::DeclarationEnum &) -> void {
 auto Compiler::handle(st::Node &, st::DeclarationObject &) -> void {
 }
 
-auto Compiler::handle(st::Node &, st::DeclarationExternLibrary &) -> void {
+auto Compiler::handle(st::Node &, st::DeclarationExternLibrary &data)
+  -> void {
+  // The library stays on the stack while its functions are loaded
+  emit(VM_DLL, encode_symbol(data.name), 4);
+
+  for (auto &child : data.children) {
+    handle_node(child);
+  }
+
+  emit(VM_POP);
 }
 
-auto Compiler::handle(st::Node &, st::DeclarationExternFunction &) -> void {
+auto Compiler::handle(st::Node &, st::DeclarationExternFunction &data)
+  -> void {
+  auto symbol = encode_symbol(data.name);
+
+  // Fully typed functions are loaded with their signature so the
+  // VM can call them through a typed trampoline, everything else
+  // uses the generic FFI calling convention
+  if (auto sig = extern_signature(data)) {
+    auto signature = std::string_view{*_signatures.insert(*sig).first};
+    _natives[data.name] = signature;
+
+    load_constant(signature);
+    emit(VM_FFT, symbol, 4);
+  } else {
+    emit(VM_FFN, symbol, 4);
+  }
+
+  define_symbol(symbol);
 }
 
 auto Compiler::handle(st::Node &, st::DeclarationMacro &) -> void {
@@ -449,13 +589,16 @@ auto Compiler::handle(st::Node &node, st::StatementCircuit &) -> void {
 }
 
 auto Compiler::handle(st::Node &node, st::StatementVariable &data) -> void {
+  _intrinsics.bind(data.name);
+
   // evaluate_expression(node.init());
   // if (!define_stack_var(node.name(), node.immut())) {
   //   throw report(node.init().location(), "cannot define variable");
   // }
 }
 
-auto Compiler::handle(st::Node &node, st::StatementConstant &) -> void {
+auto Compiler::handle(st::Node &node, st::StatementConstant &data) -> void {
+  _intrinsics.bind(data.name);
 }
 
 auto Compiler::handle(st::Node &node, st::StatementReturn &data) -> void {
@@ -510,11 +653,8 @@ auto Compiler::handle(st::Node &node, st::StatementWhile &data) -> void {
 
   handle_node(*data.child);
 
-  emit(VM_JBW);
-
-  auto dist = get_offset() + 2 - clause;
-  emit((dist >> 8) & 0xff);
-  emit((dist >> 0) & 0xff);
+  auto back = jmp_insert(VM_JBW);
+  jmp_patch(back, back - clause);
 
   jmp_finish(out);
 
@@ -612,6 +752,15 @@ auto Compiler::handle(st::Node &node, st::ExpressionBinaryOp &data) -> void {
     return;
   }
 
+  // Indexing with a constant key is cached by the instruction
+  if (data.kind == data.INDEX && !_assignment_context) {
+    if (auto key = std::get_if<st::ExpressionString>(&data.right->data)) {
+      handle_node(*data.left);
+      emit_cached_key(VM_IDK, key->value);
+      return;
+    }
+  }
+
   // Push both expressions
   handle_node(*data.left);
   handle_node(*data.right);
@@ -665,7 +814,7 @@ auto Compiler::handle(st::Node &node, st::ExpressionVector &data) -> void {
 
 auto Compiler::handle(st::Node &node, st::ExpressionArray &data) -> void {
   // Create a new array on the stack
-  emit(VM_ARR);
+  emit(VM_ARR, 0x0, 1);
 
   // Push each element of the array, along with it's index
   // and then perform an index assignment
@@ -678,7 +827,7 @@ auto Compiler::handle(st::Node &node, st::ExpressionArray &data) -> void {
 
 auto Compiler::handle(st::Node &node, st::ExpressionDictionary &data) -> void {
   // Create a new dictionary on the stack
-  emit(VM_DCT);
+  emit(VM_DCT, 0x0, 1);
 
   // Push each value of the dictonary, along with it's key
   // and then perform an index assignment
@@ -690,21 +839,140 @@ auto Compiler::handle(st::Node &node, st::ExpressionDictionary &data) -> void {
 }
 
 auto Compiler::handle(st::Node &node, st::ExpressionAssignment &data) -> void {
+  // Assigning to a constant key is cached by the instruction
+  auto index = std::get_if<st::ExpressionBinaryOp>(&data.assignee->data);
+
+  if (index && index->kind == st::ExpressionBinaryOp::INDEX &&
+      data.kind == st::ExpressionAssignment::ASSIGN) {
+    if (auto key = std::get_if<st::ExpressionString>(&index->right->data)) {
+      handle_node(*index->left);
+      handle_node(*data.child);
+      emit_cached_key(VM_IAK, key->value);
+      return;
+    }
+  }
+
   _assignment_context = true;
   handle_node(*data.assignee);
   _assignment_context = false;
   handle_node(*data.child);
 }
 
+auto Compiler::invoke_method(st::ExpressionCall &data) -> bool {
+  auto index = std::get_if<st::ExpressionBinaryOp>(&data.callee->data);
+  if (!index || index->kind != st::ExpressionBinaryOp::INDEX) return false;
+
+  // Only constant keys can be cached by the call site
+  auto key = std::get_if<st::ExpressionString>(&index->right->data);
+  if (!key) return false;
+
+  handle_node(*index->left);
+
+  emit(VM_INV, data.children.size(), 1);
+  emit_operand(encode_string(key->value), 4);
+  emit_operand(encode_inline_cache(), 2);
+  return true;
+}
+
+auto Compiler::native_type(const st::Node &arg) -> char {
+  constexpr auto LARGEST_INT = std::numeric_limits<std::int64_t>::max();
+
+  // Only literals have a type before the type checker runs
+  if (auto nat = std::get_if<st::ExpressionNat>(&arg.data)) {
+    return nat->value <= static_cast<std::uint64_t>(LARGEST_INT) ? 'i' : '\0';
+  }
+
+  if (std::holds_alternative<st::ExpressionInt>(arg.data)) return 'i';
+  if (std::holds_alternative<st::ExpressionReal>(arg.data)) return 'r';
+  if (std::holds_alternative<st::ExpressionRealKeyword>(arg.data)) return 'r';
+  if (std::holds_alternative<st::ExpressionString>(arg.data)) return 's';
+  return '\0';
+}
+
+auto Compiler::native_arg(st::Node &arg, char param) -> void {
+  // Numbers are given the parameter's type here, not by the VM
+  if (auto nat = std::get_if<st::ExpressionNat>(&arg.data)) {
+    if (param == 'r') {
+      load_constant(static_cast<double>(nat->value));
+    } else {
+      load_constant(static_cast<std::int64_t>(nat->value));
+    }
+
+    return;
+  }
+
+  auto integer = std::get_if<st::ExpressionInt>(&arg.data);
+
+  if (integer && param == 'r') {
+    load_constant(static_cast<double>(integer->value));
+  } else {
+    handle_node(arg);
+  }
+}
+
+auto Compiler::call_native(st::ExpressionCall &data) -> bool {
+  auto callee = std::get_if<st::ExpressionIdentifier>(&data.callee->data);
+  if (!callee || get_stack_var(callee->name).second >= 0) return false;
+
+  auto native = _natives.find(callee->name);
+  if (native == _natives.end()) return false;
+
+  // The first character of the signature is the return type
+  const auto signature = native->second;
+  const auto params    = signature.substr(1);
+
+  // Integers are passed to real parameters as reals, pointers
+  // are boxed & always checked by the function
+  const auto typed = [&](char param, const st::Node &arg) {
+    const auto type = native_type(arg);
+    return param != 'p' && (type == param || (param == 'r' && type == 'i'));
+  };
+
+  const auto call_typed =
+    data.children.size() == params.size() &&
+    std::equal(params.begin(), params.end(), data.children.begin(), typed);
+
+  for (std::size_t i = 0; i < data.children.size(); i++) {
+    if (call_typed) {
+      native_arg(data.children[i], params[i]);
+    } else {
+      handle_node(data.children[i]);
+    }
+  }
+
+  load_symbol(_symbols[callee->name]);
+
+  // Arguments of any other type are checked by the function
+  if (call_typed) {
+    emit(VM_NTV, data.children.size(), 1);
+    emit_operand(encode_string(signature), 4);
+  } else {
+    emit(VM_CAL, data.children.size(), 1);
+  }
+
+  return true;
+}
+
 auto Compiler::handle(st::Node &node, st::ExpressionCall &data) -> void {
-  // for (auto &arg : call.args()) {
-  //   evaluate_expression(arg);
-  // }
+  // Typed extern functions are called with their signature
+  if (call_native(data)) return;
+
+  for (auto &arg : data.children) {
+    handle_node(arg);
+  }
 
-  // evaluate_expression(call.target());
+  // Calls into std/math are a single instruction
+  if (auto intrinsic = _intrinsics.lookup(data)) {
+    emit(intrinsic_op(*intrinsic));
+    return;
+  }
+
+  // Method calls look up and call the function at once
+  if (invoke_method(data)) return;
 
-  // emit(VM_CAL);
-  // emit((std::uint8_t)call.args().size());
+  handle_node(*data.callee);
+
+  emit(VM_CAL, data.children.size(), 1);
 }
 
 auto Compiler::handle(st::Node &node, st::ExpressionLambda &data) -> void {
@@ -749,19 +1017,59 @@ auto Compiler::add_breakpoint(size_t) noexcept -> void {
 auto Compiler::add_breakpoint(std::string) noexcept -> void {
 }
 
+auto Compiler::compile_module(Module &module) -> void {
+  auto       span    = measure(module.path);
+  const auto code    = _program.len;
+  const auto rodata  = _program.rod.len;
+  const auto visited = visits();
+
+  // The same scan as the optimizer's, so both agree on every call
+  _intrinsics.scan(module.tree);
+
+  try {
+    for (auto &node : module.tree) {
+      handle_node(*node);
+    }
+  } catch (const Error &) {
+    // Already reported, the rest of the module is skipped
+  }
+
+  // Functions are compiled into constants of their own
+  auto bytes = std::uint64_t{_program.len - code};
+
+  for (auto i = rodata; i < _program.rod.len; i++) {
+    if (IS_OBJ_FCT(_program.rod.arr[i])) {
+      bytes += OBJ_FCT(_program.rod.arr[i].as.object)->len;
+    }
+  }
+
+  span.count("nodes", visits() - visited);
+  span.count("bytecode bytes", bytes);
+  span.count("rodata entries", _program.rod.len - rodata);
+}
+
 auto Compiler::execute(Package &&pkg) noexcept -> Program {
   // Initialize the program with
   // 0 instructions, rodata or symbols
   init_program(&_program, 0, 0, 0);
+  _program.wcd = _wordcode;
+
+  // Imported modules run before the modules importing them
+  auto modules = ordered_modules(pkg);
+  modules.erase(modules.begin());
+  pkg.graph.sort(modules);
 
-  // try {
-  //   // Execute every declaration
-  //   for (auto &node : ast) {
-  //     execute_statement(node);
-  //   }
-  // } catch (...) {}
+  for (auto *module : modules) {
+    compile_module(*module);
+  }
 
-  return _program;
+  compile_module(pkg.main);
+  emit(VM_FIN);
+
+  // The caller owns the program from now on
+  auto program = _program;
+  init_program(&_program, 0, 0, 0);
+  return program;
 }
 
 } // namespace moth
@@ -0,0 +1,354 @@
+#include <silk/tools/server.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <sstream>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <silk/utility/build_id.h>
+
+#ifndef _WIN32
+  #include <csignal>
+  #include <sys/socket.h>
+  #include <sys/stat.h>
+  #include <sys/time.h>
+  #include <sys/un.h>
+  #include <unistd.h>
+#endif
+
+namespace silk {
+
+namespace fs = std::filesystem;
+
+#ifdef _WIN32
+
+auto Server::default_path() -> std::optional<std::string> {
+  return std::nullopt;
+}
+
+auto Server::run(const Handler &) -> int {
+  print_error(std::cerr, "the server is not supported on this platform");
+  return 1;
+}
+
+auto Server::forward(
+  const std::string &, int, const char **, std::ostream &, std::ostream &)
+  -> std::optional<int> {
+  return std::nullopt;
+}
+
+#else
+
+// Messages are a count of strings followed by the strings, every
+// number is 32 bits wide and both ends run on the same machine
+using Message = std::vector<std::string>;
+
+using Clock    = std::chrono::steady_clock;
+using Deadline = Clock::time_point;
+
+// Requests and their acceptance are exchanged within this time,
+// a client not accepted in time builds by itself
+constexpr auto EXCHANGE_TIMEOUT = std::chrono::seconds{2};
+
+// Builds taking longer are assumed stuck, their clients build by
+// themselves instead of waiting any longer
+constexpr auto BUILD_TIMEOUT = std::chrono::minutes{10};
+
+// Largest messages either end accepts, in bytes
+constexpr auto MAX_REQUEST = std::uint32_t{1} << 20;
+constexpr auto MAX_REPLY   = std::uint32_t{1} << 30;
+
+// Sent as soon as the server takes up a request
+const auto ACCEPTED = Message{"accepted"};
+
+#ifdef MSG_NOSIGNAL
+constexpr auto SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr auto SEND_FLAGS = 0;
+#endif
+
+// Blocking reads & writes on the socket fail after waiting this long
+static auto set_timeout(int fd, std::chrono::seconds timeout) -> bool {
+  auto tv    = timeval{};
+  tv.tv_sec  = (time_t)timeout.count();
+  tv.tv_usec = 0;
+
+  return ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == 0 &&
+         ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) == 0;
+}
+
+static auto write_all(int fd, const void *data, std::size_t len,
+                      Deadline deadline) -> bool {
+  for (auto *ptr = (const char *)data; len;) {
+    if (Clock::now() > deadline) return false;
+
+    const auto written = ::send(fd, ptr, len, SEND_FLAGS);
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) return false;
+
+    ptr += written;
+    len -= written;
+  }
+
+  return true;
+}
+
+static auto read_all(int fd, void *data, std::size_t len, Deadline deadline)
+  -> bool {
+  for (auto *ptr = (char *)data; len;) {
+    if (Clock::now() > deadline) return false;
+
+    const auto got = ::read(fd, ptr, len);
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) return false;
+
+    ptr += got;
+    len -= got;
+  }
+
+  return true;
+}
+
+static auto send(int fd, const Message &message, Deadline deadline) -> bool {
+  auto count = (std::uint32_t)message.size();
+  if (!write_all(fd, &count, sizeof(count), deadline)) return false;
+
+  for (auto &part : message) {
+    auto len = (std::uint32_t)part.size();
+    if (!write_all(fd, &len, sizeof(len), deadline)) return false;
+    if (!write_all(fd, part.data(), part.size(), deadline)) return false;
+  }
+
+  return true;
+}
+
+// Nothing is allocated before it is known to fit in `limit` bytes
+static auto receive(int fd, std::uint32_t limit, Deadline deadline)
+  -> std::optional<Message> {
+  auto count = std::uint32_t{0};
+  if (!read_all(fd, &count, sizeof(count), deadline)) return std::nullopt;
+
+  // Every string takes at least the bytes of its length
+  auto left = limit;
+  if (count > left / sizeof(std::uint32_t)) return std::nullopt;
+
+  auto message = Message(count);
+
+  for (auto &part : message) {
+    auto len = std::uint32_t{0};
+    if (!read_all(fd, &len, sizeof(len), deadline)) return std::nullopt;
+
+    left -= sizeof(len);
+    if (len > left) return std::nullopt;
+    left -= len;
+
+    part.resize(len);
+    if (!read_all(fd, part.data(), len, deadline)) return std::nullopt;
+  }
+
+  return message;
+}
+
+// Only processes of the same user are talked to, whatever the
+// permissions of the socket and of the directory it is in
+static auto same_user(int fd) -> bool {
+#ifdef SO_PEERCRED
+  auto cred = ucred{};
+  auto len  = socklen_t{sizeof(cred)};
+
+  if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0) {
+    return false;
+  }
+
+  return cred.uid == ::getuid();
+#else
+  auto uid = uid_t{};
+  auto gid = gid_t{};
+
+  if (::getpeereid(fd, &uid, &gid) < 0) return false;
+  return uid == ::getuid();
+#endif
+}
+
+// Fills in the address of the socket, paths that
+// do not fit in it can not be used as a socket
+static auto address(const std::string &path, sockaddr_un &addr) -> bool {
+  if (path.size() >= sizeof(addr.sun_path)) return false;
+
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+// Connected socket, or -1 when no server of this user listens at
+// the path, nothing is ever sent to a server of another user
+static auto connect_to(const std::string &path) -> int {
+  auto addr = sockaddr_un{};
+  if (!address(path, addr)) return -1;
+
+  const auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+
+  if (::connect(fd, (const sockaddr *)&addr, sizeof(addr)) < 0 ||
+      !same_user(fd)) {
+    ::close(fd);
+    return -1;
+  }
+
+#ifdef SO_NOSIGPIPE
+  // A server going away must not take the client with it
+  const auto on = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+  return fd;
+}
+
+auto Server::default_path() -> std::optional<std::string> {
+  if (const auto path = std::getenv("SILK_SERVER_SOCKET")) return path;
+
+  if (const auto dir = std::getenv("XDG_RUNTIME_DIR")) {
+    return (fs::path{dir} / "silk.sock").string();
+  }
+
+  return fmt_function("/tmp/silk-{}.sock", ::getuid());
+}
+
+auto Server::run(const Handler &handler) -> int {
+  // Clients that went away must not take the server with them
+  std::signal(SIGPIPE, SIG_IGN);
+
+  auto addr = sockaddr_un{};
+
+  if (!address(_path, addr)) {
+    print_error(std::cerr, "socket path '{}' is too long", _path);
+    return 1;
+  }
+
+  if (const auto other = connect_to(_path); other >= 0) {
+    ::close(other);
+    print_error(std::cerr, "a server is already listening on '{}'", _path);
+    return 1;
+  }
+
+  // Left behind by a server that did not exit cleanly
+  ::unlink(_path.c_str());
+
+  const auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+  if (fd < 0 || ::bind(fd, (const sockaddr *)&addr, sizeof(addr)) < 0 ||
+      ::chmod(_path.c_str(), 0600) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+    print_error(std::cerr, "could not listen on '{}': {}", _path,
+                std::strerror(errno));
+    if (fd >= 0) ::close(fd);
+    return 1;
+  }
+
+  while (true) {
+    const auto client = ::accept(fd, nullptr, nullptr);
+
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      print_error(std::cerr, "could not accept: {}", std::strerror(errno));
+      break;
+    }
+
+    // Clients of other users and clients that do not send their
+    // request in time are dropped, clients of another build of
+    // the compiler compile by themselves
+    const auto deadline = Clock::now() + EXCHANGE_TIMEOUT;
+
+    auto request = same_user(client) && set_timeout(client, EXCHANGE_TIMEOUT)
+                     ? receive(client, MAX_REQUEST, deadline)
+                     : std::nullopt;
+
+    if (!request || request->size() < 2 || (*request)[0] != build_id() ||
+        !send(client, ACCEPTED, deadline)) {
+      ::close(client);
+      continue;
+    }
+
+    auto out  = std::ostringstream{};
+    auto err  = std::ostringstream{};
+    auto code = 1;
+    auto ec   = std::error_code{};
+
+    // Paths in the request are relative to the client
+    fs::current_path((*request)[1], ec);
+
+    if (ec) {
+      print_error(err, "server can not enter '{}'", (*request)[1]);
+    } else {
+      auto argv = std::vector<const char *>{};
+
+      for (auto it = request->begin() + 2; it != request->end(); it++) {
+        argv.push_back(it->c_str());
+      }
+
+      try {
+        code = handler(CLIFlags{(int)argv.size(), argv.data()}, out, err);
+      } catch (const std::exception &ex) {
+        print_error(err, "server failed: {}", ex.what());
+      }
+    }
+
+    send(client, {std::to_string(code), out.str(), err.str()},
+         Clock::now() + EXCHANGE_TIMEOUT);
+    ::close(client);
+  }
+
+  ::close(fd);
+  ::unlink(_path.c_str());
+  return 1;
+}
+
+auto Server::forward(
+  const std::string &path,
+  int                argc,
+  const char       **argv,
+  std::ostream      &out,
+  std::ostream      &err) -> std::optional<int> {
+  const auto fd = connect_to(path);
+  if (fd < 0) return std::nullopt;
+
+  auto ec      = std::error_code{};
+  auto request = Message{
+    std::string{build_id()},
+    fs::current_path(ec).string(),
+  };
+
+  for (auto i = 0; i < argc; i++) {
+    request.emplace_back(argv[i]);
+  }
+
+  // A server busy with another build does not accept in time
+  const auto deadline = Clock::now() + EXCHANGE_TIMEOUT;
+
+  const auto accepted = !ec && set_timeout(fd, EXCHANGE_TIMEOUT) &&
+                        send(fd, request, deadline) &&
+                        receive(fd, MAX_REQUEST, deadline) == ACCEPTED;
+
+  auto reply = accepted && set_timeout(fd, BUILD_TIMEOUT)
+                 ? receive(fd, MAX_REPLY, Clock::now() + BUILD_TIMEOUT)
+                 : std::nullopt;
+
+  ::close(fd);
+
+  if (!reply || reply->size() != 3) return std::nullopt;
+
+  out << (*reply)[1];
+  err << (*reply)[2];
+  return std::atoi((*reply)[0].c_str());
+}
+
+#endif
+
+} // namespace silk
@@ -0,0 +1,12 @@
+#include <silk/utility/build_id.h>
+
+// Generated on every build, see cmake/build_id.cmake
+#include <silk_build_id.h>
+
+namespace silk {
+
+auto build_id() noexcept -> std::string_view {
+  return SILK_BUILD_ID;
+}
+
+} // namespace silk
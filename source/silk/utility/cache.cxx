@@ -0,0 +1,373 @@
+#include <silk/utility/cache.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <system_error>
+#include <vector>
+
+#include <silk/utility/build_id.h>
+#include <silk/utility/cli.h>
+
+namespace silk {
+
+constexpr auto ENTRY_EXTENSION = std::string_view{".silkc"};
+
+// FNV-1a, 64 bits wide so keys practically never collide
+constexpr auto fnv_basis = std::uint64_t{14695981039346656037u};
+constexpr auto fnv_prime = std::uint64_t{1099511628211u};
+
+constexpr auto fnv(std::uint64_t hash, std::string_view bytes) noexcept
+  -> std::uint64_t {
+  for (const auto byte : bytes) {
+    hash ^= (std::uint8_t)byte;
+    hash *= fnv_prime;
+  }
+
+  return hash;
+}
+
+constexpr auto fnv(std::uint64_t hash, std::uint64_t word) noexcept
+  -> std::uint64_t {
+  for (auto i = 0; i < 8; i++) {
+    hash ^= (word >> (8 * i)) & 0xff;
+    hash *= fnv_prime;
+  }
+
+  return hash;
+}
+
+auto CompileCache::default_directory() noexcept -> std::optional<fs::path> {
+  if (const auto dir = std::getenv("SILK_CACHE_DIR")) return fs::path{dir};
+
+#ifdef _WIN32
+  if (const auto dir = std::getenv("LOCALAPPDATA")) {
+    return fs::path{dir} / "silk";
+  }
+#else
+  if (const auto dir = std::getenv("XDG_CACHE_HOME")) {
+    return fs::path{dir} / "silk";
+  }
+
+  if (const auto dir = std::getenv("HOME")) {
+    return fs::path{dir} / ".cache" / "silk";
+  }
+#endif
+
+  return std::nullopt;
+}
+
+auto CompileCache::key(PackageSource &pkg_src, std::uint64_t flags)
+  -> std::uint64_t {
+  auto hash = fnv(fnv_basis, build_id());
+  hash      = fnv(hash, flags);
+
+  for (auto *source : ordered_sources(pkg_src)) {
+    const auto content = read_source(*source);
+
+    // Lengths keep the boundaries between sources unambiguous
+    hash = fnv(hash, (std::uint64_t)source->path.size());
+    hash = fnv(hash, source->path);
+    hash = fnv(hash, (std::uint64_t)content->size());
+    hash = fnv(hash, *content);
+  }
+
+  return hash;
+}
+
+auto CompileCache::entry_path(std::uint64_t key) const -> fs::path {
+  return _directory / fmt_function("{:016x}{}", key, ENTRY_EXTENSION);
+}
+
+auto CompileCache::load(std::uint64_t key) const noexcept
+  -> std::optional<std::string> {
+  if (auto it = _memory.find(key); it != _memory.end()) return it->second;
+
+  const auto path = entry_path(key);
+  auto       file = std::ifstream{path, std::ios::binary};
+  if (!file) return std::nullopt;
+
+  auto content = std::ostringstream{};
+  content << file.rdbuf();
+  if (file.bad()) return std::nullopt;
+
+  // The modification time doubles as the last use for eviction
+  auto ec = std::error_code{};
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+
+  auto artifact = content.str();
+  remember(key, artifact);
+
+  return artifact;
+}
+
+auto CompileCache::store(std::uint64_t key, std::string_view artifact) const
+  noexcept -> bool {
+  if (!write(key, artifact)) return false;
+
+  evict();
+  return true;
+}
+
+auto CompileCache::store(
+  const std::vector<std::pair<std::uint64_t, std::string>> &artifacts) const
+  noexcept -> bool {
+  auto stored = true;
+
+  for (auto &[key, artifact] : artifacts) {
+    stored = write(key, artifact) && stored;
+  }
+
+  evict();
+  return stored;
+}
+
+auto CompileCache::write(std::uint64_t key, std::string_view artifact) const
+  noexcept -> bool {
+  auto ec = std::error_code{};
+  fs::create_directories(_directory, ec);
+  if (ec) return false;
+
+  // Written next to the entry and then renamed over it, so
+  // readers never see a partially written artifact
+  const auto path = entry_path(key);
+  const auto temp = fs::path{path}.concat(
+    fmt_function(".{:08x}.tmp", std::random_device{}()));
+
+  {
+    auto file = std::ofstream{temp, std::ios::binary | std::ios::trunc};
+    file.write(artifact.data(), artifact.size());
+
+    if (!file.flush()) {
+      fs::remove(temp, ec);
+      return false;
+    }
+  }
+
+  fs::rename(temp, path, ec);
+
+  if (ec) {
+    fs::remove(temp, ec);
+    return false;
+  }
+
+  // Stamped like a load, file systems keep coarser times
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+
+  remember(key, artifact);
+  return true;
+}
+
+auto CompileCache::remember(std::uint64_t key, std::string_view artifact) const
+  noexcept -> void {
+  if (!_resident || artifact.size() > _max_size) return;
+
+  if (auto it = _memory.find(key); it != _memory.end()) {
+    _memory_size -= it->second.size();
+    _memory.erase(it);
+  }
+
+  // Dropped all at once, the files are still there to load again
+  if (_memory_size + artifact.size() > _max_size) {
+    _memory.clear();
+    _memory_size = 0;
+  }
+
+  _memory.emplace(key, artifact);
+  _memory_size += artifact.size();
+}
+
+auto CompileCache::evict() const noexcept -> void {
+  struct Entry {
+    fs::path           path;
+    std::uintmax_t     size;
+    fs::file_time_type used;
+  };
+
+  auto entries = std::vector<Entry>{};
+  auto total   = std::uintmax_t{0};
+  auto ec      = std::error_code{};
+
+  for (auto it = fs::directory_iterator{_directory, ec};
+       !ec && it != fs::directory_iterator{};
+       it.increment(ec)) {
+    if (it->path().extension() != ENTRY_EXTENSION) continue;
+
+    auto entry_ec = std::error_code{};
+    auto size     = it->file_size(entry_ec);
+    auto used     = it->last_write_time(entry_ec);
+    if (entry_ec) continue;
+
+    entries.push_back({it->path(), size, used});
+    total += size;
+  }
+
+  if (total <= _max_size) return;
+
+  std::sort(entries.begin(), entries.end(), [](auto &a, auto &b) {
+    return a.used < b.used;
+  });
+
+  // Another process may be evicting at the same time,
+  // entries that are already gone are simply skipped
+  for (auto &entry : entries) {
+    if (total <= _max_size) break;
+    fs::remove(entry.path, ec);
+    total -= entry.size;
+  }
+}
+
+auto ModuleCache::fingerprint(Source &source) -> std::uint64_t {
+  const auto content = read_source(source);
+  return fnv(fnv_basis, *content);
+}
+
+auto ModuleCache::interface(const Module &mod) -> std::uint64_t {
+  auto hash = fnv_basis;
+
+  // Lengths keep the boundaries between names unambiguous
+  const auto text = [&](std::string_view text) {
+    hash = fnv(hash, (std::uint64_t)text.size());
+    hash = fnv(hash, text);
+  };
+
+  const auto fields = [&](const st::TypedFields &fields) {
+    hash = fnv(hash, (std::uint64_t)fields.size());
+
+    for (auto &[name, typing] : fields) {
+      text(name);
+      text(typing.name);
+    }
+  };
+
+  const auto function = [&](const st::Node &node) {
+    if (auto data = std::get_if<st::DeclarationFunction>(&node.data); data) {
+      text(data->name);
+
+      if (auto lambda = std::get_if<st::ExpressionLambda>(&data->child->data);
+          lambda) {
+        fields(lambda->parameters);
+      }
+    } else if (auto data = std::get_if<st::DeclarationExternFunction>(
+                 &node.data);
+               data) {
+      text(data->name);
+      fields(data->params);
+      text(data->return_type.name);
+    }
+  };
+
+  // Every top level declaration is visible to importing modules,
+  // statements and the bodies of functions are not
+  for (auto &ptr : mod.tree) {
+    auto *node = ptr.get();
+
+    while (auto comment = std::get_if<st::Comment>(&node->data)) {
+      if (!comment->child) break;
+      node = comment->child.get();
+    }
+
+    auto &data = node->data;
+    hash       = fnv(hash, (std::uint64_t)data.index());
+
+    if (auto decl = std::get_if<st::ModuleDeclaration>(&data); decl) {
+      text(decl->path);
+    } else if (auto import = std::get_if<st::ModuleImport>(&data); import) {
+      text(import->name);
+      for (auto &name : import->imports) text(name);
+    } else if (auto en = std::get_if<st::DeclarationEnum>(&data); en) {
+      text(en->name);
+      fields(en->variants);
+    } else if (auto obj = std::get_if<st::DeclarationObject>(&data); obj) {
+      text(obj->name);
+      text(obj->super.name);
+      fields(obj->members);
+      for (auto &child : obj->children) function(child);
+    } else if (auto lib = std::get_if<st::DeclarationExternLibrary>(&data);
+               lib) {
+      text(lib->name);
+      for (auto &child : lib->children) function(child);
+    } else if (auto macro = std::get_if<st::DeclarationMacro>(&data); macro) {
+      text(macro->name);
+    } else if (auto var = std::get_if<st::StatementVariable>(&data); var) {
+      text(var->name);
+      text(var->typing.name);
+      hash = fnv(hash, (std::uint64_t)var->kind);
+    } else if (auto cst = std::get_if<st::StatementConstant>(&data); cst) {
+      text(cst->name);
+      text(cst->typing.name);
+    } else {
+      function(*node);
+    }
+  }
+
+  return hash;
+}
+
+auto ModuleCache::interface_key(std::uint64_t source) -> std::uint64_t {
+  // Interfaces only depend on how the compiler parses the source
+  auto hash = fnv(fnv_basis, build_id());
+  hash      = fnv(hash, "interface");
+  return fnv(hash, source);
+}
+
+auto ModuleCache::interface(std::uint64_t source) const
+  -> std::optional<std::uint64_t> {
+  const auto entry = _cache.load(interface_key(source));
+  if (!entry || entry->size() != sizeof(std::uint64_t)) return std::nullopt;
+
+  auto interface = std::uint64_t{0};
+
+  for (auto i = 0; i < 8; i++) {
+    interface |= std::uint64_t{(std::uint8_t)(*entry)[i]} << (8 * i);
+  }
+
+  return interface;
+}
+
+auto ModuleCache::key(
+  const std::string &path,
+  std::uint64_t source,
+  const std::vector<std::uint64_t> &imports) const -> std::uint64_t {
+  auto hash = fnv(fnv_basis, build_id());
+  hash      = fnv(hash, _flags);
+  hash      = fnv(hash, (std::uint64_t)path.size());
+  hash      = fnv(hash, path);
+  hash      = fnv(hash, source);
+  hash      = fnv(hash, (std::uint64_t)imports.size());
+
+  for (const auto interface : imports) {
+    hash = fnv(hash, interface);
+  }
+
+  return hash;
+}
+
+auto ModuleCache::load(std::uint64_t key) const
+  -> std::shared_ptr<const std::string> {
+  auto artifact = _cache.load(key);
+  if (!artifact) return nullptr;
+
+  return std::make_shared<const std::string>(std::move(artifact.value()));
+}
+
+auto ModuleCache::stage(const Module &mod, std::string artifact) -> void {
+  auto interface = std::string(8, '\0');
+
+  for (auto i = 0; i < 8; i++) {
+    interface[i] = (char)(mod.fingerprint.interface >> (8 * i));
+  }
+
+  _staged.emplace_back(interface_key(mod.fingerprint.source), interface);
+  _staged.emplace_back(mod.fingerprint.key, std::move(artifact));
+}
+
+auto ModuleCache::commit() -> void {
+  if (!_staged.empty()) _cache.store(_staged);
+  _staged.clear();
+}
+
+} // namespace silk
@@ -1,5 +1,6 @@
 #include <silk/utility/cli.h>
 
+#include <cstdlib>
 #include <iostream>
 #include <map>
 #include <sstream>
@@ -27,6 +28,20 @@ auto CLIFlags::is_set(Flag flag) const -> bool {
   return _bits.test((size_t)flag);
 }
 
+auto CLIFlags::jobs() const -> std::size_t {
+  return _jobs;
+}
+
+auto CLIFlags::mask() const -> std::uint64_t {
+  // None of these ever change what is compiled
+  const auto ignored = (std::uint64_t{1} << (size_t)Flag::JOBS) |
+                       (std::uint64_t{1} << (size_t)Flag::SERVER) |
+                       (std::uint64_t{1} << (size_t)Flag::TIME_STAGES) |
+                       (std::uint64_t{1} << (size_t)Flag::TIME_JSON);
+
+  return _bits.to_ullong() & ~ignored;
+}
+
 auto CLIFlags::parse(const int argc, const char **argv) -> void {
   const char **arg = argv + 1;
   const char **end = argv + argc;
@@ -47,6 +62,17 @@ auto CLIFlags::parse(const int argc, const char **argv) -> void {
       }
     }
 
+    if (param_found && is_flag(*arg, Flag::JOBS)) {
+      const auto jobs = arg + 1 < end ? std::atol(*(arg + 1)) : 0;
+
+      if (jobs > 0) {
+        _jobs = (std::size_t)jobs;
+        arg++;
+      } else {
+        print_error(std::cout, "'{}' expects a number of jobs", *arg);
+      }
+    }
+
     if (!param_found) {
       print_error(std::cout, "invalid parameter '{}'", *arg);
     }
@@ -81,6 +107,12 @@ constexpr auto CLIFlags::flag_aliases(Flag flag)
     case Flag::RUN: return {"-r", "--run"};
     case Flag::DEBUG: return {"-d", "--debug"};
     case Flag::INTERACTIVE: return {"-i", "--interactive"};
+    case Flag::NO_CACHE: return {"-n", "--no-cache"};
+    case Flag::WORDCODE: return {"-a", "--wordcode"};
+    case Flag::JOBS: return {"-p", "--jobs"};
+    case Flag::SERVER: return {"-s", "--server"};
+    case Flag::TIME_STAGES: return {"-t", "--time-stages"};
+    case Flag::TIME_JSON: return {"-T", "--time-json"};
     default: return {"?", "?"};
   }
 }
@@ -94,6 +126,12 @@ constexpr auto CLIFlags::flag_usage(Flag flag) -> std::string_view {
     case Flag::DEBUG: return "debug the files with the debug tool";
     case Flag::INTERACTIVE: return "open a repl session";
     case Flag::RUN: return "compile and run the source (default behaviour)";
+    case Flag::NO_CACHE: return "always compile, ignoring the compile cache";
+    case Flag::WORDCODE: return "encode instructions as aligned 32 bit words";
+    case Flag::JOBS: return "process modules on up to N threads in parallel";
+    case Flag::SERVER: return "serve compiles from a resident process";
+    case Flag::TIME_STAGES: return "print what each stage and module cost";
+    case Flag::TIME_JSON: return "print what each stage cost as json";
     default: return "error! this should never happen!";
   }
 }
@@ -0,0 +1,296 @@
+#include <silk/utility/profiler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+
+#include <silk/utility/cli.h>
+
+#ifndef _WIN32
+  #include <sys/resource.h>
+#endif
+
+namespace silk {
+
+static auto counting          = std::atomic<bool>{false};
+static auto allocations       = std::atomic<std::uint64_t>{0};
+thread_local std::uint64_t thread_allocations = 0;
+
+static auto process_cpu() noexcept -> double {
+#ifdef _WIN32
+  return (double)std::clock() / CLOCKS_PER_SEC;
+#else
+  auto now = timespec{};
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+#endif
+}
+
+static auto thread_cpu() noexcept -> double {
+#ifdef _WIN32
+  return (double)std::clock() / CLOCKS_PER_SEC;
+#else
+  auto now = timespec{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+#endif
+}
+
+// Highest resident set size of the process so far, in KiB
+static auto peak_rss() noexcept -> std::int64_t {
+#ifdef _WIN32
+  return 0;
+#else
+  auto usage = rusage{};
+  getrusage(RUSAGE_SELF, &usage);
+
+  #ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+  #else
+  return usage.ru_maxrss;
+  #endif
+#endif
+}
+
+Profiler::Span::Span(Profiler *profiler, std::string name, bool stage) :
+    _profiler(profiler), _stage(stage) {
+  _measure.name = std::move(name);
+  _wall         = Clock::now();
+  _cpu          = stage ? process_cpu() : thread_cpu();
+  _peak_rss     = stage ? peak_rss() : 0;
+  _allocs       = stage ? allocations.load() : thread_allocations;
+}
+
+Profiler::Span::Span(Span &&other) noexcept :
+    _profiler(other._profiler),
+    _stage(other._stage),
+    _measure(std::move(other._measure)),
+    _wall(other._wall),
+    _cpu(other._cpu),
+    _peak_rss(other._peak_rss),
+    _allocs(other._allocs) {
+  other._profiler = nullptr;
+}
+
+Profiler::Span::~Span() {
+  if (!_profiler) return;
+
+  const auto wall = std::chrono::duration<double>{Clock::now() - _wall};
+
+  _measure.wall = wall.count();
+  _measure.cpu  = (_stage ? process_cpu() : thread_cpu()) - _cpu;
+
+  if (_stage) {
+    _measure.peak_rss    = peak_rss() - _peak_rss;
+    _measure.allocations = allocations.load() - _allocs;
+  } else {
+    _measure.allocations = thread_allocations - _allocs;
+  }
+
+  _profiler->finish(std::move(_measure), _stage);
+}
+
+auto Profiler::Span::count(std::string_view item, std::uint64_t n) -> void {
+  if (!_profiler) return;
+
+  if (auto it = _measure.items.find(item); it != _measure.items.end()) {
+    it->second += n;
+  } else {
+    _measure.items.emplace(item, n);
+  }
+}
+
+Profiler::Profiler() {
+  counting = true;
+}
+
+Profiler::~Profiler() {
+  counting = false;
+}
+
+auto Profiler::stage(std::string name) -> Span {
+  return Span{this, std::move(name), true};
+}
+
+auto Profiler::module(std::string name) -> Span {
+  return Span{this, std::move(name), false};
+}
+
+auto Profiler::finish(Measurement &&measure, bool stage) -> void {
+  auto lock = std::lock_guard{_mutex};
+
+  // Modules finish before their stage does, they are held
+  // by an open stage at the end until it finishes as well
+  if (_stages.empty() || !_stages.back().name.empty()) {
+    _stages.emplace_back();
+  }
+
+  auto &open = _stages.back();
+
+  if (!stage) {
+    open.modules.push_back(std::move(measure));
+    return;
+  }
+
+  for (auto &mod : open.modules) {
+    for (auto &[item, n] : mod.items) measure.items[item] += n;
+  }
+
+  static_cast<Measurement &>(open) = std::move(measure);
+}
+
+auto Profiler::stages() const -> std::vector<StageProfile> {
+  auto lock   = std::lock_guard{_mutex};
+  auto stages = _stages;
+
+  // Modules of stages that have not finished yet are left out
+  if (!stages.empty() && stages.back().name.empty()) stages.pop_back();
+
+  for (auto &stage : stages) {
+    std::sort(
+      stage.modules.begin(), stage.modules.end(), [](auto &a, auto &b) {
+        return a.name < b.name;
+      });
+  }
+
+  return stages;
+}
+
+auto Profiler::print_table(std::ostream &out) const -> void {
+  const auto stages = this->stages();
+  auto       width  = std::size_t{12};
+
+  for (auto &stage : stages) {
+    width = std::max(width, stage.name.size());
+
+    for (auto &mod : stage.modules) {
+      width = std::max(width, mod.name.size() + 2);
+    }
+  }
+
+  const auto row = [&](const Measurement &measure, bool stage) {
+    auto items = std::string{};
+
+    for (auto &[item, n] : measure.items) {
+      items += fmt_function("{}{}={}", items.empty() ? "" : " ", item, n);
+    }
+
+    out << fmt_function(
+      "{:<{}}  {:>10.3f}  {:>10.3f}  {:>9}  {:>9}  {}\n",
+      (stage ? "" : "  ") + measure.name,
+      width,
+      measure.wall * 1000,
+      measure.cpu * 1000,
+      stage ? std::to_string(measure.peak_rss) : "",
+      measure.allocations,
+      items);
+  };
+
+  out << fmt_function(
+    BOLD "{:<{}}  {:>10}  {:>10}  {:>9}  {:>9}  {}" RESET "\n",
+    "stage",
+    width,
+    "wall ms",
+    "cpu ms",
+    "rss KiB",
+    "allocs",
+    "items");
+
+  for (auto &stage : stages) {
+    row(stage, true);
+    for (auto &mod : stage.modules) row(mod, false);
+  }
+}
+
+// Quoted with the escapes JSON requires
+static auto json_string(std::string_view text) -> std::string {
+  auto quoted = std::string{"\""};
+
+  for (const auto c : text) {
+    switch (c) {
+      case '"': quoted += "\\\""; break;
+      case '\\': quoted += "\\\\"; break;
+      case '\n': quoted += "\\n"; break;
+      case '\t': quoted += "\\t"; break;
+
+      default:
+        if ((unsigned char)c < 0x20) {
+          quoted += fmt_function("\\u{:04x}", (int)c);
+        } else {
+          quoted += c;
+        }
+    }
+  }
+
+  return quoted += '"';
+}
+
+auto Profiler::print_json(std::ostream &out) const -> void {
+  const auto measurement = [&](const Measurement &measure) {
+    out << fmt_function(
+      "\"name\":{},\"wall\":{},\"cpu\":{},\"peak_rss\":{},"
+      "\"allocations\":{},\"items\":{{",
+      json_string(measure.name),
+      measure.wall,
+      measure.cpu,
+      measure.peak_rss,
+      measure.allocations);
+
+    auto first = true;
+
+    for (auto &[item, n] : measure.items) {
+      out << (first ? "" : ",") << json_string(item) << ":" << n;
+      first = false;
+    }
+
+    out << "}";
+  };
+
+  out << "{\"stages\":[";
+
+  auto first_stage = true;
+
+  for (auto &stage : stages()) {
+    out << (first_stage ? "{" : ",{");
+    measurement(stage);
+    out << ",\"modules\":[";
+
+    auto first_module = true;
+
+    for (auto &mod : stage.modules) {
+      out << (first_module ? "{" : ",{");
+      measurement(mod);
+      out << "}";
+      first_module = false;
+    }
+
+    out << "]}";
+    first_stage = false;
+  }
+
+  out << "]}" << std::endl;
+}
+
+} // namespace silk
+
+// Counted only while a profiler exists, every allocation of the
+// compiler goes through these so stages can report how many they made
+auto operator new(std::size_t size) -> void * {
+  if (silk::counting.load(std::memory_order_relaxed)) {
+    silk::allocations.fetch_add(1, std::memory_order_relaxed);
+    silk::thread_allocations++;
+  }
+
+  if (auto *ptr = std::malloc(size ? size : 1)) return ptr;
+  throw std::bad_alloc{};
+}
+
+auto operator delete(void *ptr) noexcept -> void {
+  std::free(ptr);
+}
+
+auto operator delete(void *ptr, std::size_t) noexcept -> void {
+  std::free(ptr);
+}
@@ -0,0 +1,88 @@
+#include <silk/utility/thread_pool.h>
+
+namespace silk {
+
+ThreadPool::ThreadPool(std::size_t jobs) {
+  for (auto i = std::size_t{1}; i < jobs; i++) {
+    _workers.emplace_back([this] { work(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    auto lock = std::lock_guard{_mutex};
+    _stopping = true;
+  }
+
+  _wake.notify_all();
+
+  for (auto &worker : _workers) {
+    worker.join();
+  }
+}
+
+auto ThreadPool::default_jobs() noexcept -> std::size_t {
+  const auto threads = std::thread::hardware_concurrency();
+  return threads ? threads : 1;
+}
+
+auto ThreadPool::jobs() const noexcept -> std::size_t {
+  return _workers.size() + 1;
+}
+
+auto ThreadPool::drain(std::unique_lock<std::mutex> &lock) -> void {
+  const auto *task = _task;
+  _busy++;
+
+  while (_next < _count) {
+    const auto index = _next++;
+
+    lock.unlock();
+    (*task)(index);
+    lock.lock();
+  }
+
+  if (--_busy == 0) _done.notify_all();
+}
+
+auto ThreadPool::work() -> void {
+  auto lock = std::unique_lock{_mutex};
+  auto seen = _generation;
+
+  for (;;) {
+    _wake.wait(lock, [&] { return _stopping || _generation != seen; });
+    if (_stopping) return;
+
+    seen = _generation;
+    drain(lock);
+  }
+}
+
+auto ThreadPool::run(std::size_t count, const Task &task) -> void {
+  if (count == 0) return;
+
+  // Nothing to share, skip the locking altogether
+  if (_workers.empty() || count == 1) {
+    for (auto i = std::size_t{0}; i < count; i++) {
+      task(i);
+    }
+
+    return;
+  }
+
+  auto lock = std::unique_lock{_mutex};
+
+  _task  = &task;
+  _count = count;
+  _next  = 0;
+  _generation++;
+
+  _wake.notify_all();
+  drain(lock);
+
+  // Workers still finishing their last index hold on to the task
+  _done.wait(lock, [&] { return _busy == 0; });
+  _task = nullptr;
+}
+
+} // namespace silk
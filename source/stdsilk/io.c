@@ -10,6 +10,8 @@
 #include <moth/object.h>
 #include <moth/value.h>
 
+MOTH_FFI_LIBRARY;
+
 static const uint32_t FILE_TAG = (STD_SILK_IO_TAG << 16) | 0x0001;
 
 static MOTH_FFI_DELETER_FUN(file_deleter) {
@@ -0,0 +1,335 @@
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <moth/mem.h>
+#include <moth/object.h>
+#include <moth/opcode.h>
+#include <moth/program.h>
+#include <moth/verify.h>
+#include <moth/vm.h>
+
+namespace {
+
+/// Instructions written by hand, bytecode operands are big endian
+/// & the words of wordcode are little endian
+struct Code {
+  std::vector<std::uint8_t> bytes;
+  bool                      wcd = false;
+
+  auto op(std::uint8_t op) -> Code & {
+    bytes.push_back(op);
+    return *this;
+  }
+
+  auto op(std::uint8_t op, std::uint32_t arg, int size) -> Code & {
+    return this->op(op).arg(arg, size);
+  }
+
+  auto arg(std::uint32_t arg, int size) -> Code & {
+    for (int i = size - 1; i >= 0; i--) bytes.push_back(arg >> (8 * i));
+    return *this;
+  }
+
+  auto word(std::uint8_t op, std::uint32_t arg = 0) -> Code & {
+    wcd = true;
+    return operand(op | arg << 8);
+  }
+
+  auto operand(std::uint32_t word) -> Code & {
+    for (int i = 0; i < 4; i++) bytes.push_back(word >> (8 * i));
+    return *this;
+  }
+};
+
+/// A program & the VM it runs on
+struct Machine {
+  Program prog;
+  VM      vm;
+
+  Machine() {
+    init_program(&prog, 0, 0, 0);
+    init_vm(&vm);
+  }
+
+  ~Machine() {
+    free_vm(&vm);
+    free_program(&prog);
+  }
+
+  auto integer(std::int64_t integer) -> std::uint32_t {
+    Value value;
+    value.type       = T_INT;
+    value.as.integer = integer;
+    return write_rodata(&prog, value);
+  }
+
+  auto real(double real) -> std::uint32_t {
+    Value value;
+    value.type    = T_REAL;
+    value.as.real = real;
+    return write_rodata(&prog, value);
+  }
+
+  auto string(const char *str) -> std::uint32_t {
+    Value value;
+    value.type      = T_STR;
+    value.as.string = copy(str);
+    return write_rodata(&prog, value);
+  }
+
+  auto symbol(const char *str) -> std::uint32_t {
+    Symbol sym;
+    sym.hash = hash(str);
+    sym.str  = copy(str);
+    return write_symtable(&prog, sym);
+  }
+
+  auto function(const Code &code) -> std::uint32_t {
+    ObjectFunction *fct = obj_fct_with_len(code.bytes.size());
+    std::memcpy(fct->bytes, code.bytes.data(), code.bytes.size());
+
+    Value value;
+    value.type      = T_OBJ;
+    value.as.object = (Object *)fct;
+    return write_rodata(&prog, value);
+  }
+
+  auto run(const Code &code) -> VMStatus {
+    prog.wcd = code.wcd;
+    for (auto byte : code.bytes) write_byte(&prog, byte);
+    vm_run(&vm, &prog);
+    return vm.st;
+  }
+
+  private:
+  static auto copy(const char *str) -> char * {
+    auto len = std::strlen(str) + 1;
+    return (char *)std::memcpy(memory(NULL, 0x0, len), str, len);
+  }
+};
+
+// C library typed calls are tested with
+#ifdef __APPLE__
+  #define LIBM "libm.dylib"
+#else
+  #define LIBM "libm.so.6"
+#endif
+
+} // namespace
+
+// A breakpoint right after an instruction that fails would
+// overwrite the status if the VM carried on running
+
+TEST_CASE("calls with too few arguments stop the VM", "[moth][vm]") {
+  Machine m;
+
+  // Reads its first argument
+  auto fct = m.function(Code{}.op(VM_PSH, 0, 2).op(VM_RET));
+
+  auto status = m.run(Code{}
+                        .op(VM_VAL, fct, 1)
+                        .op(VM_CAL, 0, 1)
+                        .op(VM_DBG)
+                        .op(VM_POP)
+                        .op(VM_FIN));
+
+  REQUIRE(status == STATUS_INVARG);
+}
+
+TEST_CASE("recursing past the stack stops the VM", "[moth][vm]") {
+  Machine m;
+
+  auto sym = m.symbol("f");
+  auto fct = m.function(Code{}.op(VM_SYM, sym, 1).op(VM_CAL, 0, 1).op(VM_RET));
+
+  auto status = m.run(Code{}
+                        .op(VM_VAL, fct, 1)
+                        .op(VM_DEF, sym, 1)
+                        .op(VM_SYM, sym, 1)
+                        .op(VM_CAL, 0, 1)
+                        .op(VM_DBG)
+                        .op(VM_POP)
+                        .op(VM_FIN));
+
+  REQUIRE(status == STATUS_STKOVF);
+}
+
+TEST_CASE("missing constant keys stop the VM", "[moth][vm]") {
+  Machine m;
+
+  auto key = m.string("a");
+  auto val = m.string("b");
+
+  // The key is stored in one dictionary & read from another
+  SECTION("bytecode") {
+    auto status = m.run(Code{}
+                          .op(VM_DCT, 0, 1)
+                          .op(VM_VAL, val, 1)
+                          .op(VM_IAK, key, 4)
+                          .arg(0, 2)
+                          .op(VM_POP)
+                          .op(VM_DCT, 0, 1)
+                          .op(VM_IDK, key, 4)
+                          .arg(1, 2)
+                          .op(VM_DBG)
+                          .op(VM_POP)
+                          .op(VM_FIN));
+
+    REQUIRE(status == STATUS_INVIDX);
+  }
+
+  SECTION("wordcode") {
+    auto status = m.run(Code{}
+                          .word(VM_DCT)
+                          .word(VM_VAL, val)
+                          .word(VM_IAK, key)
+                          .operand(0)
+                          .word(VM_POP)
+                          .word(VM_DCT)
+                          .word(VM_IDK, key)
+                          .operand(1)
+                          .word(VM_DBG)
+                          .word(VM_POP)
+                          .word(VM_FIN));
+
+    REQUIRE(status == STATUS_INVIDX);
+  }
+}
+
+TEST_CASE("failed method calls stop the VM", "[moth][vm]") {
+  Machine m;
+
+  auto key = m.string("f");
+
+  // The argument is left under the receiver
+  SECTION("missing method") {
+    auto status = m.run(Code{}
+                          .op(VM_TRU)
+                          .op(VM_DCT, 0, 1)
+                          .op(VM_INV, 1, 1)
+                          .arg(key, 4)
+                          .arg(0, 2)
+                          .op(VM_DBG)
+                          .op(VM_POP)
+                          .op(VM_FIN));
+
+    REQUIRE(status == STATUS_INVIDX);
+  }
+
+  SECTION("receiver is not a dictionary") {
+    auto status = m.run(Code{}
+                          .op(VM_TRU)
+                          .op(VM_TRU)
+                          .op(VM_INV, 1, 1)
+                          .arg(key, 4)
+                          .arg(0, 2)
+                          .op(VM_DBG)
+                          .op(VM_POP)
+                          .op(VM_FIN));
+
+    REQUIRE(status == STATUS_INVTYP);
+  }
+}
+
+TEST_CASE("intrinsics without a result stop the VM", "[moth][vm]") {
+  Machine m;
+
+  SECTION("floor of NaN") {
+    auto nan = m.real(std::numeric_limits<double>::quiet_NaN());
+
+    auto status = m.run(Code{}
+                          .op(VM_VAL, nan, 1)
+                          .op(VM_FLR)
+                          .op(VM_DBG)
+                          .op(VM_POP)
+                          .op(VM_FIN));
+
+    REQUIRE(status == STATUS_INVARG);
+  }
+
+  SECTION("absolute value of the smallest integer") {
+    auto min = m.integer(std::numeric_limits<std::int64_t>::min());
+
+    auto status = m.run(Code{}
+                          .op(VM_VAL, min, 1)
+                          .op(VM_ABS)
+                          .op(VM_DBG)
+                          .op(VM_POP)
+                          .op(VM_FIN));
+
+    REQUIRE(status == STATUS_INVARG);
+  }
+}
+
+TEST_CASE("typed calls go straight to the trampoline", "[moth][vm][ffi]") {
+  Machine m;
+
+  auto lib  = m.symbol(LIBM);
+  auto cos  = m.symbol("cos");
+  auto sig  = m.string("rr");
+  auto zero = m.real(0.0);
+
+  auto code = Code{}
+                .op(VM_DLL, lib, 4)
+                .op(VM_VAL, sig, 1)
+                .op(VM_FFT, cos, 4)
+                .op(VM_DEF, cos, 1)
+                .op(VM_POP);
+
+  SECTION("call site compiled against the function") {
+    auto status = m.run(code.op(VM_VAL, zero, 1)
+                          .op(VM_SYM, cos, 1)
+                          .op(VM_NTV, 1, 1)
+                          .arg(sig, 4)
+                          .op(VM_FIN));
+
+    REQUIRE(status == STATUS_OK);
+
+    auto ret = m.vm.stk.vtop[-1];
+    REQUIRE(ret.type == T_REAL);
+    REQUIRE(ret.as.real == 1.0);
+  }
+
+  // An equal signature from another constant can't vouch for
+  // the arguments, they are checked like in any other call
+  SECTION("call site compiled against another function") {
+    auto other = m.string("rr");
+    auto word  = m.string("a");
+
+    auto status = m.run(code.op(VM_VAL, word, 1)
+                          .op(VM_SYM, cos, 1)
+                          .op(VM_NTV, 1, 1)
+                          .arg(other, 4)
+                          .op(VM_DBG)
+                          .op(VM_POP)
+                          .op(VM_FIN));
+
+    REQUIRE(status == STATUS_INVTYP);
+  }
+}
+
+TEST_CASE("unknown instructions are rejected", "[moth][verify]") {
+  Machine m;
+
+  const char *err   = nullptr;
+  auto        check = [&](const Code &code) {
+    m.prog.wcd = code.wcd;
+    for (auto byte : code.bytes) write_byte(&m.prog, byte);
+    return verify_program(&m.prog, &err);
+  };
+
+  SECTION("bytecode") {
+    REQUIRE_FALSE(check(Code{}.op(VM_NTV + 1).op(VM_FIN)));
+    REQUIRE(std::strcmp(err, "unknown instruction") == 0);
+  }
+
+  SECTION("prefix of a prefix") {
+    REQUIRE_FALSE(
+      check(Code{}.word(VM_EXT, 1).word(VM_EXT, 1).word(VM_FIN)));
+    REQUIRE(std::strcmp(err, "unknown instruction") == 0);
+  }
+}